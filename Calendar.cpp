@@ -6,102 +6,366 @@
 
 #include "SimulationObject.h"
 #include "Calendar.h"
+#include "HeapCalendar.h"
+#include "CalendarQueue.h"
 
-bool TimePriorityCmp::operator()(SimulationObjectPtr const& a, SimulationObjectPtr const& b)
+#include <cassert>
+
+std::atomic<CalendarEngine> Calendar::m_defaultEngine(CalendarEngine::BINARY_HEAP);
+
+Calendar::Calendar(CalendarEngine engine)
+    : m_engine(engine), m_owner(nullptr), m_ownerIndex(0), m_sequenceNext(0)
 {
-    return a->GetNextSimTime() > b->GetNextSimTime();
+    //
 }
 
-CalendarPtr Calendar::Create()
+Calendar::~Calendar()
 {
-    auto ptr = std::make_shared<Calendar>();
-    return ptr;
+    // release handles of objects still present in calendar
+    for (auto& slot : m_slots)
+    {
+        if (slot.object)
+            slot.object->m_calendarHandle = CalendarHandle_Invalid;
+    }
 }
 
-bool Calendar::remove(const SimulationObjectPtr obj)
+CalendarPtr Calendar::Create(CalendarEngine engine)
 {
-    // find iterator containing specified object
-    auto it = c.begin();
-    for (; it != c.end(); it++)
+    if (engine == CalendarEngine::DEFAULT)
+        engine = m_defaultEngine;
+
+    switch (engine)
     {
-        if ((*it)->GetGUID() == obj->GetGUID())
-            break;
+        case CalendarEngine::CALENDAR_QUEUE:
+            return std::make_shared<CalendarQueue>();
+        case CalendarEngine::BINARY_HEAP:
+        default:
+            return std::make_shared<HeapCalendar>();
     }
+}
+
+void Calendar::SetDefaultEngine(CalendarEngine engine)
+{
+    // "default" as a default would not make sense
+    if (engine != CalendarEngine::DEFAULT)
+        m_defaultEngine = engine;
+}
+
+CalendarEngine Calendar::GetEngine() const
+{
+    return m_engine;
+}
+
+CalendarHandle Calendar::push(SimulationObjectPtr const& obj)
+{
+    CalendarHandle handle = PushEntry(obj);
+    NotifyHeadChanged();
+
+    return handle;
+}
+
+void Calendar::pop()
+{
+    if (empty())
+        return;
+
+    PopEntry();
+    NotifyHeadChanged();
+}
+
+bool Calendar::remove(const SimulationObjectPtr obj)
+{
+    // the handle is valid only within the calendar the object is scheduled in
+    const CalendarHandle handle = obj->m_calendarHandle;
+    assert(handle < m_slots.size() && m_slots[handle].object == obj);
+    if (handle >= m_slots.size() || m_slots[handle].object != obj)
+        return false;
+
+    return remove(handle);
+}
+
+bool Calendar::remove(CalendarHandle handle)
+{
+    if (!RemoveEntry(handle))
+        return false;
+
+    NotifyHeadChanged();
+    return true;
+}
+
+void Calendar::update(CalendarHandle handle)
+{
+    UpdateEntry(handle);
+    NotifyHeadChanged();
+}
+
+void Calendar::collect(std::vector<CalendarEntry>& entries) const
+{
+    CollectEntries(entries);
+}
+
+SimulationObjectPtr const& Calendar::object_of(CalendarHandle handle) const
+{
+    return m_slots[handle].object;
+}
+
+void Calendar::NotifyHeadChanged()
+{
+    if (m_owner)
+        m_owner->HeadChanged(m_ownerIndex);
+}
+
+SimulationObjectPtr const& Calendar::top() const
+{
+    return m_slots[top_entry().handle].object;
+}
 
-    // if found...
-    if (it != c.end())
+CalendarEntry Calendar::CreateEntry(SimulationObjectPtr const& obj)
+{
+    CalendarHandle handle;
+
+    if (!m_freeHandles.empty())
     {
-        // erase from heap and rebuild it
-        c.erase(it);
-        std::make_heap(c.begin(), c.end(), comp);
-        return true;
+        handle = m_freeHandles.back();
+        m_freeHandles.pop_back();
     }
+    else
+    {
+        handle = static_cast<CalendarHandle>(m_slots.size());
+        m_slots.emplace_back();
+    }
+
+    m_slots[handle].object = obj;
+    obj->m_calendarHandle = handle;
 
-    return false;
+    return { obj->GetNextSimTime(), NextSequence(), handle };
 }
 
-SimulationObjectPtr CalendarList::top() const
+void Calendar::RefreshEntry(CalendarEntry& entry)
 {
-    // select first non-empty calendar
-    auto itr = begin();
-    while (itr != end() && (*itr)->empty())
-        ++itr;
+    entry.time = m_slots[entry.handle].object->GetNextSimTime();
+    entry.sequence = NextSequence();
+}
 
-    if (itr == end())
-        return nullptr;
+uint32_t Calendar::NextSequence()
+{
+    if (m_owner)
+        return m_owner->m_sequenceNext++;
 
-    // current top is "the best" for now
-    SimulationObjectPtr curTop = (*itr)->top();
-    ++itr;
+    return m_sequenceNext++;
+}
+
+void Calendar::ReleaseEntry(CalendarHandle handle)
+{
+    CalendarSlot& slot = m_slots[handle];
+
+    slot.object->m_calendarHandle = CalendarHandle_Invalid;
+    slot.object.reset();
+
+    m_freeHandles.push_back(handle);
+}
+
+CalendarList::CalendarList()
+    : m_nonEmptyCount(0), m_sequenceNext(0)
+{
+    //
+}
+
+CalendarList::~CalendarList()
+{
+    // calendars may outlive the list, so they must not notify it anymore
+    for (auto& cal : m_calendars)
+        cal->m_owner = nullptr;
+}
+
+void CalendarList::push_back(CalendarPtr const& calendar)
+{
+    size_t index = m_calendars.size();
+
+    m_calendars.push_back(calendar);
+    m_heads.push_back({ true, 0, 0 });
+    m_heap.push_back(index);
+    m_heapPositions.push_back(index);
+
+    calendar->m_owner = this;
+    calendar->m_ownerIndex = index;
+
+    // the calendar may already contain some entries
+    HeadChanged(index);
+}
 
-    // go through the rest of calendars and find better
-    while (itr != end())
+bool CalendarList::empty() const
+{
+    return m_calendars.empty();
+}
+
+size_t CalendarList::size() const
+{
+    return m_calendars.size();
+}
+
+CalendarPtr const& CalendarList::front() const
+{
+    return m_calendars.front();
+}
+
+std::vector<CalendarPtr>::const_iterator CalendarList::begin() const
+{
+    return m_calendars.begin();
+}
+
+std::vector<CalendarPtr>::const_iterator CalendarList::end() const
+{
+    return m_calendars.end();
+}
+
+bool CalendarList::IsDominantCalendar(size_t a, size_t b) const
+{
+    // non-empty calendars always dominate the empty ones
+    if (m_heads[a].empty != m_heads[b].empty)
+        return m_heads[b].empty;
+
+    if (m_heads[a].time != m_heads[b].time)
+        return m_heads[a].time < m_heads[b].time;
+
+    // on equal times, the sooner inserted entry wins
+    if (m_heads[a].sequence != m_heads[b].sequence)
+        return static_cast<int32_t>(m_heads[a].sequence - m_heads[b].sequence) < 0;
+
+    return a < b;
+}
+
+bool CalendarList::IsDominant(size_t posA, size_t posB) const
+{
+    return IsDominantCalendar(m_heap[posA], m_heap[posB]);
+}
+
+void CalendarList::SwapPositions(size_t posA, size_t posB)
+{
+    std::swap(m_heap[posA], m_heap[posB]);
+    m_heapPositions[m_heap[posA]] = posA;
+    m_heapPositions[m_heap[posB]] = posB;
+}
+
+void CalendarList::SiftUp(size_t pos)
+{
+    while (pos > 0)
     {
-        if ((*itr)->empty())
-            continue;
+        size_t parent = (pos - 1) / 2;
+        if (!IsDominant(pos, parent))
+            break;
 
-        if ((*itr)->top()->GetNextSimTime() < curTop->GetNextSimTime())
-            curTop = (*itr)->top();
+        SwapPositions(pos, parent);
+        pos = parent;
+    }
+}
 
-        ++itr;
+void CalendarList::SiftDown(size_t pos)
+{
+    while (true)
+    {
+        size_t child = 2 * pos + 1;
+        if (child >= m_heap.size())
+            break;
+
+        if (child + 1 < m_heap.size() && IsDominant(child + 1, child))
+            child++;
+
+        if (!IsDominant(child, pos))
+            break;
+
+        SwapPositions(pos, child);
+        pos = child;
     }
+}
+
+void CalendarList::HeadChanged(size_t index)
+{
+    Calendar* cal = m_calendars[index].get();
+    HeadInfo& head = m_heads[index];
+
+    HeadInfo oldHead = head;
+
+    head.empty = cal->empty();
+    if (!head.empty)
+    {
+        CalendarEntry const& entry = cal->top_entry();
+        head.time = entry.time;
+        head.sequence = entry.sequence;
+    }
+
+    // nothing changed in ordering
+    if (head.empty == oldHead.empty && (head.empty || (head.time == oldHead.time && head.sequence == oldHead.sequence)))
+        return;
+
+    if (head.empty && !oldHead.empty)
+        m_nonEmptyCount--;
+    else if (!head.empty && oldHead.empty)
+        m_nonEmptyCount++;
 
-    return curTop;
+    size_t pos = m_heapPositions[index];
+    SiftUp(pos);
+    SiftDown(m_heapPositions[index]);
 }
 
-void CalendarList::pop()
+CalendarPtr CalendarList::top_calendar() const
+{
+    if (m_nonEmptyCount == 0)
+        return nullptr;
+
+    return m_calendars[m_heap.front()];
+}
+
+SimulationObjectPtr CalendarList::top() const
 {
-    // select first non-empty calendar
-    auto itr = begin();
-    while (itr != end() && (*itr)->empty())
-        ++itr;
+    if (m_nonEmptyCount == 0)
+        return nullptr;
+
+    return m_calendars[m_heap.front()]->top();
+}
 
-    if (itr == end())
+void CalendarList::pop()
+{
+    if (m_nonEmptyCount == 0)
         return;
 
-    // current top is "the best" calendar for now
-    CalendarPtr curTop = (*itr);
-    ++itr;
+    // the calendar notifies the list about its new top
+    m_calendars[m_heap.front()]->pop();
+}
 
-    while (itr != end())
-    {
-        if ((*itr)->empty())
-            continue;
+SimulationObjectPtr CalendarList::pop_top()
+{
+    if (m_nonEmptyCount == 0)
+        return nullptr;
 
-        if ((*itr)->top()->GetNextSimTime() < curTop->top()->GetNextSimTime())
-            curTop = (*itr);
+    Calendar* cal = m_calendars[m_heap.front()].get();
 
-        ++itr;
+    SimulationObjectPtr obj = cal->top();
+    cal->pop();
+
+    return obj;
+}
+
+simtime_t CalendarList::pop_batch(SimulationBatch& batch)
+{
+    if (m_nonEmptyCount == 0)
+        return 0;
+
+    const simtime_t time = m_heads[m_heap.front()].time;
+
+    // the calendar heap keeps the entries ordered by time and sequence number, just drain it
+    while (m_nonEmptyCount > 0 && m_heads[m_heap.front()].time == time)
+    {
+        Calendar* cal = m_calendars[m_heap.front()].get();
+
+        batch.push_back(cal->top());
+        cal->pop();
     }
 
-    curTop->pop();
+    return time;
 }
 
 bool CalendarList::all_empty() const
 {
-    auto itr = begin();
-    while (itr != end() && (*itr)->empty())
-        ++itr;
-
-    return itr == end();
+    return (m_nonEmptyCount == 0);
 }
@@ -8,41 +8,237 @@
 
 #include "Types.h"
 
-#include <queue>
-#include <list>
+#include <vector>
 #include <memory>
+#include <atomic>
+
+class CalendarList;
 
 /*
- * Comparator functor for time-ordered priority queue
+ * Single calendar entry; plain 16-byte structure, so the calendar never touches scheduled objects (nor their
+ * reference counters) when ordering entries
+ */
+struct CalendarEntry
+{
+    // scheduled time
+    simtime_t time;
+    // sequence number of insertion; entries scheduled to the same time are ordered by it (FIFO)
+    uint32_t sequence;
+    // handle of entry; refers to calendar slot with scheduled object
+    CalendarHandle handle;
+};
+
+static_assert(sizeof(CalendarEntry) == 16, "CalendarEntry is expected to be 16 bytes long");
+
+/*
+ * Comparator functor for time-ordered calendar entries; returns true, if entry a is scheduled after entry b
  */
 struct TimePriorityCmp
 {
-    bool operator()(SimulationObjectPtr const& a, SimulationObjectPtr const& b);
+    bool operator()(CalendarEntry const& a, CalendarEntry const& b) const
+    {
+        if (a.time != b.time)
+            return a.time > b.time;
+
+        // sequence numbers are compared with respect to wrap-around
+        return static_cast<int32_t>(a.sequence - b.sequence) > 0;
+    }
+};
+
+/*
+ * Available calendar implementations
+ */
+enum class CalendarEngine
+{
+    DEFAULT,            // engine set by Calendar::SetDefaultEngine (binary heap, if not changed)
+    BINARY_HEAP,        // indexed binary heap; O(log n) operations
+    CALENDAR_QUEUE,     // Brown's calendar queue; amortized O(1) operations, automatically resized
 };
 
 /*
  * Calendar class used for scheduling simulation events
+ *
+ * Every pushed object receives a handle, which tracks its location within the calendar, so the object could
+ * be removed or moved (rescheduled) without searching for it; the handle is stored within the object itself
  */
-class Calendar : public std::priority_queue<SimulationObjectPtr, std::vector<SimulationObjectPtr>, TimePriorityCmp>
+class Calendar
 {
     public:
-        // removes specified simulation object from calendar (using its GUID)
+        Calendar(CalendarEngine engine);
+        virtual ~Calendar();
+
+        // retrieves engine of this calendar
+        CalendarEngine GetEngine() const;
+
+        // is the calendar empty?
+        virtual bool empty() const = 0;
+        // retrieves number of scheduled objects
+        virtual size_t size() const = 0;
+
+        // retrieves entry on top of calendar (the one with the lowest scheduled time)
+        virtual CalendarEntry const& top_entry() const = 0;
+        // retrieves object on top of calendar
+        SimulationObjectPtr const& top() const;
+        // pushes object to calendar using its scheduled time; returns handle of calendar entry
+        CalendarHandle push(SimulationObjectPtr const& obj);
+        // pops object from top of calendar
+        void pop();
+
+        // removes specified simulation object from calendar (using its calendar handle); the object must be scheduled
+        // in this calendar, returns false otherwise
         bool remove(const SimulationObjectPtr obj);
+        // removes calendar entry with given handle
+        bool remove(CalendarHandle handle);
+        // restores ordering of entry with given handle after its scheduled time changed (reschedule, decrease-key)
+        void update(CalendarHandle handle);
 
-        // creates new calendar instance
-        static CalendarPtr Create();
+        // appends all entries (in no particular order) to given vector
+        void collect(std::vector<CalendarEntry>& entries) const;
+        // retrieves object scheduled by entry with given handle
+        SimulationObjectPtr const& object_of(CalendarHandle handle) const;
+
+        // creates new calendar instance using given engine
+        static CalendarPtr Create(CalendarEngine engine = CalendarEngine::DEFAULT);
+        // sets engine used for calendars created with CalendarEngine::DEFAULT
+        static void SetDefaultEngine(CalendarEngine engine);
+
+    protected:
+        // engine-specific implementation of push
+        virtual CalendarHandle PushEntry(SimulationObjectPtr const& obj) = 0;
+        // engine-specific implementation of pop
+        virtual void PopEntry() = 0;
+        // engine-specific implementation of remove
+        virtual bool RemoveEntry(CalendarHandle handle) = 0;
+        // engine-specific implementation of update
+        virtual void UpdateEntry(CalendarHandle handle) = 0;
+        // engine-specific implementation of collect
+        virtual void CollectEntries(std::vector<CalendarEntry>& entries) const = 0;
+
+        // notifies owning calendar list, that the top of this calendar might have changed
+        void NotifyHeadChanged();
+
+        // creates entry for given object - allocates handle and slot, assigns sequence number
+        CalendarEntry CreateEntry(SimulationObjectPtr const& obj);
+        // refreshes time and sequence number of entry from its scheduled object
+        void RefreshEntry(CalendarEntry& entry);
+        // releases entry handle and slot; the object is no longer scheduled in this calendar
+        void ReleaseEntry(CalendarHandle handle);
+        // retrieves sequence number for new entry; calendars within the same list share the sequence
+        uint32_t NextSequence();
+
+        /*
+         * Slot of scheduled object; indexed by entry handle
+         */
+        struct CalendarSlot
+        {
+            // scheduled object
+            SimulationObjectPtr object;
+            // engine-specific location of entry
+            uint64_t location;
+        };
+
+        // slots of scheduled objects indexed by handle
+        std::vector<CalendarSlot> m_slots;
+
+    private:
+        friend class CalendarList;
+
+        // engine of this calendar
+        CalendarEngine m_engine;
+        // calendar list this calendar is registered in
+        CalendarList* m_owner;
+        // index of this calendar within owning calendar list
+        size_t m_ownerIndex;
+        // released handles available for reuse
+        std::vector<CalendarHandle> m_freeHandles;
+        // sequence number assigned to next entry
+        uint32_t m_sequenceNext;
+
+        // engine used for calendars created with CalendarEngine::DEFAULT; atomic, since the calendars may be created
+        // by simulations running in parallel
+        static std::atomic<CalendarEngine> m_defaultEngine;
 };
 
 /*
  * Class representing a list of calendars with joined top and pop methods
+ *
+ * The calendars are kept in an indexed min-heap ordered by time of their top entry; the calendars notify the
+ * list whenever their top changes, so the dominant calendar is always known in O(1) and updated in O(log k).
+ * All calendars in list share the sequence of entries, so the entries scheduled to the same time are taken
+ * in order of insertion even across calendars
  */
-class CalendarList : public std::list<CalendarPtr>
+class CalendarList
 {
     public:
+        CalendarList();
+        ~CalendarList();
+
+        // adds calendar to list; the calendar may be registered within a single list only
+        void push_back(CalendarPtr const& calendar);
+        // is the list empty (contains no calendars)?
+        bool empty() const;
+        // retrieves number of calendars
+        size_t size() const;
+        // retrieves the first added calendar
+        CalendarPtr const& front() const;
+
+        // iteration over calendars (in order of addition)
+        std::vector<CalendarPtr>::const_iterator begin() const;
+        std::vector<CalendarPtr>::const_iterator end() const;
+
         // get simulation object on top of dominant calendar
         SimulationObjectPtr top() const;
+        // get dominant calendar (the one with the soonest top); empty pointer if all calendars are empty
+        CalendarPtr top_calendar() const;
         // pops element from top
         void pop();
+        // retrieves simulation object on top of dominant calendar and pops it
+        SimulationObjectPtr pop_top();
+        // pops all objects scheduled to the soonest time from all calendars and appends them to batch in FIFO
+        // order (by sequence number); returns the time of popped objects
+        simtime_t pop_batch(SimulationBatch& batch);
         // are all calendars empty?
         bool all_empty() const;
+
+    protected:
+        friend class Calendar;
+
+        // is top of calendar a dominant over top of calendar b?
+        bool IsDominantCalendar(size_t a, size_t b) const;
+        // called by calendar with given index, when its top might have changed
+        void HeadChanged(size_t index);
+
+        // is calendar a on heap position posA dominant over calendar on position posB?
+        bool IsDominant(size_t posA, size_t posB) const;
+        // swaps calendars on given heap positions
+        void SwapPositions(size_t posA, size_t posB);
+        // moves calendar at given heap position up/down until heap property is restored
+        void SiftUp(size_t pos);
+        void SiftDown(size_t pos);
+
+        // all calendars in order of addition
+        std::vector<CalendarPtr> m_calendars;
+        /*
+         * Cached state of calendar top
+         */
+        struct HeadInfo
+        {
+            // is the calendar empty?
+            bool empty;
+            // time of top entry (if not empty)
+            simtime_t time;
+            // sequence number of top entry (if not empty)
+            uint32_t sequence;
+        };
+
+        // cached top state of each calendar
+        std::vector<HeadInfo> m_heads;
+        // min-heap of calendar indices ordered by time of their top entry
+        std::vector<size_t> m_heap;
+        // heap positions indexed by calendar index
+        std::vector<size_t> m_heapPositions;
+        // number of non-empty calendars
+        size_t m_nonEmptyCount;
+        // sequence number assigned to next entry in any of calendars
+        uint32_t m_sequenceNext;
 };
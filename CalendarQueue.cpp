@@ -0,0 +1,294 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "SimulationObject.h"
+#include "CalendarQueue.h"
+
+#include <algorithm>
+
+// minimum (and initial) number of buckets
+constexpr size_t CalendarQueue_MinBuckets = 2;
+// maximum number of entries sampled when computing bucket width
+constexpr size_t CalendarQueue_MaxWidthSamples = 25;
+// minimum number of dequeued entries in bucket to consider compacting it
+constexpr size_t CalendarQueue_MinCompactHead = 32;
+
+CalendarQueue::CalendarQueue()
+    : Calendar(CalendarEngine::CALENDAR_QUEUE), m_buckets(CalendarQueue_MinBuckets), m_bucketWidth(1), m_size(0),
+      m_cursorBucket(0), m_cursorTop(1), m_topValid(false), m_shrinkThreshold(0), m_growThreshold(2 * CalendarQueue_MinBuckets)
+{
+    //
+}
+
+CalendarQueue::~CalendarQueue()
+{
+    //
+}
+
+bool CalendarQueue::empty() const
+{
+    return (m_size == 0);
+}
+
+size_t CalendarQueue::size() const
+{
+    return m_size;
+}
+
+size_t CalendarQueue::GetBucketIndex(simtime_t time) const
+{
+    // bucket count is always a power of two
+    return static_cast<size_t>(time / m_bucketWidth) & (m_buckets.size() - 1);
+}
+
+void CalendarQueue::MoveCursor(simtime_t time) const
+{
+    m_cursorBucket = GetBucketIndex(time);
+    m_cursorTop = (time / m_bucketWidth + 1) * m_bucketWidth;
+    m_topValid = false;
+}
+
+void CalendarQueue::UpdateLocations(size_t bucket, size_t fromIndex)
+{
+    Bucket& b = m_buckets[bucket];
+    for (size_t i = fromIndex; i < b.entries.size(); i++)
+        m_slots[b.entries[i].handle].location = (static_cast<uint64_t>(bucket) << 32) | i;
+}
+
+bool CalendarQueue::FindLocation(CalendarHandle handle, size_t& bucket, size_t& index) const
+{
+    if (handle >= m_slots.size())
+        return false;
+
+    bucket = static_cast<size_t>(m_slots[handle].location >> 32);
+    index = static_cast<size_t>(m_slots[handle].location & 0xFFFFFFFFULL);
+
+    // the handle may belong to another calendar or may be already released
+    if (bucket >= m_buckets.size())
+        return false;
+
+    Bucket const& b = m_buckets[bucket];
+    return (index >= b.head && index < b.entries.size() && b.entries[index].handle == handle);
+}
+
+void CalendarQueue::InsertEntry(CalendarEntry const& entry)
+{
+    // every entry must be scheduled at or after the start of cursor bucket, otherwise the dequeue would skip it
+    if (m_size == 0 || entry.time < m_cursorTop - m_bucketWidth)
+        MoveCursor(entry.time);
+    else if (m_topValid && m_cmp(m_buckets[m_cursorBucket].front(), entry))
+        m_topValid = false;
+
+    size_t bucket = GetBucketIndex(entry.time);
+    Bucket& b = m_buckets[bucket];
+
+    // keep the bucket ordered from the soonest entry; new entries are usually the latest ones, so look from back
+    auto itr = b.entries.end();
+    while (itr != b.entries.begin() + b.head && m_cmp(*(itr - 1), entry))
+        --itr;
+
+    size_t index = static_cast<size_t>(itr - b.entries.begin());
+
+    b.entries.insert(itr, entry);
+    UpdateLocations(bucket, index);
+
+    m_size++;
+}
+
+CalendarEntry CalendarQueue::ExtractEntry(size_t bucket, size_t index)
+{
+    Bucket& b = m_buckets[bucket];
+
+    CalendarEntry entry = b.entries[index];
+
+    // the soonest entry is just skipped; others are erased
+    if (index == b.head)
+        b.head++;
+    else
+    {
+        b.entries.erase(b.entries.begin() + index);
+        UpdateLocations(bucket, index);
+    }
+
+    // drop dequeued entries once they form the major part of bucket
+    if (b.empty())
+    {
+        b.entries.clear();
+        b.head = 0;
+    }
+    else if (b.head >= CalendarQueue_MinCompactHead && 2 * b.head >= b.entries.size())
+    {
+        b.entries.erase(b.entries.begin(), b.entries.begin() + b.head);
+        b.head = 0;
+        UpdateLocations(bucket, 0);
+    }
+
+    m_size--;
+    m_topValid = false;
+
+    return entry;
+}
+
+void CalendarQueue::FindTop() const
+{
+    if (m_topValid || m_size == 0)
+        return;
+
+    // walk the buckets from cursor and look for entry scheduled within current "year"
+    for (size_t i = 0; i < m_buckets.size(); i++)
+    {
+        Bucket const& b = m_buckets[m_cursorBucket];
+        if (!b.empty() && b.front().time < m_cursorTop)
+        {
+            m_topValid = true;
+            return;
+        }
+
+        m_cursorBucket = (m_cursorBucket + 1) & (m_buckets.size() - 1);
+        m_cursorTop += m_bucketWidth;
+    }
+
+    // nothing found within a whole year - perform direct search for the soonest entry
+    simtime_t minTime = std::numeric_limits<simtime_t>::max();
+    for (auto& b : m_buckets)
+    {
+        if (!b.empty() && b.front().time < minTime)
+            minTime = b.front().time;
+    }
+
+    MoveCursor(minTime);
+    m_topValid = true;
+}
+
+CalendarEntry const& CalendarQueue::top_entry() const
+{
+    FindTop();
+    return m_buckets[m_cursorBucket].front();
+}
+
+CalendarHandle CalendarQueue::PushEntry(SimulationObjectPtr const& obj)
+{
+    CalendarEntry entry = CreateEntry(obj);
+
+    InsertEntry(entry);
+
+    if (m_size > m_growThreshold)
+        Resize(2 * m_buckets.size());
+
+    return entry.handle;
+}
+
+void CalendarQueue::PopEntry()
+{
+    if (m_size == 0)
+        return;
+
+    FindTop();
+
+    CalendarEntry entry = ExtractEntry(m_cursorBucket, m_buckets[m_cursorBucket].head);
+    ReleaseEntry(entry.handle);
+
+    if (m_size < m_shrinkThreshold)
+        Resize(m_buckets.size() / 2);
+}
+
+bool CalendarQueue::RemoveEntry(CalendarHandle handle)
+{
+    size_t bucket, index;
+    if (!FindLocation(handle, bucket, index))
+        return false;
+
+    CalendarEntry entry = ExtractEntry(bucket, index);
+    ReleaseEntry(entry.handle);
+
+    if (m_size < m_shrinkThreshold)
+        Resize(m_buckets.size() / 2);
+
+    return true;
+}
+
+void CalendarQueue::UpdateEntry(CalendarHandle handle)
+{
+    size_t bucket, index;
+    if (!FindLocation(handle, bucket, index))
+        return;
+
+    // re-insert the entry with new time; it keeps its handle
+    CalendarEntry entry = ExtractEntry(bucket, index);
+    RefreshEntry(entry);
+    InsertEntry(entry);
+}
+
+void CalendarQueue::CollectEntries(std::vector<CalendarEntry>& entries) const
+{
+    for (auto const& b : m_buckets)
+        entries.insert(entries.end(), b.entries.begin() + b.head, b.entries.end());
+}
+
+simtime_t CalendarQueue::ComputeBucketWidth() const
+{
+    // sample the soonest entries; Brown suggests 5 + 10% of entries, with upper limit of 25 entries
+    size_t samples = (m_size <= 5) ? m_size : std::min<size_t>(5 + m_size / 10, CalendarQueue_MaxWidthSamples);
+    if (samples < 2)
+        return m_bucketWidth;
+
+    std::vector<simtime_t> times;
+    times.reserve(m_size);
+    for (auto& b : m_buckets)
+    {
+        for (size_t i = b.head; i < b.entries.size(); i++)
+            times.push_back(b.entries[i].time);
+    }
+
+    std::nth_element(times.begin(), times.begin() + (samples - 1), times.end());
+    std::sort(times.begin(), times.begin() + samples);
+
+    // average separation of sampled entries
+    simtime_t total = times[samples - 1] - times[0];
+    simtime_t average = total / (samples - 1);
+
+    // recompute the average, ignoring separations significantly larger than the average
+    simtime_t trimmedTotal = 0;
+    size_t trimmedCount = 0;
+    for (size_t i = 1; i < samples; i++)
+    {
+        simtime_t separation = times[i] - times[i - 1];
+        if (separation <= 2 * average)
+        {
+            trimmedTotal += separation;
+            trimmedCount++;
+        }
+    }
+
+    if (trimmedCount > 0)
+        average = trimmedTotal / trimmedCount;
+
+    return std::max<simtime_t>(3 * average, 1);
+}
+
+void CalendarQueue::Resize(size_t bucketCount)
+{
+    bucketCount = std::max(bucketCount, CalendarQueue_MinBuckets);
+
+    simtime_t width = ComputeBucketWidth();
+
+    std::vector<Bucket> oldBuckets(bucketCount);
+    std::swap(oldBuckets, m_buckets);
+
+    m_bucketWidth = width;
+    m_size = 0;
+    m_topValid = false;
+
+    m_growThreshold = 2 * bucketCount;
+    m_shrinkThreshold = (bucketCount > CalendarQueue_MinBuckets) ? bucketCount / 2 : 0;
+
+    // re-insert entries; their sequence numbers are kept, so the order of equal times does not change
+    for (auto& b : oldBuckets)
+    {
+        for (size_t i = b.head; i < b.entries.size(); i++)
+            InsertEntry(b.entries[i]);
+    }
+}
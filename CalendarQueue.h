@@ -0,0 +1,89 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include "Calendar.h"
+
+/*
+ * Calendar implemented as Brown's calendar queue - entries are hashed by their scheduled time into an array
+ * of buckets ("days"), each covering a time interval of the same width; the array wraps around ("year"), so
+ * the dequeue just walks the buckets from the last dequeued one. Bucket count and width are recomputed when
+ * the number of entries grows or shrinks, so enqueue and dequeue take amortized O(1) time
+ */
+class CalendarQueue : public Calendar
+{
+    public:
+        CalendarQueue();
+        virtual ~CalendarQueue();
+
+        bool empty() const override;
+        size_t size() const override;
+
+        CalendarEntry const& top_entry() const override;
+
+    protected:
+        CalendarHandle PushEntry(SimulationObjectPtr const& obj) override;
+        void PopEntry() override;
+        bool RemoveEntry(CalendarHandle handle) override;
+        void UpdateEntry(CalendarHandle handle) override;
+        void CollectEntries(std::vector<CalendarEntry>& entries) const override;
+
+        /*
+         * Single bucket ("day") of calendar queue
+         */
+        struct Bucket
+        {
+            // entries ordered from the soonest one; entries before head are already dequeued
+            std::vector<CalendarEntry> entries;
+            // index of the soonest entry
+            size_t head = 0;
+
+            bool empty() const { return head == entries.size(); }
+            CalendarEntry const& front() const { return entries[head]; }
+        };
+
+        // retrieves bucket index for given time
+        size_t GetBucketIndex(simtime_t time) const;
+        // inserts entry to its bucket
+        void InsertEntry(CalendarEntry const& entry);
+        // removes entry from given location and returns it
+        CalendarEntry ExtractEntry(size_t bucket, size_t index);
+        // updates locations of entries in given bucket, starting at given index
+        void UpdateLocations(size_t bucket, size_t fromIndex);
+        // retrieves location of entry with given handle; returns false if the handle is not present
+        bool FindLocation(CalendarHandle handle, size_t& bucket, size_t& index) const;
+
+        // finds the soonest entry and moves the dequeue cursor to its bucket
+        void FindTop() const;
+        // moves dequeue cursor to the bucket of given time
+        void MoveCursor(simtime_t time) const;
+        // rebuilds the queue with new bucket count and recomputed bucket width
+        void Resize(size_t bucketCount);
+        // estimates bucket width from separation of the soonest entries
+        simtime_t ComputeBucketWidth() const;
+
+        // buckets of calendar queue
+        std::vector<Bucket> m_buckets;
+        // bucket width (time interval covered by a single bucket)
+        simtime_t m_bucketWidth;
+        // number of entries
+        size_t m_size;
+        // comparator used for bucket ordering
+        TimePriorityCmp m_cmp;
+
+        // bucket, where the dequeue cursor is
+        mutable size_t m_cursorBucket;
+        // upper time bound of cursor bucket within current "year"
+        mutable simtime_t m_cursorTop;
+        // is the cursor bucket holding the soonest entry?
+        mutable bool m_topValid;
+
+        // bucket count threshold for shrinking the queue
+        size_t m_shrinkThreshold;
+        // bucket count threshold for growing the queue
+        size_t m_growThreshold;
+};
@@ -0,0 +1,58 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+/*
+ * Simulation checkpoint file layout:
+ *
+ *   file header | simulation | objects | registry | calendars | messages | statistics | end
+ *
+ * Everything past the header is a stream of variable-length integers (LEB128, signed values zigzag-encoded) and doubles
+ * in native byte order, written and read strictly sequentially, so the checkpoint never needs to be held in memory
+ * nor seeked. Every section starts with its tag, every object record ends with a marker, so the reader detects
+ * mismatched serialization hooks and truncated files
+ */
+
+// magic value of checkpoint file header
+constexpr char CheckpointFile_Magic[8] = { 'S', 'I', 'M', 'C', 'K', 'P', 'T', 0 };
+// version of checkpoint file format
+constexpr uint32_t CheckpointFile_Version = 2;
+// marker written after every object record
+constexpr uint64_t CheckpointObject_EndMarker = 0x5A;
+// size of read and write buffers
+constexpr size_t Checkpoint_BufferSize = 1 << 20;
+
+/*
+ * Section of checkpoint file
+ */
+enum class CheckpointSection : uint8_t
+{
+    SIMULATION = 1,     // simulation time, seeds, counters
+    OBJECTS,            // object records (base state, attributes, periodic schedule generator, user state)
+    REGISTRY,           // slot map and dense lists of object registry
+    CALENDARS,          // scheduled objects of all calendars
+    MESSAGES,           // received messages not dispatched yet
+    STATISTICS,         // named output statistics (see StatisticRegistry)
+    END                 // end of checkpoint
+};
+
+/*
+ * Checkpoint file header
+ */
+struct CheckpointFileHeader
+{
+    // magic value (CheckpointFile_Magic)
+    char magic[8];
+    // format version
+    uint32_t version;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(CheckpointFileHeader) == 16, "CheckpointFileHeader is expected to be 16 bytes long");
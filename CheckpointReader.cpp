@@ -0,0 +1,212 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "CheckpointReader.h"
+
+#include <cstring>
+#include <algorithm>
+
+CheckpointReader::CheckpointReader()
+    : m_buffer(Checkpoint_BufferSize), m_data(nullptr), m_position(0), m_end(0), m_good(false)
+{
+    //
+}
+
+CheckpointReader::~CheckpointReader()
+{
+    Close();
+}
+
+bool CheckpointReader::Open(std::string const& path)
+{
+    Close();
+
+    m_file.rdbuf()->pubsetbuf(nullptr, 0);
+    m_file.open(path, std::ios::binary);
+    if (!m_file.is_open())
+        return false;
+
+    m_data = m_buffer.data();
+    m_position = 0;
+    m_end = 0;
+    m_good = true;
+
+    return ReadHeader();
+}
+
+bool CheckpointReader::Open(std::vector<unsigned char> const& image)
+{
+    Close();
+
+    m_data = image.data();
+    m_position = 0;
+    m_end = image.size();
+    m_good = true;
+
+    return ReadHeader();
+}
+
+void CheckpointReader::Close()
+{
+    if (m_file.is_open())
+        m_file.close();
+
+    m_data = nullptr;
+    m_position = 0;
+    m_end = 0;
+    m_good = false;
+}
+
+bool CheckpointReader::IsOpen() const
+{
+    return m_data != nullptr;
+}
+
+bool CheckpointReader::ReadHeader()
+{
+    CheckpointFileHeader header;
+    if (!ReadBytes(&header, sizeof(header)) || std::memcmp(header.magic, CheckpointFile_Magic, sizeof(header.magic)) != 0
+        || header.version != CheckpointFile_Version)
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+bool CheckpointReader::IsGood() const
+{
+    return m_good;
+}
+
+void CheckpointReader::Fail()
+{
+    // nothing is read after failure
+    m_good = false;
+    m_position = 0;
+    m_end = 0;
+}
+
+bool CheckpointReader::FillBuffer()
+{
+    // memory image is read whole at once
+    if (!m_good || !m_file.is_open())
+        return false;
+
+    if (m_position > 0)
+    {
+        std::memmove(m_buffer.data(), m_buffer.data() + m_position, m_end - m_position);
+        m_end -= m_position;
+        m_position = 0;
+    }
+
+    m_file.read(reinterpret_cast<char*>(m_buffer.data() + m_end), m_buffer.size() - m_end);
+    const size_t count = static_cast<size_t>(m_file.gcount());
+    m_end += count;
+
+    return count > 0;
+}
+
+uint64_t CheckpointReader::ReadVarUIntSlow()
+{
+    uint64_t value = 0;
+    for (unsigned int shift = 0; shift < 70; shift += 7)
+    {
+        if (m_position == m_end && !FillBuffer())
+        {
+            Fail();
+            return 0;
+        }
+
+        const unsigned char byte = m_data[m_position++];
+        value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+        if (!(byte & 0x80))
+            return value;
+    }
+
+    Fail();
+    return 0;
+}
+
+double CheckpointReader::ReadDouble()
+{
+    double value = 0.0;
+    if (!ReadBytes(&value, sizeof(value)))
+        return 0.0;
+
+    return value;
+}
+
+bool CheckpointReader::ReadBytes(void* data, size_t size)
+{
+    unsigned char* bytes = static_cast<unsigned char*>(data);
+
+    while (size > 0)
+    {
+        if (m_position == m_end && !FillBuffer())
+        {
+            Fail();
+            return false;
+        }
+
+        const size_t count = std::min(size, m_end - m_position);
+        std::memcpy(bytes, m_data + m_position, count);
+
+        m_position += count;
+        bytes += count;
+        size -= count;
+    }
+
+    return true;
+}
+
+std::string CheckpointReader::ReadString()
+{
+    const uint64_t length = ReadVarUInt();
+
+    // read in pieces, so the corrupted length does not allocate the whole memory
+    std::string value;
+    while (m_good && value.size() < length)
+    {
+        const size_t count = static_cast<size_t>(std::min<uint64_t>(length - value.size(), m_buffer.size()));
+        const size_t offset = value.size();
+
+        value.resize(offset + count);
+        if (!ReadBytes(&value[offset], count))
+            return std::string();
+    }
+
+    return value;
+}
+
+bool CheckpointReader::ReadMessage(SimulationMessage& message)
+{
+    message.time = ReadVarUInt();
+    message.sendTime = ReadVarUInt();
+    message.targetGUID = ReadVarUInt();
+    message.sequence = ReadVarUInt();
+    message.sourceLP = static_cast<uint32_t>(ReadVarUInt());
+    message.targetLP = static_cast<uint32_t>(ReadVarUInt());
+    message.kind = static_cast<uint32_t>(ReadVarUInt());
+    message.flags = static_cast<uint32_t>(ReadVarUInt());
+    for (int64_t& value : message.data)
+        value = ReadVarInt();
+
+    return m_good;
+}
+
+bool CheckpointReader::read_state(uint64_t& value)
+{
+    value = ReadVarUInt();
+    return m_good;
+}
+
+bool CheckpointReader::read_state(double& value)
+{
+    value = ReadDouble();
+    return m_good;
+}
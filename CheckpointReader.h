@@ -0,0 +1,125 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "CheckpointFormat.h"
+#include "SimulationMessage.h"
+#include "random/base_generator.h"
+
+/*
+ * Reader of simulation checkpoint written by CheckpointWriter
+ *
+ * The file is read sequentially in big blocks. Reading past the end of file or reading malformed value marks
+ * the reader as failed; failed reader returns zero values, so the caller could check IsGood just once after reading
+ * a group of values. Memory image is read in place, without buffering. See CheckpointFormat.h for file layout
+ */
+class CheckpointReader : public random_state_source
+{
+    public:
+        CheckpointReader();
+        virtual ~CheckpointReader();
+
+        // opens checkpoint file and checks its header; returns false, if the file could not be opened or it is not
+        // a checkpoint of supported version
+        bool Open(std::string const& path);
+        // opens checkpoint memory image written by CheckpointWriter and checks its header; the image is read in place,
+        // so it must exist until the reader is closed
+        bool Open(std::vector<unsigned char> const& image);
+        // closes the file (or image)
+        void Close();
+        // is the checkpoint file (or image) open?
+        bool IsOpen() const;
+        // were all reads so far successful?
+        bool IsGood() const;
+        // marks the reader as failed (e.g. when the read state is not valid)
+        void Fail();
+
+        // reads unsigned variable-length number
+        uint64_t ReadVarUInt()
+        {
+            // fast path - the whole number is buffered
+            if (m_end - m_position >= 10)
+            {
+                uint64_t value = 0;
+                for (unsigned int shift = 0; shift < 70; shift += 7)
+                {
+                    const unsigned char byte = m_data[m_position++];
+                    value |= static_cast<uint64_t>(byte & 0x7F) << shift;
+                    if (!(byte & 0x80))
+                        return value;
+                }
+
+                Fail();
+                return 0;
+            }
+
+            return ReadVarUIntSlow();
+        }
+
+        // reads signed variable-length number
+        int64_t ReadVarInt()
+        {
+            const uint64_t value = ReadVarUInt();
+            return static_cast<int64_t>((value >> 1) ^ (~(value & 1) + 1));
+        }
+
+        // reads boolean value
+        bool ReadBool()
+        {
+            return ReadVarUInt() != 0;
+        }
+
+        // reads floating-point value
+        double ReadDouble();
+        // reads raw bytes; returns false, if there's not enough data
+        bool ReadBytes(void* data, size_t size);
+        // reads string
+        std::string ReadString();
+
+        // reads simulation message; returns false, if the message could not be read
+        bool ReadMessage(SimulationMessage& message);
+
+        // restores state of random generator; returns false, if the state could not be read
+        template<typename T>
+        bool ReadGenerator(base_generator<T>& generator)
+        {
+            if (!generator.load(*this))
+                Fail();
+
+            return m_good;
+        }
+
+        bool read_state(uint64_t& value) override;
+        bool read_state(double& value) override;
+
+    protected:
+        // reads and checks header of checkpoint file; closes the reader, if the header is not valid
+        bool ReadHeader();
+        // reads variable-length number, that may cross the buffer end
+        uint64_t ReadVarUIntSlow();
+        // moves unread data to the beginning of buffer and fills the rest from file; returns false, if there are
+        // no more data
+        bool FillBuffer();
+
+    private:
+        // input file
+        std::ifstream m_file;
+        // data read from file
+        std::vector<unsigned char> m_buffer;
+        // data being read (read buffer or memory image)
+        const unsigned char* m_data;
+        // position of the next unread byte
+        size_t m_position;
+        // end of valid data in buffer
+        size_t m_end;
+        // were all reads successful?
+        bool m_good;
+};
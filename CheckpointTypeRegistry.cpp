@@ -0,0 +1,42 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "CheckpointTypeRegistry.h"
+
+CheckpointTypeRegistry::CheckpointTypeRegistry()
+{
+    //
+}
+
+bool CheckpointTypeRegistry::Register(uint32_t checkpointTypeId, std::type_index type, CheckpointObjectFactory factory)
+{
+    if (m_factories.find(checkpointTypeId) != m_factories.end() || m_typeIds.find(type) != m_typeIds.end())
+        return false;
+
+    m_typeIds.emplace(type, checkpointTypeId);
+    m_factories.emplace(checkpointTypeId, std::move(factory));
+
+    return true;
+}
+
+bool CheckpointTypeRegistry::GetTypeId(std::type_index type, uint32_t& checkpointTypeId) const
+{
+    auto itr = m_typeIds.find(type);
+    if (itr == m_typeIds.end())
+        return false;
+
+    checkpointTypeId = itr->second;
+    return true;
+}
+
+SimulationObjectPtr CheckpointTypeRegistry::Create(uint32_t checkpointTypeId, Simulation& simulation) const
+{
+    auto itr = m_factories.find(checkpointTypeId);
+    if (itr == m_factories.end())
+        return nullptr;
+
+    return itr->second(simulation);
+}
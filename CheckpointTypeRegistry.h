@@ -0,0 +1,45 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <functional>
+#include <typeindex>
+#include <unordered_map>
+
+#include "Types.h"
+
+class Simulation;
+
+// creates empty object of registered type within given simulation, which is then restored from checkpoint
+using CheckpointObjectFactory = std::function<SimulationObjectPtr(Simulation& simulation)>;
+
+/*
+ * Registry of object types, that could be written to checkpoint and restored from it
+ *
+ * The checkpoint refers to object types by user-assigned identifiers, since the type names and pool type identifiers
+ * are not stable between program runs
+ */
+class CheckpointTypeRegistry
+{
+    public:
+        CheckpointTypeRegistry();
+
+        // registers type under given identifier; returns false, if the identifier or the type is already registered
+        bool Register(uint32_t checkpointTypeId, std::type_index type, CheckpointObjectFactory factory);
+        // retrieves identifier of given type; returns false, if the type is not registered
+        bool GetTypeId(std::type_index type, uint32_t& checkpointTypeId) const;
+        // creates object of type registered under given identifier within given simulation; empty pointer, if
+        // the identifier is not registered
+        SimulationObjectPtr Create(uint32_t checkpointTypeId, Simulation& simulation) const;
+
+    private:
+        // identifiers of registered types
+        std::unordered_map<std::type_index, uint32_t> m_typeIds;
+        // factories of registered types by their identifiers
+        std::unordered_map<uint32_t, CheckpointObjectFactory> m_factories;
+};
@@ -0,0 +1,164 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "CheckpointWriter.h"
+
+#include <cstring>
+#include <algorithm>
+
+CheckpointWriter::CheckpointWriter()
+    : m_image(nullptr), m_buffer(Checkpoint_BufferSize), m_position(0), m_good(false)
+{
+    //
+}
+
+CheckpointWriter::~CheckpointWriter()
+{
+    Close();
+}
+
+bool CheckpointWriter::Open(std::string const& path)
+{
+    Close();
+    m_good = false;
+
+    // the data are written in big blocks, the stream does not need its own buffer
+    m_file.rdbuf()->pubsetbuf(nullptr, 0);
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open())
+        return false;
+
+    m_position = 0;
+    m_good = true;
+
+    WriteHeader();
+
+    return m_good;
+}
+
+bool CheckpointWriter::Open(std::vector<unsigned char>& image)
+{
+    Close();
+
+    image.clear();
+    m_image = &image;
+    m_position = 0;
+    m_good = true;
+
+    WriteHeader();
+
+    return m_good;
+}
+
+bool CheckpointWriter::Close()
+{
+    if (m_image)
+    {
+        FlushBuffer();
+        m_image = nullptr;
+        return m_good;
+    }
+
+    if (!m_file.is_open())
+        return m_good;
+
+    FlushBuffer();
+    m_file.close();
+    if (m_file.fail())
+        m_good = false;
+
+    return m_good;
+}
+
+bool CheckpointWriter::IsOpen() const
+{
+    return m_image || m_file.is_open();
+}
+
+bool CheckpointWriter::IsGood() const
+{
+    return m_good;
+}
+
+void CheckpointWriter::WriteHeader()
+{
+    CheckpointFileHeader header;
+    std::memcpy(header.magic, CheckpointFile_Magic, sizeof(header.magic));
+    header.version = CheckpointFile_Version;
+    header.reserved = 0;
+
+    WriteBytes(&header, sizeof(header));
+}
+
+void CheckpointWriter::FlushBuffer()
+{
+    if (m_position == 0)
+        return;
+
+    if (m_image)
+        m_image->insert(m_image->end(), m_buffer.begin(), m_buffer.begin() + m_position);
+    else if (m_good)
+    {
+        m_file.write(reinterpret_cast<const char*>(m_buffer.data()), m_position);
+        if (!m_file.good())
+            m_good = false;
+    }
+
+    m_position = 0;
+}
+
+void CheckpointWriter::WriteDouble(double value)
+{
+    WriteBytes(&value, sizeof(value));
+}
+
+void CheckpointWriter::WriteBytes(const void* data, size_t size)
+{
+    const unsigned char* bytes = static_cast<const unsigned char*>(data);
+
+    while (size > 0)
+    {
+        if (m_position == m_buffer.size())
+            FlushBuffer();
+
+        const size_t count = std::min(size, m_buffer.size() - m_position);
+        std::memcpy(m_buffer.data() + m_position, bytes, count);
+
+        m_position += count;
+        bytes += count;
+        size -= count;
+    }
+}
+
+void CheckpointWriter::WriteString(std::string const& value)
+{
+    WriteVarUInt(value.size());
+    WriteBytes(value.data(), value.size());
+}
+
+void CheckpointWriter::WriteMessage(SimulationMessage const& message)
+{
+    WriteVarUInt(message.time);
+    WriteVarUInt(message.sendTime);
+    WriteVarUInt(message.targetGUID);
+    WriteVarUInt(message.sequence);
+    WriteVarUInt(message.sourceLP);
+    WriteVarUInt(message.targetLP);
+    WriteVarUInt(message.kind);
+    WriteVarUInt(message.flags);
+    for (int64_t value : message.data)
+        WriteVarInt(value);
+}
+
+void CheckpointWriter::write_state(uint64_t value)
+{
+    WriteVarUInt(value);
+}
+
+void CheckpointWriter::write_state(double value)
+{
+    WriteDouble(value);
+}
@@ -0,0 +1,106 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "CheckpointFormat.h"
+#include "SimulationMessage.h"
+#include "random/base_generator.h"
+
+/*
+ * Writer of simulation checkpoint
+ *
+ * Values are encoded to a large buffer, which is written to file whenever it fills up, so the checkpoint is written
+ * sequentially in big blocks regardless of its size. The checkpoint may be also written to memory image (see
+ * Simulation::Fork). Write errors are remembered and reported by IsGood and Close.
+ * See CheckpointFormat.h for file layout
+ */
+class CheckpointWriter : public random_state_sink
+{
+    public:
+        CheckpointWriter();
+        virtual ~CheckpointWriter();
+
+        // creates checkpoint file and writes its header; returns false, if the file could not be created
+        bool Open(std::string const& path);
+        // starts writing checkpoint to memory image (replacing its contents) and writes its header; the image must
+        // exist until the writer is closed
+        bool Open(std::vector<unsigned char>& image);
+        // writes buffered data and closes the file (or image); returns false, if anything failed to be written
+        bool Close();
+        // is the checkpoint file (or image) open?
+        bool IsOpen() const;
+        // were all writes so far successful?
+        bool IsGood() const;
+
+        // writes unsigned integer as variable-length number (7 bits per byte)
+        void WriteVarUInt(uint64_t value)
+        {
+            if (m_buffer.size() - m_position < 10)
+                FlushBuffer();
+
+            while (value >= 0x80)
+            {
+                m_buffer[m_position++] = static_cast<unsigned char>(value | 0x80);
+                value >>= 7;
+            }
+            m_buffer[m_position++] = static_cast<unsigned char>(value);
+        }
+
+        // writes signed integer as variable-length number; small negative numbers are encoded to small numbers
+        void WriteVarInt(int64_t value)
+        {
+            WriteVarUInt((static_cast<uint64_t>(value) << 1) ^ static_cast<uint64_t>(value >> 63));
+        }
+
+        // writes boolean value
+        void WriteBool(bool value)
+        {
+            WriteVarUInt(value ? 1 : 0);
+        }
+
+        // writes floating-point value
+        void WriteDouble(double value);
+        // writes raw bytes
+        void WriteBytes(const void* data, size_t size);
+        // writes string (length and characters)
+        void WriteString(std::string const& value);
+
+        // writes simulation message
+        void WriteMessage(SimulationMessage const& message);
+
+        // writes state of random generator
+        template<typename T>
+        void WriteGenerator(base_generator<T> const& generator)
+        {
+            generator.save(*this);
+        }
+
+        void write_state(uint64_t value) override;
+        void write_state(double value) override;
+
+    protected:
+        // writes header of checkpoint file
+        void WriteHeader();
+        // writes buffered data to file (or image)
+        void FlushBuffer();
+
+    private:
+        // output file
+        std::ofstream m_file;
+        // output memory image (nullptr, if writing to file)
+        std::vector<unsigned char>* m_image;
+        // encoded data not written to file yet
+        std::vector<unsigned char> m_buffer;
+        // number of valid bytes in buffer
+        size_t m_position;
+        // were all writes successful?
+        bool m_good;
+};
@@ -0,0 +1,281 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "CoroutineProcess.h"
+
+#ifdef SIMLIB_COROUTINES
+
+#include "Simulation.h"
+#include "Event.h"
+
+#include <algorithm>
+
+// size of header preceding coroutine frame (keeps the frame aligned)
+static const size_t _frameHeaderSize = alignof(std::max_align_t);
+
+static_assert(sizeof(ObjectPool*) <= _frameHeaderSize, "Coroutine frame header is expected to hold the pool pointer");
+
+SimCoroutine::SimCoroutine(std::coroutine_handle<promise_type> handle)
+    : m_handle(handle)
+{
+    //
+}
+
+SimCoroutine::SimCoroutine(SimCoroutine&& other) noexcept
+    : m_handle(other.m_handle)
+{
+    other.m_handle = nullptr;
+}
+
+SimCoroutine& SimCoroutine::operator=(SimCoroutine&& other) noexcept
+{
+    if (this != &other)
+    {
+        if (m_handle)
+            m_handle.destroy();
+
+        m_handle = other.m_handle;
+        other.m_handle = nullptr;
+    }
+
+    return *this;
+}
+
+SimCoroutine::~SimCoroutine()
+{
+    if (m_handle)
+        m_handle.destroy();
+}
+
+std::coroutine_handle<> SimCoroutine::Release()
+{
+    std::coroutine_handle<> handle = m_handle;
+    m_handle = nullptr;
+
+    return handle;
+}
+
+void* SimCoroutine::AllocateFrame(SimCoroutineProcess* process, size_t typeId, size_t size)
+{
+    const size_t blockSize = _frameHeaderSize + size;
+
+    ObjectPool* pool = nullptr;
+    void* block = nullptr;
+
+    // pools are not thread-safe, so the frames started during parallel phase are taken from global allocator
+    if (process && !Simulation::IsDeferring())
+    {
+        SimulationPtr simulation = process->GetSimulation();
+        if (simulation)
+        {
+            process->m_framePool = simulation->GetObjectPool(typeId);
+            block = process->m_framePool->Allocate(blockSize);
+            if (block)
+                pool = process->m_framePool.get();
+        }
+    }
+
+    if (!block)
+        block = ::operator new(blockSize);
+
+    // the header remembers, where to return the frame
+    *static_cast<ObjectPool**>(block) = pool;
+
+    return static_cast<char*>(block) + _frameHeaderSize;
+}
+
+void SimCoroutine::ReleaseFrame(void* frame)
+{
+    void* block = static_cast<char*>(frame) - _frameHeaderSize;
+
+    ObjectPool* pool = *static_cast<ObjectPool**>(block);
+    if (pool)
+        pool->Deallocate(block);
+    else
+        ::operator delete(block);
+}
+
+SimCoroutineProcess::SimCoroutineProcess(SimulationPtr simulation, uint32_t objectClass)
+    : SimProcess(simulation, objectClass), m_finished(false), m_wait(WaitKind::NONE), m_waitFilter(0),
+      m_receivedEvent(0), m_receivedMessage()
+{
+    //
+}
+
+SimCoroutineProcess::~SimCoroutineProcess()
+{
+    // the frame must be returned while its pool is still held
+    DestroyBody();
+}
+
+void SimCoroutineProcess::Run()
+{
+    if (!m_coroutine)
+    {
+        if (m_finished)
+            return;
+
+        m_calendar = GetSimulation()->GetMainCalendar();
+        m_coroutine = Body().Release();
+    }
+
+    // body waiting for event or message was scheduled by someone else
+    if (m_wait != WaitKind::NONE)
+    {
+        m_wait = WaitKind::NONE;
+        m_receivedEvent = 0;
+        m_receivedMessage = SimulationMessage();
+    }
+
+    m_coroutine.resume();
+
+    if (m_coroutine.done())
+    {
+        DestroyBody();
+        m_finished = true;
+        Terminate();
+    }
+}
+
+void SimCoroutineProcess::ReceiveEvent(SimEvent& ev)
+{
+    if (m_wait != WaitKind::EVENT || (m_waitFilter != ObjectClass_NotSpecified && m_waitFilter != ev.GetObjectClass()))
+        return;
+
+    m_receivedEvent = ev.GetGUID();
+    Wake();
+}
+
+void SimCoroutineProcess::ReceiveMessage(SimulationMessage const& message)
+{
+    if (m_wait != WaitKind::MESSAGE || (m_waitFilter != SimCoroutine_AnyMessageKind && m_waitFilter != message.kind))
+    {
+        m_mailbox.push_back(message);
+        return;
+    }
+
+    m_receivedMessage = message;
+    Wake();
+}
+
+bool SimCoroutineProcess::IsStarted() const
+{
+    return m_coroutine || m_finished;
+}
+
+bool SimCoroutineProcess::IsFinished() const
+{
+    return m_finished;
+}
+
+bool SimCoroutineProcess::IsSerializable() const
+{
+    return !IsStarted();
+}
+
+void SimCoroutineProcess::Serialize(CheckpointWriter& writer) const
+{
+    writer.WriteBool(IsStarted());
+
+    writer.WriteVarUInt(m_mailbox.size());
+    for (auto& message : m_mailbox)
+        writer.WriteMessage(message);
+}
+
+bool SimCoroutineProcess::Deserialize(CheckpointReader& reader)
+{
+    // suspended body could not be restored
+    if (reader.ReadBool())
+        return false;
+
+    const uint64_t count = reader.ReadVarUInt();
+    m_mailbox.clear();
+    for (uint64_t i = 0; i < count && reader.IsGood(); i++)
+    {
+        SimulationMessage message;
+        if (reader.ReadMessage(message))
+            m_mailbox.push_back(message);
+    }
+
+    return reader.IsGood();
+}
+
+SimCoroutineProcess::HoldAwaiter SimCoroutineProcess::Hold(simtime_t delay)
+{
+    return HoldAwaiter{ *this, m_calendar, delay };
+}
+
+SimCoroutineProcess::HoldAwaiter SimCoroutineProcess::Hold(CalendarPtr const& calendar, simtime_t delay)
+{
+    return HoldAwaiter{ *this, calendar, delay };
+}
+
+SimCoroutineProcess::PassivateAwaiter SimCoroutineProcess::Passivate()
+{
+    return PassivateAwaiter{};
+}
+
+SimCoroutineProcess::EventAwaiter SimCoroutineProcess::WaitEvent(uint32_t eventClass)
+{
+    return EventAwaiter{ *this, eventClass };
+}
+
+SimCoroutineProcess::MessageAwaiter SimCoroutineProcess::WaitMessage(uint32_t kind)
+{
+    return MessageAwaiter{ *this, kind };
+}
+
+void SimCoroutineProcess::Reinitialize()
+{
+    DestroyBody();
+
+    m_finished = false;
+    m_calendar = nullptr;
+    m_wait = WaitKind::NONE;
+    m_receivedEvent = 0;
+    m_receivedMessage = SimulationMessage();
+    m_mailbox.clear();
+}
+
+void SimCoroutineProcess::WaitFor(WaitKind kind, uint32_t filter)
+{
+    m_wait = kind;
+    m_waitFilter = filter;
+    m_receivedEvent = 0;
+    m_receivedMessage = SimulationMessage();
+}
+
+bool SimCoroutineProcess::TakeMessage(uint32_t kind)
+{
+    auto itr = std::find_if(m_mailbox.begin(), m_mailbox.end(), [kind](SimulationMessage const& message) {
+        return kind == SimCoroutine_AnyMessageKind || message.kind == kind;
+    });
+
+    if (itr == m_mailbox.end())
+        return false;
+
+    m_receivedMessage = *itr;
+    m_mailbox.erase(itr);
+
+    return true;
+}
+
+void SimCoroutineProcess::Wake()
+{
+    m_wait = WaitKind::NONE;
+    Schedule(m_calendar, 0, true);
+}
+
+void SimCoroutineProcess::DestroyBody()
+{
+    if (m_coroutine)
+    {
+        m_coroutine.destroy();
+        m_coroutine = nullptr;
+    }
+}
+
+#endif
@@ -0,0 +1,254 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include "Process.h"
+
+// coroutine processes are available only when compiled with C++20 coroutine support
+#if defined(__cpp_impl_coroutine) && defined(__has_include)
+#if __has_include(<coroutine>)
+#define SIMLIB_COROUTINES
+#endif
+#endif
+
+#ifdef SIMLIB_COROUTINES
+
+#include <coroutine>
+#include <exception>
+#include <type_traits>
+#include <vector>
+
+class SimCoroutineProcess;
+
+// any message kind (see SimCoroutineProcess::WaitMessage)
+constexpr uint32_t SimCoroutine_AnyMessageKind = std::numeric_limits<uint32_t>::max();
+
+// tag type identifying pool of body frames of given process type
+template<typename P>
+struct SimCoroutine_Frame
+{
+    //
+};
+
+/*
+ * Coroutine of process body (see SimCoroutineProcess::Body)
+ *
+ * The coroutine starts suspended and its process resumes it whenever it's fired. The frame of process body is taken
+ * from object pool of simulation, so starting a body does not call global allocator in steady state
+ */
+class SimCoroutine
+{
+    public:
+        struct promise_type
+        {
+            SimCoroutine get_return_object()
+            {
+                return SimCoroutine(std::coroutine_handle<promise_type>::from_promise(*this));
+            }
+
+            std::suspend_always initial_suspend() noexcept { return {}; }
+            std::suspend_always final_suspend() noexcept { return {}; }
+            void return_void() { }
+            void unhandled_exception() { std::terminate(); }
+
+            // frame of member coroutine of process; the process is passed as implicit object parameter
+            template<typename P, typename = typename std::enable_if<std::is_base_of<SimCoroutineProcess, P>::value>::type>
+            static void* operator new(size_t size, P& process)
+            {
+                return AllocateFrame(&process, ObjectPool_TypeId<SimCoroutine_Frame<P>>(), size);
+            }
+
+            // frame of any other coroutine
+            static void* operator new(size_t size)
+            {
+                return AllocateFrame(nullptr, ObjectPool_NoTypeId, size);
+            }
+
+            static void operator delete(void* frame)
+            {
+                ReleaseFrame(frame);
+            }
+        };
+
+        SimCoroutine(SimCoroutine&& other) noexcept;
+        SimCoroutine& operator=(SimCoroutine&& other) noexcept;
+        ~SimCoroutine();
+
+        SimCoroutine(SimCoroutine const&) = delete;
+        SimCoroutine& operator=(SimCoroutine const&) = delete;
+
+        // passes ownership of coroutine frame to caller
+        std::coroutine_handle<> Release();
+
+    protected:
+        explicit SimCoroutine(std::coroutine_handle<promise_type> handle);
+
+        // allocates coroutine frame; frames of processes are taken from pool of process simulation (identified
+        // by typeId), other frames from global allocator
+        static void* AllocateFrame(SimCoroutineProcess* process, size_t typeId, size_t size);
+        // releases frame allocated by AllocateFrame
+        static void ReleaseFrame(void* frame);
+
+    private:
+        // owned coroutine
+        std::coroutine_handle<promise_type> m_handle;
+};
+
+/*
+ * Class representing a process, whose logic is written as a coroutine
+ *
+ * Instead of re-scheduling itself in Run method, the process suspends its body by co_await on simulation time
+ * (Hold), events (WaitEvent) or messages (WaitMessage). The process is scheduled as usual; when fired, its Run method
+ * resumes the body without any allocation. When the body returns, the process is terminated.
+ *
+ * Limitations: the body is resumed through the usual dispatch (virtual Run call of calendar entry), not directly from
+ * the calendar, and a body woken by event or message is scheduled to current time first, so every wake-up costs one
+ * calendar round trip. Started body could not be serialized, so the simulation containing started coroutine processes
+ * could be neither checkpointed nor forked (the checkpoint and fork fail)
+ */
+class SimCoroutineProcess : public SimProcess
+{
+    friend class Simulation;
+    friend class SimCoroutine;
+
+    public:
+        SimCoroutineProcess(SimulationPtr simulation = nullptr, uint32_t objectClass = ObjectClass_NotSpecified);
+        virtual ~SimCoroutineProcess();
+
+        // starts the body on the first call, resumes it on subsequent calls; do not override
+        virtual void Run() override;
+        // resumes body waiting for event; derived classes must call this implementation, when overriding
+        virtual void ReceiveEvent(SimEvent& ev) override;
+        // puts message to mailbox and resumes body waiting for it; derived classes must call this implementation,
+        // when overriding
+        virtual void ReceiveMessage(SimulationMessage const& message) override;
+
+        // was the body started?
+        bool IsStarted() const;
+        // has the body finished?
+        bool IsFinished() const;
+
+        // only process with body not started yet could be written, since the coroutine frame is not serializable
+        virtual bool IsSerializable() const override;
+        // writes state of body and mailbox
+        virtual void Serialize(CheckpointWriter& writer) const override;
+        // reads state written by Serialize; returns false, if the body was already started
+        virtual bool Deserialize(CheckpointReader& reader) override;
+
+    protected:
+        /*
+         * Awaiter of simulation time
+         */
+        struct HoldAwaiter
+        {
+            SimCoroutineProcess& process;
+            CalendarPtr const& calendar;
+            simtime_t delay;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<>) { process.Schedule(calendar, delay, true); }
+            void await_resume() const noexcept { }
+        };
+
+        /*
+         * Awaiter of passivation; resumed whenever the process is scheduled by someone else
+         */
+        struct PassivateAwaiter
+        {
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<>) const noexcept { }
+            void await_resume() const noexcept { }
+        };
+
+        /*
+         * Awaiter of event; resumes with GUID of received event (0, if the process was scheduled by someone else)
+         */
+        struct EventAwaiter
+        {
+            SimCoroutineProcess& process;
+            uint32_t eventClass;
+
+            bool await_ready() const noexcept { return false; }
+            void await_suspend(std::coroutine_handle<>) { process.WaitFor(WaitKind::EVENT, eventClass); }
+            uint64_t await_resume() const noexcept { return process.m_receivedEvent; }
+        };
+
+        /*
+         * Awaiter of message; resumes with the received message (message with target GUID 0, if the process was
+         * scheduled by someone else)
+         */
+        struct MessageAwaiter
+        {
+            SimCoroutineProcess& process;
+            uint32_t kind;
+
+            bool await_ready() { return process.TakeMessage(kind); }
+            void await_suspend(std::coroutine_handle<>) { process.WaitFor(WaitKind::MESSAGE, kind); }
+            SimulationMessage await_resume() const noexcept { return process.m_receivedMessage; }
+        };
+
+        // process body; runs when the process is fired for the first time, until the first co_await
+        virtual SimCoroutine Body() = 0;
+
+        // suspends body for given time; the process is scheduled to main calendar
+        HoldAwaiter Hold(simtime_t delay);
+        // suspends body for given time; the process is scheduled to given calendar
+        HoldAwaiter Hold(CalendarPtr const& calendar, simtime_t delay);
+        // suspends body until the process is scheduled by someone else
+        PassivateAwaiter Passivate();
+        // suspends body until an event (of given class) is executed on this process
+        EventAwaiter WaitEvent(uint32_t eventClass = ObjectClass_NotSpecified);
+        // suspends body until a message (of given kind) is received; messages received while not waiting are kept
+        // in mailbox
+        MessageAwaiter WaitMessage(uint32_t kind = SimCoroutine_AnyMessageKind);
+
+        // destroys body, so the recycled process starts it again; derived classes must call this implementation,
+        // when overriding
+        virtual void Reinitialize() override;
+
+    private:
+        /*
+         * What is the suspended body waiting for
+         */
+        enum class WaitKind
+        {
+            NONE,       // time or schedule by someone else
+            EVENT,      // event of class m_waitFilter (or any)
+            MESSAGE     // message of kind m_waitFilter (or any)
+        };
+
+        // suspended body
+        std::coroutine_handle<> m_coroutine;
+        // has the body finished?
+        bool m_finished;
+        // calendar used by Hold (main calendar of simulation)
+        CalendarPtr m_calendar;
+        // pool of body frames (kept, so the pool lives as long as the frame)
+        ObjectPoolPtr m_framePool;
+
+        // what is the body waiting for
+        WaitKind m_wait;
+        // event class or message kind the body is waiting for
+        uint32_t m_waitFilter;
+        // GUID of event, that resumed the body
+        uint64_t m_receivedEvent;
+        // message, that resumed the body
+        SimulationMessage m_receivedMessage;
+        // messages received while not waiting for them, in order of receive
+        std::vector<SimulationMessage> m_mailbox;
+
+        // marks body as waiting for event or message
+        void WaitFor(WaitKind kind, uint32_t filter);
+        // takes the first message of given kind from mailbox; returns false, if there's none
+        bool TakeMessage(uint32_t kind);
+        // wakes up waiting body at current simulation time
+        void Wake();
+        // destroys body frame
+        void DestroyBody();
+};
+
+#endif
@@ -0,0 +1,49 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include "Types.h"
+#include "SimulationMessage.h"
+
+/*
+ * Kinds of operations deferred during parallel dispatch
+ */
+enum class DeferredOperationKind
+{
+    SCHEDULE,               // SimulationObject::Schedule
+    UNSCHEDULE,             // removal from calendar (SimulationObject::CancelPeriodicSchedule)
+    TERMINATE_OBJECT,       // SimulationObject::Terminate
+    RECYCLE_OBJECT,         // SimulationObject::Recycle
+    TERMINATE_SIMULATION,   // Simulation::Terminate
+    SEND_MESSAGE,           // Simulation::SendMessage
+};
+
+/*
+ * Operation on shared simulation state (calendars, object registry, message queues) requested by object dispatched
+ * in parallel; the operations are applied after the parallel phase, in order of dispatch. The schedule info
+ * of object is updated right away, so the object sees its own schedule as usual - the previous one is remembered
+ * and restored before the operation is applied
+ */
+struct DeferredOperation
+{
+    // operation kind
+    DeferredOperationKind kind;
+    // object the operation is applied to (initiator of simulation termination)
+    SimulationObjectPtr object;
+    // calendar of object before the operation
+    CalendarPtr previousCalendar;
+    // scheduled time of object before the operation
+    simtime_t previousTime;
+    // target calendar (SCHEDULE)
+    CalendarPtr calendar;
+    // absolute schedule time (SCHEDULE), message delay (SEND_MESSAGE)
+    simtime_t time;
+    // exit code (TERMINATE_SIMULATION)
+    int64_t exitCode;
+    // message to be sent; target, kind and data are set (SEND_MESSAGE)
+    SimulationMessage message;
+};
@@ -12,8 +12,8 @@
 #include <algorithm>
 
 SimEvent::SimEvent(SimulationPtr simulation, uint32_t objectClass)
-    : SimulationObject(SimulationObjectType::EVENT, simulation, objectClass),
-      m_randomEngine(simulation->GetTrueRandomNumber())
+    : SimulationObject(SimulationObjectType::EVENT, simulation, objectClass), m_parallelExecution(false),
+      m_constructorCriterias(SimEvent_CriteriasUnknown), m_constructorParallelExecution(false)
 {
     //
 }
@@ -23,7 +23,45 @@ SimEvent::~SimEvent()
     //
 }
 
-void SimEvent::_AddSelectionCriteria(ObjectSelectionCriteria crit, uint64_t critParam, ObjectSelectionMode mode, uint32_t modeParam)
+void SimEvent::SeedRandomStreams(Simulation const& simulation)
+{
+    SimulationObject::SeedRandomStreams(simulation);
+
+    m_randomEngine.seed(simulation.GetRandomStreamKey(random_stream_selection), GetGUID());
+
+    // the constructor is surely done, when the event is added to simulation
+    KeepConstructorSettings();
+}
+
+void SimEvent::Reinitialize()
+{
+    SimulationObject::Reinitialize();
+
+    // criteria added after creation would be added again by whoever reuses the event
+    if (m_constructorCriterias != SimEvent_CriteriasUnknown)
+    {
+        m_criterias.resize(m_constructorCriterias);
+        m_parallelExecution = m_constructorParallelExecution;
+    }
+
+    m_selection.clear();
+}
+
+void SimEvent::KeepConstructorSettings()
+{
+    if (m_constructorCriterias != SimEvent_CriteriasUnknown)
+        return;
+
+    m_constructorCriterias = m_criterias.size();
+    m_constructorParallelExecution = m_parallelExecution;
+}
+
+void SimEvent::AddAttributeSelectionCriteria(uint32_t attributeId, int64_t value, ObjectSelectionMode mode, uint32_t modeParam)
+{
+    _AddSelectionCriteria(ObjectSelectionCriteria::ATTRIBUTE, static_cast<uint64_t>(value), mode, modeParam, attributeId);
+}
+
+void SimEvent::_AddSelectionCriteria(ObjectSelectionCriteria crit, uint64_t critParam, ObjectSelectionMode mode, uint32_t modeParam, uint32_t attributeId)
 {
     m_criterias.resize(m_criterias.size() + 1);
 
@@ -33,6 +71,7 @@ void SimEvent::_AddSelectionCriteria(ObjectSelectionCriteria crit, uint64_t crit
     m_criterias[i].critParam.asUInt64 = critParam;
     m_criterias[i].mode = mode;
     m_criterias[i].modeParam = modeParam;
+    m_criterias[i].attributeId = attributeId;
 }
 
 void SimEvent::Run()
@@ -42,73 +81,48 @@ void SimEvent::Run()
     if (!simulation)
         return;
 
-    SimulationObjectList objlist;
+    m_selection.clear();
 
     // not empty criterias - filter
     if (!m_criterias.empty())
     {
-        size_t i = 0;
-
-        SelectionCriteria& crit = m_criterias[i];
+        // criterias with mode ALL are plain filters, so all of them and the first criteria with other mode
+        // could be evaluated in any order - the planner picks the most selective index among them
+        size_t prefixEnd = 0;
+        while (prefixEnd < m_criterias.size() - 1 && m_criterias[prefixEnd].mode == ObjectSelectionMode::ALL)
+            prefixEnd++;
 
-        // the first filter is processed separatelly due to need of calling specialized version of "Get" method
-        // in fact this would not be needed, but instead of copying objects, this is slightly closer to being "optimal"
+        PerformPlannedSelection(simulation.get(), prefixEnd);
 
-        switch (crit.criteria)
+        // now apply the rest of criterias in a generic way
+        for (size_t i = prefixEnd + 1; i < m_criterias.size(); i++)
         {
-            case ObjectSelectionCriteria::GUID:
-            {
-                auto ptr = simulation->GetObjectByGUID(crit.critParam.asUInt64);
-                if (ptr)
-                    objlist.push_back(ptr);
+            // no need to apply more criterias, if the selection is empty
+            if (m_selection.empty())
                 break;
-            }
-            case ObjectSelectionCriteria::TYPE:
-            {
-                objlist = simulation->GetObjectsByType(crit.critParam.asSimType);
-                break;
-            }
-            case ObjectSelectionCriteria::CLASS:
-            {
-                objlist = simulation->GetObjectsByClass(crit.critParam.asUInt32);
-                break;
-            }
-        }
-
-        // also perform separate mode selection
-        PerformModeSelection(objlist, crit);
-
-        // now apply all criterias separatelly in a generic way
-        for (; i < m_criterias.size(); i++)
-        {
-            crit = m_criterias[i];
-
-            PerformCriteriaSelection(objlist, crit);
-            PerformModeSelection(objlist, crit);
 
-            // no need to apply more criterias, if the list is empty
-            if (objlist.empty())
-                break;
+            PerformFilterSelection(m_selection, m_criterias[i]);
         }
     }
     else // if no criterias at all - select all objects
-        objlist = simulation->GetAllObjects();
+    {
+        for (auto& obj : simulation->GetAllObjects())
+            m_selection.push_back(obj.get());
+    }
 
     // call user-defined filters
-    FilterObjects(objlist);
+    FilterObjects(m_selection);
 
     // now we are ready!
 
     BeforeExecute();
 
-    // iterate through all objects in list and execute event on them
-    for (auto obj : objlist)
-    {
-        ExecuteOn(obj);
-
-        if (obj->GetType() == SimulationObjectType::PROCESS)
-            obj->ToProcess()->ReceiveEvent(*this);
-    }
+    // execute event on all selected objects; objects removed meanwhile are kept alive by simulation until this event
+    // finishes
+    if (m_parallelExecution)
+        simulation->FanOut(m_selection.size(), [this](size_t first, size_t last) { ExecuteOnRange(first, last); });
+    else
+        ExecuteOnRange(0, m_selection.size());
 
     AfterExecute();
 
@@ -117,84 +131,345 @@ void SimEvent::Run()
         Terminate();
 }
 
-void SimEvent::PerformCriteriaSelection(SimulationObjectList& objList, SelectionCriteria& crit)
+void SimEvent::ExecuteOnRange(size_t first, size_t last)
+{
+    for (size_t i = first; i < last; i++)
+    {
+        SimulationObject* obj = m_selection[i];
+
+        ExecuteOn(*obj);
+
+        if (obj->GetType() == SimulationObjectType::PROCESS)
+            static_cast<SimProcess*>(obj)->ReceiveEvent(*this);
+    }
+}
+
+void SimEvent::SetParallelExecution(bool parallel)
+{
+    m_parallelExecution = parallel;
+}
+
+bool SimEvent::HasParallelExecution() const
+{
+    return m_parallelExecution;
+}
+
+void SimEvent::Serialize(CheckpointWriter& writer) const
 {
-    auto itr = objList.begin();
+    writer.WriteVarUInt(m_criterias.size());
+    for (auto& crit : m_criterias)
+    {
+        writer.WriteVarUInt(static_cast<uint64_t>(crit.criteria));
+        writer.WriteVarUInt(crit.critParam.asUInt64);
+        writer.WriteVarUInt(crit.attributeId);
+        writer.WriteVarUInt(static_cast<uint64_t>(crit.mode));
+        writer.WriteVarUInt(crit.modeParam);
+    }
 
+    writer.WriteBool(m_parallelExecution);
+    m_randomEngine.save(writer);
+}
+
+bool SimEvent::Deserialize(CheckpointReader& reader)
+{
+    // restored event was just constructed; the criteria added by constructor are replaced by the written ones, which
+    // start with the same criteria
+    KeepConstructorSettings();
+    m_criterias.clear();
+
+    const uint64_t count = reader.ReadVarUInt();
+    for (uint64_t i = 0; i < count && reader.IsGood(); i++)
+    {
+        const uint64_t criteria = reader.ReadVarUInt();
+        const uint64_t critParam = reader.ReadVarUInt();
+        const uint32_t attributeId = static_cast<uint32_t>(reader.ReadVarUInt());
+        const uint64_t mode = reader.ReadVarUInt();
+        const uint32_t modeParam = static_cast<uint32_t>(reader.ReadVarUInt());
+
+        if (criteria > static_cast<uint64_t>(ObjectSelectionCriteria::ATTRIBUTE) || mode > static_cast<uint64_t>(ObjectSelectionMode::K_OF_N))
+            return false;
+
+        _AddSelectionCriteria(static_cast<ObjectSelectionCriteria>(criteria), critParam, static_cast<ObjectSelectionMode>(mode), modeParam, attributeId);
+    }
+
+    m_parallelExecution = reader.ReadBool();
+
+    return m_randomEngine.load(reader) && reader.IsGood();
+}
+
+bool SimEvent::MatchesCriteria(const SimulationObject* obj, SelectionCriteria const& crit)
+{
     switch (crit.criteria)
     {
         case ObjectSelectionCriteria::GUID:
-            itr = std::remove_if(objList.begin(), objList.end(), [=](SimulationObjectPtr obj) { return obj->GetGUID() != crit.critParam.asUInt64; });
-            break;
+            return obj->GetGUID() == crit.critParam.asUInt64;
         case ObjectSelectionCriteria::TYPE:
-            itr = std::remove_if(objList.begin(), objList.end(), [=](SimulationObjectPtr obj) { return obj->GetType() != crit.critParam.asSimType; });
-            break;
+            return obj->GetType() == crit.critParam.asSimType;
         case ObjectSelectionCriteria::CLASS:
-            itr = std::remove_if(objList.begin(), objList.end(), [=](SimulationObjectPtr obj) { return obj->GetObjectClass() != crit.critParam.asUInt32; });
-            break;
+            return obj->GetObjectClass() == crit.critParam.asUInt32;
+        case ObjectSelectionCriteria::ATTRIBUTE:
+            return obj->HasAttribute(crit.attributeId) && obj->GetAttribute(crit.attributeId) == crit.critParam.asInt64;
     }
 
-    objList.erase(itr, objList.end());
+    return false;
 }
 
-void SimEvent::PerformModeSelection(SimulationObjectList& objList, SelectionCriteria& crit)
+bool SimEvent::GetIndexedSource(Simulation* simulation, SelectionCriteria const& crit, SimulationObjectPtr& guidObject, SimulationObjectView& source)
 {
-    switch (crit.mode)
+    switch (crit.criteria)
     {
-        case ObjectSelectionMode::ALL:
-            break;
-        case ObjectSelectionMode::ONE:
-        {
-            if (objList.size() <= 1)
-                return;
+        case ObjectSelectionCriteria::GUID:
+            guidObject = simulation->GetObjectByGUID(crit.critParam.asUInt64);
+            source = guidObject ? SimulationObjectView(&guidObject, &guidObject + 1) : SimulationObjectView();
+            return true;
+        case ObjectSelectionCriteria::TYPE:
+            source = simulation->GetObjectsByType(crit.critParam.asSimType);
+            return true;
+        case ObjectSelectionCriteria::CLASS:
+            source = simulation->GetObjectsByClass(crit.critParam.asUInt32);
+            return true;
+        case ObjectSelectionCriteria::ATTRIBUTE:
+            if (!simulation->HasAttributeIndex(crit.attributeId))
+                return false;
+            source = simulation->GetObjectsByAttribute(crit.attributeId, crit.critParam.asInt64);
+            return true;
+    }
 
-            // generate random index (will be used)
-            std::uniform_int_distribution<size_t> indexRandDist(0, objList.size() - 1);
-            size_t i = indexRandDist(m_randomEngine);
+    return false;
+}
+
+void SimEvent::PerformPlannedSelection(Simulation* simulation, size_t prefixEnd)
+{
+    SimulationObjectPtr guidObject;
+    SimulationObjectView source = simulation->GetAllObjects();
+    // index of criteria covered by source (two of them for composite index)
+    size_t covered[2] = { prefixEnd + 1, prefixEnd + 1 };
+
+    size_t typeCrit = prefixEnd + 1, classCrit = prefixEnd + 1;
+
+    // pick the smallest index - every object of the result is there, so the less objects to walk, the better
+    for (size_t i = 0; i <= prefixEnd; i++)
+    {
+        SelectionCriteria const& crit = m_criterias[i];
 
-            // move iterator to that "index"
-            auto itr = objList.begin();
-            std::advance(itr, i);
+        if (crit.criteria == ObjectSelectionCriteria::TYPE && typeCrit > prefixEnd)
+            typeCrit = i;
+        else if (crit.criteria == ObjectSelectionCriteria::CLASS && classCrit > prefixEnd)
+            classCrit = i;
 
-            // get pointer, erase list and put pointer back in
-            SimulationObjectPtr obj = *itr;
-            objList.clear();
-            objList.push_back(obj);
+        SimulationObjectPtr candidateObject;
+        SimulationObjectView candidate;
+        if (!GetIndexedSource(simulation, crit, candidateObject, candidate))
+            continue;
 
-            break;
+        if (candidate.size() < source.size() || covered[0] > prefixEnd)
+        {
+            // the GUID view points to the local pointer, so it has to be moved along
+            if (crit.criteria == ObjectSelectionCriteria::GUID)
+            {
+                guidObject = std::move(candidateObject);
+                candidate = guidObject ? SimulationObjectView(&guidObject, &guidObject + 1) : SimulationObjectView();
+            }
+
+            source = candidate;
+            covered[0] = i;
+            covered[1] = prefixEnd + 1;
         }
-        case ObjectSelectionMode::K_OF_N:
+    }
+
+    // composite index covers both type and class criteria
+    if (typeCrit <= prefixEnd && classCrit <= prefixEnd)
+    {
+        SimulationObjectView candidate = simulation->GetObjectsByTypeAndClass(m_criterias[typeCrit].critParam.asSimType, m_criterias[classCrit].critParam.asUInt32);
+        if (candidate.size() <= source.size())
         {
-            // no need to perform "0 of N"
-            if (crit.modeParam == 0)
+            source = candidate;
+            covered[0] = typeCrit;
+            covered[1] = classCrit;
+        }
+    }
+
+    // criteria not covered by source need to be evaluated on every object of the source
+    m_planFilters.clear();
+    for (size_t i = 0; i <= prefixEnd; i++)
+    {
+        if (i != covered[0] && i != covered[1])
+            m_planFilters.push_back(&m_criterias[i]);
+    }
+
+    SelectionCriteria const& modeCrit = m_criterias[prefixEnd];
+
+    // the source itself is the result, so the mode selection could use random access
+    if (m_planFilters.empty())
+    {
+        PerformSourceSelection(source, m_selection, modeCrit);
+        return;
+    }
+
+    for (auto& obj : source)
+    {
+        bool matches = true;
+        for (const SelectionCriteria* filter : m_planFilters)
+        {
+            if (!MatchesCriteria(obj.get(), *filter))
             {
-                objList.clear();
-                return;
+                matches = false;
+                break;
             }
+        }
 
-            // ..or "N of N" selection
-            if (crit.modeParam >= objList.size())
-                return;
+        if (matches)
+            m_selection.push_back(obj.get());
+    }
 
-            // shuffle the list
-            std::vector<SimulationObjectPtr> tmpVec(objList.begin(), objList.end());
-            std::shuffle(tmpVec.begin(), tmpVec.end(), m_randomEngine);
-            objList.assign(tmpVec.begin(), tmpVec.end());
+    PerformModeSelection(m_selection, modeCrit);
+}
 
-            // leave just first K elements
-            auto itr = objList.begin();
-            std::advance(itr, crit.modeParam);
+size_t SimEvent::GetModeSelectionCount(SelectionCriteria const& crit, size_t count)
+{
+    switch (crit.mode)
+    {
+        case ObjectSelectionMode::ONE:
+            return std::min<size_t>(count, 1);
+        case ObjectSelectionMode::K_OF_N:
+            return std::min<size_t>(count, crit.modeParam);
+        case ObjectSelectionMode::ALL:
+        default:
+            return count;
+    }
+}
+
+void SimEvent::SampleIndices(size_t total, size_t count)
+{
+    m_sampledIndices.clear();
+
+    // the hash set is kept at most half full; its size is power of two, so the hash could be masked
+    size_t capacity = 4;
+    while (capacity < 2 * count)
+        capacity *= 2;
+
+    const size_t mask = capacity - 1;
+    const size_t emptySlot = std::numeric_limits<size_t>::max();
+    m_sampledSet.assign(capacity, emptySlot);
+
+    // inserts index to set; returns false, if the index was already there
+    auto insert = [&](size_t index) -> bool {
+        size_t pos = (index * 0x9E3779B97F4A7C15ULL) & mask;
+        while (m_sampledSet[pos] != emptySlot)
+        {
+            if (m_sampledSet[pos] == index)
+                return false;
+            pos = (pos + 1) & mask;
+        }
+        m_sampledSet[pos] = index;
+        return true;
+    };
 
-            // the rest is erased
-            while (itr != objList.end())
-                itr = objList.erase(itr);
+    // Floyd's algorithm - every iteration adds exactly one new index, so it takes O(K) steps
+    for (size_t j = total - count; j < total; j++)
+    {
+        std::uniform_int_distribution<size_t> indexRandDist(0, j);
+        size_t t = indexRandDist(m_randomEngine);
 
-            break;
+        if (!insert(t))
+        {
+            insert(j);
+            t = j;
         }
+
+        m_sampledIndices.push_back(t);
     }
 }
 
-void SimEvent::FilterObjects(SimulationObjectList& objectList)
+void SimEvent::PerformSourceSelection(SimulationObjectView const& source, SimulationObjectSelection& selection, SelectionCriteria const& crit)
+{
+    const size_t count = GetModeSelectionCount(crit, source.size());
+
+    // select everything
+    if (count == source.size())
+    {
+        for (auto& obj : source)
+            selection.push_back(obj.get());
+        return;
+    }
+
+    // select one random element
+    if (count == 1)
+    {
+        std::uniform_int_distribution<size_t> indexRandDist(0, source.size() - 1);
+        selection.push_back(source[indexRandDist(m_randomEngine)].get());
+        return;
+    }
+
+    // select K of N elements
+    SampleIndices(source.size(), count);
+
+    for (size_t index : m_sampledIndices)
+        selection.push_back(source[index].get());
+}
+
+void SimEvent::PerformModeSelection(SimulationObjectSelection& selection, SelectionCriteria const& crit)
+{
+    const size_t count = GetModeSelectionCount(crit, selection.size());
+    if (count == selection.size())
+        return;
+
+    // partial Fisher-Yates shuffle - just the first "count" positions are drawn, so it takes O(K) steps
+    for (size_t i = 0; i < count; i++)
+    {
+        std::uniform_int_distribution<size_t> indexRandDist(i, selection.size() - 1);
+        std::swap(selection[i], selection[indexRandDist(m_randomEngine)]);
+    }
+
+    selection.resize(count);
+}
+
+void SimEvent::PerformFilterSelection(SimulationObjectSelection& selection, SelectionCriteria const& crit)
+{
+    // no need to perform "0 of N"
+    if (crit.mode == ObjectSelectionMode::K_OF_N && crit.modeParam == 0)
+    {
+        selection.clear();
+        return;
+    }
+
+    // plain filter
+    if (crit.mode == ObjectSelectionMode::ALL)
+    {
+        auto itr = std::remove_if(selection.begin(), selection.end(), [&crit](SimulationObject* obj) { return !MatchesCriteria(obj, crit); });
+        selection.erase(itr, selection.end());
+        return;
+    }
+
+    // the number of matching objects is not known in advance, so perform reservoir sampling of matching objects;
+    // the reservoir is stored in the beginning of the selection itself - the reservoir position is always lower
+    // than the position being read, so no unread object is overwritten
+    const size_t reservoirSize = (crit.mode == ObjectSelectionMode::ONE) ? 1 : crit.modeParam;
+    size_t matched = 0;
+
+    for (size_t i = 0; i < selection.size(); i++)
+    {
+        SimulationObject* obj = selection[i];
+        if (!MatchesCriteria(obj, crit))
+            continue;
+
+        if (matched < reservoirSize)
+            selection[matched] = obj;
+        else
+        {
+            std::uniform_int_distribution<size_t> indexRandDist(0, matched);
+            size_t j = indexRandDist(m_randomEngine);
+            if (j < reservoirSize)
+                selection[j] = obj;
+        }
+
+        matched++;
+    }
+
+    selection.resize(std::min(matched, reservoirSize));
+}
+
+void SimEvent::FilterObjects(SimulationObjectSelection& selection)
 {
     //
 }
@@ -209,7 +484,27 @@ void SimEvent::AfterExecute()
     //
 }
 
-void SimEvent::ExecuteOn(SimulationObjectPtr object)
+void SimEvent::ExecuteOn(SimulationObject& object)
 {
     //
 }
+
+void SimEvent::FilterObjects(SimulationObjectList& objectList)
+{
+    SimulationObjectSelection selection;
+    for (auto& obj : objectList)
+        selection.push_back(obj.get());
+
+    FilterObjects(selection);
+
+    // the selection holds plain pointers, the list needs owning ones
+    SimulationObjectList filtered;
+    for (auto obj : selection)
+        filtered.push_back(obj->shared_from_this());
+    objectList.swap(filtered);
+}
+
+void SimEvent::ExecuteOn(SimulationObjectPtr object)
+{
+    ExecuteOn(*object);
+}
@@ -18,7 +18,8 @@ enum class ObjectSelectionCriteria
 {
     GUID,       // select by object GUID
     TYPE,       // select by object type
-    CLASS       // select by object class
+    CLASS,      // select by object class
+    ATTRIBUTE   // select by value of user attribute
 };
 
 /*
@@ -31,11 +32,16 @@ enum class ObjectSelectionMode
     K_OF_N      // selects K of total of N elements; parameter: K
 };
 
+// number of criteria added by constructor is not known yet
+constexpr size_t SimEvent_CriteriasUnknown = std::numeric_limits<size_t>::max();
+
 /*
  * Class representing a simulation event
  */
 class SimEvent : public SimulationObject
 {
+    friend class Simulation;
+
     public:
         SimEvent(SimulationPtr simulation = nullptr, uint32_t objectClass = ObjectClass_NotSpecified);
         virtual ~SimEvent();
@@ -46,20 +52,51 @@ class SimEvent : public SimulationObject
         {
             _AddSelectionCriteria(crit, (uint64_t)critParam, mode, modeParam);
         }
+        // adds event criteria for affected elements by value of user attribute; the attribute should be indexed
+        // in simulation, otherwise all objects need to be walked
+        void AddAttributeSelectionCriteria(uint32_t attributeId, int64_t value, ObjectSelectionMode mode, uint32_t modeParam = 0);
 
         // run event execution; select objects and execute on them
         void Run() override final;
 
         // filters objects before execution; empty implementation here, may be overriden
-        virtual void FilterObjects(SimulationObjectList& objectList);
+        virtual void FilterObjects(SimulationObjectSelection& selection);
         // called before event execution on all selected objects
         virtual void BeforeExecute();
         // called after event execution on all selected objects
         virtual void AfterExecute();
         // execute event on specified object; called from Run method
-        virtual void ExecuteOn(SimulationObjectPtr object);
+        virtual void ExecuteOn(SimulationObject& object);
+
+        // former signatures, forwarding to the current ones; they are final, so the derived events still overriding
+        // them fail to compile instead of never being called
+        [[deprecated("override FilterObjects(SimulationObjectSelection&) instead")]]
+        virtual void FilterObjects(SimulationObjectList& objectList) final;
+        [[deprecated("override ExecuteOn(SimulationObject&) instead")]]
+        virtual void ExecuteOn(SimulationObjectPtr object) final;
+
+        // is the execution on selected objects independent, so it could be fanned out to dispatch threads?
+        bool HasParallelExecution() const;
+
+        // writes selection criteria and state of selection random engine; derived events should call this method
+        // when overriding it
+        void Serialize(CheckpointWriter& writer) const override;
+        bool Deserialize(CheckpointReader& reader) override;
 
     protected:
+        void SeedRandomStreams(Simulation const& simulation) override;
+        // drops criteria added after the event was created, so the reused event has just the criteria added by its
+        // constructor; derived events must call this implementation, when overriding
+        void Reinitialize() override;
+
+        // declares, that the execution on every selected object (ExecuteOn and ReceiveEvent) touches just that object,
+        // so large selections could be executed in parallel; schedules, terminations and sent messages requested
+        // meanwhile are applied after all objects, in order of selection
+        void SetParallelExecution(bool parallel);
+
+        // executes event on selected objects in given range of selection
+        void ExecuteOnRange(size_t first, size_t last);
+
         /*
          * Structure of selection criteria used
          */
@@ -77,6 +114,8 @@ class SimEvent : public SimulationObject
                 int32_t asInt32;
                 SimulationObjectType asSimType;
             } critParam;
+            // user attribute identifier (ATTRIBUTE criteria only)
+            uint32_t attributeId;
 
             // selection mode for filtering
             ObjectSelectionMode mode;
@@ -84,17 +123,48 @@ class SimEvent : public SimulationObject
             uint32_t modeParam;
         };
 
-        // performs criteria selection (primary filter) on given list
-        void PerformCriteriaSelection(SimulationObjectList& objList, SelectionCriteria& crit);
-        // performs mode selection (secondary filter) on given list
-        void PerformModeSelection(SimulationObjectList& objList, SelectionCriteria& crit);
+        // does the object match given criteria?
+        static bool MatchesCriteria(const SimulationObject* obj, SelectionCriteria const& crit);
+        // retrieves number of objects to be selected by criteria mode from total of given count
+        static size_t GetModeSelectionCount(SelectionCriteria const& crit, size_t count);
+
+        // retrieves objects matching criteria from simulation index; returns false, if there's no suitable index
+        static bool GetIndexedSource(Simulation* simulation, SelectionCriteria const& crit, SimulationObjectPtr& guidObject, SimulationObjectView& source);
+        // selects the most selective index for criteria, that could be evaluated in any order, and fills the selection
+        void PerformPlannedSelection(Simulation* simulation, size_t prefixEnd);
+
+        // performs mode selection (secondary filter) on random-access source and appends result to selection
+        void PerformSourceSelection(SimulationObjectView const& source, SimulationObjectSelection& selection, SelectionCriteria const& crit);
+        // performs criteria selection (primary filter) and mode selection (secondary filter) in place, in a single pass
+        void PerformFilterSelection(SimulationObjectSelection& selection, SelectionCriteria const& crit);
+        // performs mode selection (secondary filter) in place
+        void PerformModeSelection(SimulationObjectSelection& selection, SelectionCriteria const& crit);
+        // samples given count of distinct indices from range [0; total) into m_sampledIndices
+        void SampleIndices(size_t total, size_t count);
 
         // internal method for adding selection criteria
-        void _AddSelectionCriteria(ObjectSelectionCriteria crit, uint64_t critParam, ObjectSelectionMode mode, uint32_t modeParam = 0);
+        void _AddSelectionCriteria(ObjectSelectionCriteria crit, uint64_t critParam, ObjectSelectionMode mode, uint32_t modeParam = 0, uint32_t attributeId = 0);
 
     private:
         // vector of criterias
         std::vector<SelectionCriteria> m_criterias;
-        // instance of random engine used
-        std::mt19937 m_randomEngine;
+        // selected objects; kept between runs to reuse allocated memory
+        SimulationObjectSelection m_selection;
+        // criteria not covered by the index chosen by planner
+        std::vector<const SelectionCriteria*> m_planFilters;
+        // indices sampled from selection source
+        std::vector<size_t> m_sampledIndices;
+        // open-addressing hash set of sampled indices (used during sampling)
+        std::vector<size_t> m_sampledSet;
+        // random engine used for selection; seeded with selection stream of this event
+        philox4x32_engine m_randomEngine;
+        // could the execution be fanned out to dispatch threads?
+        bool m_parallelExecution;
+        // number of criteria added by constructor (SimEvent_CriteriasUnknown until the event is added to simulation)
+        size_t m_constructorCriterias;
+        // parallel execution flag set by constructor
+        bool m_constructorParallelExecution;
+
+        // remembers criteria and flags set by constructor, if not yet remembered
+        void KeepConstructorSettings();
 };
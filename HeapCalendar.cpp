@@ -0,0 +1,159 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "SimulationObject.h"
+#include "HeapCalendar.h"
+
+HeapCalendar::HeapCalendar()
+    : Calendar(CalendarEngine::BINARY_HEAP)
+{
+    //
+}
+
+HeapCalendar::~HeapCalendar()
+{
+    //
+}
+
+bool HeapCalendar::empty() const
+{
+    return m_heap.empty();
+}
+
+size_t HeapCalendar::size() const
+{
+    return m_heap.size();
+}
+
+CalendarEntry const& HeapCalendar::top_entry() const
+{
+    return m_heap.front();
+}
+
+void HeapCalendar::PlaceEntry(size_t pos, CalendarEntry const& entry)
+{
+    m_slots[entry.handle].location = pos;
+    m_heap[pos] = entry;
+}
+
+size_t HeapCalendar::SiftUp(size_t pos)
+{
+    CalendarEntry entry = m_heap[pos];
+
+    // move parents down while they are scheduled later than sifted entry
+    while (pos > 0)
+    {
+        size_t parent = (pos - 1) / 2;
+        if (!m_cmp(m_heap[parent], entry))
+            break;
+
+        PlaceEntry(pos, m_heap[parent]);
+        pos = parent;
+    }
+
+    PlaceEntry(pos, entry);
+    return pos;
+}
+
+size_t HeapCalendar::SiftDown(size_t pos)
+{
+    const size_t count = m_heap.size();
+    CalendarEntry entry = m_heap[pos];
+
+    // move the sooner child up while it is scheduled sooner than sifted entry
+    while (true)
+    {
+        size_t child = 2 * pos + 1;
+        if (child >= count)
+            break;
+
+        if (child + 1 < count && m_cmp(m_heap[child], m_heap[child + 1]))
+            child++;
+
+        if (!m_cmp(entry, m_heap[child]))
+            break;
+
+        PlaceEntry(pos, m_heap[child]);
+        pos = child;
+    }
+
+    PlaceEntry(pos, entry);
+    return pos;
+}
+
+CalendarHandle HeapCalendar::PushEntry(SimulationObjectPtr const& obj)
+{
+    CalendarEntry entry = CreateEntry(obj);
+
+    m_heap.push_back(entry);
+    SiftUp(m_heap.size() - 1);
+
+    return entry.handle;
+}
+
+void HeapCalendar::RemoveAt(size_t pos)
+{
+    ReleaseEntry(m_heap[pos].handle);
+
+    // move the last entry to the vacated position and restore heap property from there
+    const size_t last = m_heap.size() - 1;
+    if (pos != last)
+    {
+        m_heap[pos] = m_heap[last];
+        m_heap.pop_back();
+
+        if (SiftUp(pos) == pos)
+            SiftDown(pos);
+    }
+    else
+        m_heap.pop_back();
+}
+
+void HeapCalendar::PopEntry()
+{
+    if (m_heap.empty())
+        return;
+
+    RemoveAt(0);
+}
+
+bool HeapCalendar::FindPosition(CalendarHandle handle, size_t& pos) const
+{
+    if (handle >= m_slots.size())
+        return false;
+
+    pos = static_cast<size_t>(m_slots[handle].location);
+
+    // the handle may belong to another calendar or may be already released
+    return (pos < m_heap.size() && m_heap[pos].handle == handle);
+}
+
+bool HeapCalendar::RemoveEntry(CalendarHandle handle)
+{
+    size_t pos;
+    if (!FindPosition(handle, pos))
+        return false;
+
+    RemoveAt(pos);
+    return true;
+}
+
+void HeapCalendar::UpdateEntry(CalendarHandle handle)
+{
+    size_t pos;
+    if (!FindPosition(handle, pos))
+        return;
+
+    RefreshEntry(m_heap[pos]);
+
+    if (SiftUp(pos) == pos)
+        SiftDown(pos);
+}
+
+void HeapCalendar::CollectEntries(std::vector<CalendarEntry>& entries) const
+{
+    entries.insert(entries.end(), m_heap.begin(), m_heap.end());
+}
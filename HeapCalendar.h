@@ -0,0 +1,48 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include "Calendar.h"
+
+/*
+ * Calendar implemented as an indexed binary heap - the handle of every entry tracks its position within
+ * the heap, so the object could be removed or moved (rescheduled) in O(log n)
+ */
+class HeapCalendar : public Calendar
+{
+    public:
+        HeapCalendar();
+        virtual ~HeapCalendar();
+
+        bool empty() const override;
+        size_t size() const override;
+
+        CalendarEntry const& top_entry() const override;
+
+    protected:
+        CalendarHandle PushEntry(SimulationObjectPtr const& obj) override;
+        void PopEntry() override;
+        bool RemoveEntry(CalendarHandle handle) override;
+        void UpdateEntry(CalendarHandle handle) override;
+        void CollectEntries(std::vector<CalendarEntry>& entries) const override;
+
+        // moves entry at given position up, until heap property is restored; returns final position
+        size_t SiftUp(size_t pos);
+        // moves entry at given position down, until heap property is restored; returns final position
+        size_t SiftDown(size_t pos);
+        // places entry to given position and updates its location
+        void PlaceEntry(size_t pos, CalendarEntry const& entry);
+        // removes entry at given heap position
+        void RemoveAt(size_t pos);
+        // retrieves heap position of entry with given handle; returns false if the handle is not present
+        bool FindPosition(CalendarHandle handle, size_t& pos) const;
+
+        // binary heap of calendar entries
+        std::vector<CalendarEntry> m_heap;
+        // comparator used for heap ordering
+        TimePriorityCmp m_cmp;
+};
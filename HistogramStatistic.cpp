@@ -0,0 +1,170 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "HistogramStatistic.h"
+#include "Simulation.h"
+#include "CheckpointWriter.h"
+#include "CheckpointReader.h"
+
+#include <cmath>
+#include <algorithm>
+
+HistogramStatistic::HistogramStatistic(double minValue, double maxValue, size_t binCount)
+    : m_count(0)
+{
+    // the range must be positive and non-empty
+    m_minValue = (minValue > 0.0) ? minValue : 1.0;
+    m_maxValue = (maxValue > m_minValue) ? maxValue : m_minValue * 2.0;
+    binCount = std::max<size_t>(binCount, 1);
+
+    m_scale = static_cast<double>(binCount) / std::log(m_maxValue / m_minValue);
+    m_bins.resize(binCount + 2, 0);
+}
+
+void HistogramStatistic::Add(double value)
+{
+    // statistics are shared by objects, so they could not be updated during parallel phase
+    assert(!Simulation::IsDeferring());
+
+    m_count++;
+
+    if (!(value >= m_minValue))
+    {
+        m_bins.front()++;
+        return;
+    }
+
+    if (value >= m_maxValue)
+    {
+        m_bins.back()++;
+        return;
+    }
+
+    // rounding may push values just below the upper bound past the last bin
+    const size_t bin = std::min(static_cast<size_t>(std::log(value / m_minValue) * m_scale), GetBinCount() - 1);
+    m_bins[bin + 1]++;
+}
+
+bool HistogramStatistic::Merge(HistogramStatistic const& other)
+{
+    if (!HasSameLayout(other))
+        return false;
+
+    for (size_t i = 0; i < m_bins.size(); i++)
+        m_bins[i] += other.m_bins[i];
+
+    m_count += other.m_count;
+
+    return true;
+}
+
+void HistogramStatistic::Reset()
+{
+    std::fill(m_bins.begin(), m_bins.end(), 0);
+    m_count = 0;
+}
+
+void HistogramStatistic::Serialize(CheckpointWriter& writer) const
+{
+    writer.WriteDouble(m_minValue);
+    writer.WriteDouble(m_maxValue);
+    writer.WriteVarUInt(GetBinCount());
+    writer.WriteVarUInt(m_count);
+
+    for (uint64_t observations : m_bins)
+        writer.WriteVarUInt(observations);
+}
+
+bool HistogramStatistic::Deserialize(CheckpointReader& reader)
+{
+    const double minValue = reader.ReadDouble();
+    const double maxValue = reader.ReadDouble();
+    const uint64_t binCount = reader.ReadVarUInt();
+
+    if (!reader.IsGood())
+        return false;
+
+    HistogramStatistic layout(minValue, maxValue, static_cast<size_t>(binCount));
+    if (!HasSameLayout(layout))
+        *this = layout;
+
+    // the layout is adjusted by constructor, when it's not valid
+    if (m_minValue != minValue || m_maxValue != maxValue || GetBinCount() != binCount)
+        return false;
+
+    m_count = reader.ReadVarUInt();
+    for (auto& observations : m_bins)
+        observations = reader.ReadVarUInt();
+
+    return reader.IsGood();
+}
+
+uint64_t HistogramStatistic::GetCount() const
+{
+    return m_count;
+}
+
+size_t HistogramStatistic::GetBinCount() const
+{
+    return m_bins.size() - 2;
+}
+
+double HistogramStatistic::GetBinLowerBound(size_t bin) const
+{
+    return m_minValue * std::exp(static_cast<double>(bin) / m_scale);
+}
+
+double HistogramStatistic::GetBinUpperBound(size_t bin) const
+{
+    return (bin + 1 >= GetBinCount()) ? m_maxValue : GetBinLowerBound(bin + 1);
+}
+
+uint64_t HistogramStatistic::GetBinObservations(size_t bin) const
+{
+    return (bin < GetBinCount()) ? m_bins[bin + 1] : 0;
+}
+
+uint64_t HistogramStatistic::GetUnderflowCount() const
+{
+    return m_bins.front();
+}
+
+uint64_t HistogramStatistic::GetOverflowCount() const
+{
+    return m_bins.back();
+}
+
+double HistogramStatistic::GetQuantile(double q) const
+{
+    if (m_count == 0)
+        return 0.0;
+
+    q = std::min(std::max(q, 0.0), 1.0);
+    const double position = q * static_cast<double>(m_count);
+
+    double countSoFar = static_cast<double>(m_bins.front());
+    if (position <= countSoFar)
+        return m_minValue;
+
+    for (size_t bin = 0; bin < GetBinCount(); bin++)
+    {
+        const double binCount = static_cast<double>(m_bins[bin + 1]);
+        if (position <= countSoFar + binCount)
+        {
+            const double fraction = (position - countSoFar) / binCount;
+            return GetBinLowerBound(bin) * std::pow(GetBinUpperBound(bin) / GetBinLowerBound(bin), fraction);
+        }
+
+        countSoFar += binCount;
+    }
+
+    return m_maxValue;
+}
+
+bool HistogramStatistic::HasSameLayout(HistogramStatistic const& other) const
+{
+    return m_minValue == other.m_minValue && m_maxValue == other.m_maxValue && m_bins.size() == other.m_bins.size();
+}
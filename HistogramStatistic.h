@@ -0,0 +1,73 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// default number of bins of histogram statistic
+constexpr size_t HistogramStatistic_DefaultBinCount = 64;
+
+/*
+ * Histogram of observed values with fixed logarithmic bins
+ *
+ * The range (min, max) is split to bins of the same relative width, so the histogram keeps the same relative
+ * resolution for values of different orders (e.g. response times from microseconds to seconds). Values below
+ * the range (including zero and negative values) fall to underflow bin, values above it to overflow bin. Histograms
+ * with the same layout could be merged
+ */
+class HistogramStatistic
+{
+    public:
+        HistogramStatistic(double minValue = 1.0, double maxValue = 1e6, size_t binCount = HistogramStatistic_DefaultBinCount);
+
+        // adds observed value
+        void Add(double value);
+        // merges histogram of other observations; returns false, if the histograms have different layout
+        bool Merge(HistogramStatistic const& other);
+        // forgets all observations
+        void Reset();
+        // writes layout and observations to checkpoint
+        void Serialize(CheckpointWriter& writer) const;
+        // reads layout and observations written by Serialize; returns false, if the state is not valid
+        bool Deserialize(CheckpointReader& reader);
+
+        // retrieves number of observations
+        uint64_t GetCount() const;
+        // retrieves number of regular bins
+        size_t GetBinCount() const;
+        // retrieves lower bound of regular bin
+        double GetBinLowerBound(size_t bin) const;
+        // retrieves upper bound of regular bin
+        double GetBinUpperBound(size_t bin) const;
+        // retrieves number of observations within regular bin
+        uint64_t GetBinObservations(size_t bin) const;
+        // retrieves number of observations below the range
+        uint64_t GetUnderflowCount() const;
+        // retrieves number of observations above the range
+        uint64_t GetOverflowCount() const;
+        // retrieves estimate of given quantile (0 - 1); interpolated geometrically within bin, clamped to the range
+        double GetQuantile(double q) const;
+        // has the other histogram the same layout?
+        bool HasSameLayout(HistogramStatistic const& other) const;
+
+    private:
+        // lower bound of range
+        double m_minValue;
+        // upper bound of range
+        double m_maxValue;
+        // number of bins per unit of natural logarithm of value
+        double m_scale;
+        // counts of underflow bin, regular bins and overflow bin
+        std::vector<uint64_t> m_bins;
+        // number of observations
+        uint64_t m_count;
+};
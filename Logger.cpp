@@ -5,26 +5,337 @@
  ************************************************************/
 
 #include "Logger.h"
+#include "Simulation.h"
+
+#include <cstring>
+#include <algorithm>
+
+// number of rounds the writer yields on empty ring before it goes to sleep
+static const size_t _writerIdleRounds = 16;
 
 LoggerLineGuard::LoggerLineGuard(Logger& logger)
     : m_logger(logger)
 {
-    //
+    // line buffer and ring are not shared by threads of parallel phase
+    assert(!Simulation::IsDeferring());
 }
 
 LoggerLineGuard::~LoggerLineGuard()
 {
     // write endline at the end of writing
-    m_logger.Write(Logger::endl());
+    m_logger.EndLine();
 }
 
 Logger::Logger(std::ostream& outFile)
-    : m_outputFile(outFile)
+    : m_outputFile(outFile), m_lineOutput(&outFile), m_level(LogLevel::TRACE), m_categoryMask(LogCategory_All), m_async(false), m_backPressure(LoggerBackPressure::BLOCK),
+      m_droppedCount(0), m_flushRequested(false), m_stopRequested(false), m_writerSleeping(false)
 {
-    //
+    UpdateEnabledCategories();
 }
 
 Logger::~Logger()
 {
-    //
+    StopAsync();
+}
+
+void Logger::SetLevel(LogLevel level)
+{
+    m_level = level;
+    UpdateEnabledCategories();
+}
+
+LogLevel Logger::GetLevel() const
+{
+    return m_level;
+}
+
+void Logger::SetCategoryMask(uint32_t mask)
+{
+    m_categoryMask = mask;
+    UpdateEnabledCategories();
+}
+
+uint32_t Logger::GetCategoryMask() const
+{
+    return m_categoryMask;
+}
+
+void Logger::UpdateEnabledCategories()
+{
+    for (size_t i = 0; i < LogLevelCount; i++)
+        m_enabledCategories[i] = (i >= static_cast<size_t>(m_level) && i != static_cast<size_t>(LogLevel::NONE)) ? m_categoryMask : 0;
+}
+
+void Logger::EndLine()
+{
+    if (!m_async)
+    {
+        m_outputFile << endl();
+        return;
+    }
+
+    const std::string line = m_lineBuffer.str();
+    m_lineBuffer.str(std::string());
+
+    // split line to text records
+    const size_t recordCount = (line.size() + LogRecord_TextCapacity - 1) / LogRecord_TextCapacity;
+
+    // the line is either written whole, or dropped whole
+    if (m_backPressure == LoggerBackPressure::DROP && m_ring.Free() < std::max<size_t>(recordCount, 1))
+    {
+        m_droppedCount += std::max<size_t>(recordCount, 1);
+        return;
+    }
+
+    LogRecord record;
+    record.kind = LogRecordKind::TEXT;
+    record.reserved = 0;
+
+    size_t offset = 0;
+    do
+    {
+        const size_t length = std::min(line.size() - offset, LogRecord_TextCapacity);
+        std::memcpy(record.text, line.data() + offset, length);
+        record.textLength = static_cast<uint16_t>(length);
+        offset += length;
+        record.lineEnd = (offset == line.size());
+
+        PushRecord(record);
+    } while (offset < line.size());
+}
+
+void Logger::LogObject(LogRecordKind kind, simtime_t time, uint64_t guid, uint32_t objectType, uint32_t objectClass)
+{
+    // ring is not shared by threads of parallel phase
+    assert(!Simulation::IsDeferring());
+
+    LogRecord record;
+    record.kind = kind;
+    record.lineEnd = true;
+    record.textLength = 0;
+    record.reserved = 0;
+    record.object.time = time;
+    record.object.guid = guid;
+    record.object.objectType = objectType;
+    record.object.objectClass = objectClass;
+
+    if (m_async)
+    {
+        PushRecord(record);
+        return;
+    }
+
+    m_syncBuffer.clear();
+    FormatRecord(record, m_syncBuffer);
+    m_outputFile.write(m_syncBuffer.data(), m_syncBuffer.size());
+}
+
+void Logger::PushRecord(LogRecord const& record)
+{
+    if (!m_ring.TryPush(record))
+    {
+        if (m_backPressure == LoggerBackPressure::DROP)
+        {
+            m_droppedCount++;
+            return;
+        }
+
+        // full ring is being written out; wait for free space
+        while (!m_ring.TryPush(record))
+            std::this_thread::yield();
+    }
+
+    WakeWriter();
+}
+
+void Logger::WakeWriter()
+{
+    // the writer marks itself sleeping before it checks the ring for the last time, so either it sees the pushed
+    // record, or this thread sees the mark (pairs with the fence in WriterThread)
+    std::atomic_thread_fence(std::memory_order_seq_cst);
+    if (!m_writerSleeping.load(std::memory_order_relaxed))
+        return;
+
+    std::lock_guard<std::mutex> lock(m_writerMutex);
+    m_writerSleeping.store(false, std::memory_order_relaxed);
+    m_writerWakeup.notify_one();
+}
+
+// appends decimal representation of number to string
+static void AppendNumber(std::string& out, uint64_t value)
+{
+    char digits[20];
+    size_t count = 0;
+    do
+    {
+        digits[count++] = static_cast<char>('0' + value % 10);
+        value /= 10;
+    } while (value > 0);
+
+    while (count > 0)
+        out.push_back(digits[--count]);
+}
+
+void Logger::FormatRecord(LogRecord const& record, std::string& out)
+{
+    switch (record.kind)
+    {
+        case LogRecordKind::TEXT:
+            out.append(record.text, record.textLength);
+            if (record.lineEnd)
+                out.push_back(endl());
+            return;
+        case LogRecordKind::OBJECT_FIRED:
+            out.push_back('[');
+            AppendNumber(out, record.object.time);
+            out.append("] Object ");
+            AppendNumber(out, record.object.guid);
+            out.append(" (type: ");
+            AppendNumber(out, record.object.objectType);
+            out.append(", class: ");
+            AppendNumber(out, record.object.objectClass);
+            out.append(") fired");
+            break;
+        case LogRecordKind::OBJECT_ADDED:
+        case LogRecordKind::OBJECT_REMOVED:
+            out.push_back('[');
+            AppendNumber(out, record.object.time);
+            out.append(record.kind == LogRecordKind::OBJECT_ADDED ? "] Adding" : "] Removing");
+            out.append(" object (GUID: ");
+            AppendNumber(out, record.object.guid);
+            out.append(", type: ");
+            AppendNumber(out, record.object.objectType);
+            out.append(", class: ");
+            AppendNumber(out, record.object.objectClass);
+            out.push_back(')');
+            break;
+    }
+
+    out.push_back(endl());
+}
+
+void Logger::StartAsync(size_t ringCapacity, LoggerBackPressure backPressure)
+{
+    if (m_async)
+        StopAsync();
+
+    m_outputFile.flush();
+
+    m_backPressure = backPressure;
+    // the ring must hold at least one record, otherwise the blocking push would never succeed
+    m_ring.Reset(std::max<size_t>(ringCapacity, 1));
+    m_droppedCount = 0;
+    m_flushRequested = false;
+    m_stopRequested = false;
+
+    m_async = true;
+    m_lineOutput = &m_lineBuffer;
+
+    m_writer = std::thread(&Logger::WriterThread, this);
+}
+
+void Logger::StopAsync()
+{
+    if (!m_async)
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(m_writerMutex);
+        m_stopRequested = true;
+    }
+    m_writerWakeup.notify_one();
+    m_writer.join();
+
+    m_async = false;
+    m_lineOutput = &m_outputFile;
+    m_outputFile.flush();
+}
+
+bool Logger::IsAsync() const
+{
+    return m_async;
+}
+
+void Logger::Flush()
+{
+    if (!m_async)
+    {
+        m_outputFile.flush();
+        return;
+    }
+
+    std::unique_lock<std::mutex> lock(m_writerMutex);
+    m_flushRequested = true;
+    m_writerWakeup.notify_one();
+    m_flushDone.wait(lock, [this]() { return !m_flushRequested; });
+}
+
+uint64_t Logger::GetDroppedCount() const
+{
+    return m_droppedCount;
+}
+
+void Logger::WriterThread()
+{
+    std::string batch;
+    size_t idleRounds = 0;
+
+    while (true)
+    {
+        const size_t count = m_ring.Available();
+        if (count > 0)
+        {
+            // format everything available and write it at once
+            batch.clear();
+            for (size_t i = 0; i < count; i++)
+                FormatRecord(m_ring.Peek(i), batch);
+            m_ring.Release(count);
+
+            m_outputFile.write(batch.data(), batch.size());
+            idleRounds = 0;
+            continue;
+        }
+
+        // give the producer a chance to push more records before going to sleep, so a busy producer does not pay
+        // for wakeup of every small batch
+        if (idleRounds < _writerIdleRounds)
+        {
+            idleRounds++;
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(m_writerMutex);
+
+        // the producer wakes the writer up only when it's marked sleeping, so mark it before the ring is checked again
+        // (the producer could also push more records before requesting flush or stop)
+        m_writerSleeping.store(true, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_seq_cst);
+        if (m_ring.Available() > 0)
+        {
+            m_writerSleeping.store(false, std::memory_order_relaxed);
+            continue;
+        }
+
+        if (m_flushRequested)
+        {
+            m_writerSleeping.store(false, std::memory_order_relaxed);
+            m_outputFile.flush();
+            m_flushRequested = false;
+            m_flushDone.notify_all();
+            continue;
+        }
+
+        if (m_stopRequested)
+        {
+            m_writerSleeping.store(false, std::memory_order_relaxed);
+            break;
+        }
+
+        // sleep until a record is pushed to empty ring, or flush or stop is requested
+        m_writerWakeup.wait(lock, [this]() {
+            return !m_writerSleeping.load(std::memory_order_relaxed) || m_flushRequested || m_stopRequested;
+        });
+        m_writerSleeping.store(false, std::memory_order_relaxed);
+    }
 }
@@ -8,11 +8,127 @@
 
 #include <iostream>
 #include <fstream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <array>
 
 #include "Types.h"
+#include "RingBuffer.h"
 
 class Logger;
 
+/*
+ * Severity level of log message
+ */
+enum class LogLevel : uint8_t
+{
+    TRACE,              // every dispatched object
+    VERBOSE,            // object lifetime (adding, removing)
+    INFO,               // simulation progress (setup, termination)
+    WARNING,            // unexpected, but recoverable states
+    CRITICAL,           // errors
+    NONE                // used as level threshold only - disables all messages
+};
+
+// number of log levels
+constexpr size_t LogLevelCount = static_cast<size_t>(LogLevel::NONE) + 1;
+
+// minimum level of messages compiled in (numeric value of LogLevel); messages with lower level are removed
+// at compile time, e.g. -DSIMLIB_LOG_MIN_LEVEL=2 leaves just INFO and more severe messages
+#ifndef SIMLIB_LOG_MIN_LEVEL
+#define SIMLIB_LOG_MIN_LEVEL 0
+#endif
+
+// is the level compiled in?
+constexpr bool Logger_IsLevelCompiled(LogLevel level)
+{
+#if SIMLIB_LOG_MIN_LEVEL > 0
+    return static_cast<int>(level) >= SIMLIB_LOG_MIN_LEVEL;
+#else
+    // all levels are compiled in; the comparison would be always true
+    (void)level;
+    return true;
+#endif
+}
+
+// categories of log messages (bit mask)
+constexpr uint32_t LogCategory_Simulation = 0x00000001;    // simulation setup, steps and termination
+constexpr uint32_t LogCategory_Dispatch = 0x00000002;      // dispatched objects
+constexpr uint32_t LogCategory_Objects = 0x00000004;       // adding and removing objects
+constexpr uint32_t LogCategory_User = 0x00010000;          // first category available for user messages
+constexpr uint32_t LogCategory_All = 0xFFFFFFFF;
+
+// is the message of given level and category enabled both at compile time and at runtime?
+#define SIMLIB_LOG_ENABLED(logger, level, category) (Logger_IsLevelCompiled(level) && (logger).IsEnabled(level, category))
+
+// logs message of given level and category; usage: SIMLIB_LOG(logger, LogLevel::INFO, LogCategory_User)(time) << "message";
+// nothing after the macro is evaluated, when the message is disabled
+#define SIMLIB_LOG(logger, level, category) if (!SIMLIB_LOG_ENABLED(logger, level, category)) {} else (logger)
+
+// default capacity of asynchronous logger ring (number of records)
+constexpr size_t Logger_DefaultRingCapacity = 65536;
+// capacity of text stored in a single log record
+constexpr size_t LogRecord_TextCapacity = 56;
+
+/*
+ * Kind of log record
+ */
+enum class LogRecordKind : uint8_t
+{
+    TEXT,               // part of text line
+    OBJECT_FIRED,       // object was fired
+    OBJECT_ADDED,       // object was added to simulation
+    OBJECT_REMOVED      // object was removed from simulation
+};
+
+/*
+ * Behaviour of asynchronous logger when the ring is full
+ */
+enum class LoggerBackPressure
+{
+    BLOCK,              // wait until the writer thread makes space
+    DROP                // drop the record and count it
+};
+
+/*
+ * Object data of log record
+ */
+struct LogObjectData
+{
+    simtime_t time;
+    uint64_t guid;
+    uint32_t objectClass;
+    uint32_t objectType;
+};
+
+/*
+ * Fixed-size binary log record passed from simulation thread to writer thread
+ */
+struct LogRecord
+{
+    // kind of record
+    LogRecordKind kind;
+    // is this the last part of text line?
+    bool lineEnd;
+    // length of text (TEXT records only)
+    uint16_t textLength;
+    uint32_t reserved;
+
+    union
+    {
+        // object record data
+        LogObjectData object;
+        // text record data
+        char text[LogRecord_TextCapacity];
+    };
+};
+
+static_assert(sizeof(LogRecord) == 64, "LogRecord is expected to fill exactly one cache line");
+
 /*
  * Logger line guard created as "RAII" structure for putting endline after write end
  */
@@ -34,6 +150,10 @@ struct LoggerLineGuard
 
 /*
  * Simulation logger class
+ *
+ * In synchronous mode (default), everything is written directly to output stream. In asynchronous mode, the lines
+ * are split to fixed-size records and pushed to lock-free ring along with the binary object records; the background
+ * writer thread formats them and writes them in batches. Logging is expected to be done from a single thread
  */
 class Logger
 {
@@ -45,14 +165,14 @@ class Logger
         template<typename T>
         LoggerLineGuard operator<<(T const& value)
         {
-            m_outputFile << value;
+            *m_lineOutput << value;
             return LoggerLineGuard(*this);
         }
 
         // simulation time logger bridge
         LoggerLineGuard operator()(const simtime_t time)
         {
-            m_outputFile << "[" << time << "] ";
+            *m_lineOutput << "[" << time << "] ";
             return LoggerLineGuard(*this);
         }
 
@@ -60,9 +180,41 @@ class Logger
         template<typename T>
         void Write(T const& value)
         {
-            m_outputFile << value;
+            *m_lineOutput << value;
         }
 
+        // finishes current line
+        void EndLine();
+
+        // sets minimum level of logged messages
+        void SetLevel(LogLevel level);
+        // retrieves minimum level of logged messages
+        LogLevel GetLevel() const;
+        // sets mask of logged message categories
+        void SetCategoryMask(uint32_t mask);
+        // retrieves mask of logged message categories
+        uint32_t GetCategoryMask() const;
+
+        // is the message of given level and category enabled?
+        bool IsEnabled(LogLevel level, uint32_t category) const
+        {
+            return (m_enabledCategories[static_cast<size_t>(level)] & category) != 0;
+        }
+
+        // logs object record (fired, added, removed) without formatting it in asynchronous mode
+        void LogObject(LogRecordKind kind, simtime_t time, uint64_t guid, uint32_t objectType, uint32_t objectClass);
+
+        // switches logger to asynchronous mode with given ring capacity (at least 1) and back-pressure behaviour
+        void StartAsync(size_t ringCapacity = Logger_DefaultRingCapacity, LoggerBackPressure backPressure = LoggerBackPressure::BLOCK);
+        // writes everything pending and switches logger back to synchronous mode
+        void StopAsync();
+        // is the logger in asynchronous mode?
+        bool IsAsync() const;
+        // waits until everything logged so far is written, and flushes output stream
+        void Flush();
+        // retrieves number of records dropped due to full ring
+        uint64_t GetDroppedCount() const;
+
         // end of line
         static constexpr auto endl()
         {
@@ -72,4 +224,54 @@ class Logger
     protected:
         // output file used
         std::ostream& m_outputFile;
+        // stream the current line is written to (output file in synchronous mode, line buffer otherwise)
+        std::ostream* m_lineOutput;
+        // line buffer used in asynchronous mode
+        std::ostringstream m_lineBuffer;
+        // buffer for formatting records in synchronous mode
+        std::string m_syncBuffer;
+
+        // recomputes enabled categories of every level
+        void UpdateEnabledCategories();
+
+        // pushes record to ring; applies back-pressure if the ring is full
+        void PushRecord(LogRecord const& record);
+        // wakes writer up, if it sleeps on empty ring
+        void WakeWriter();
+        // formats record and appends it to given string
+        static void FormatRecord(LogRecord const& record, std::string& out);
+        // writer thread routine
+        void WriterThread();
+
+    private:
+        // minimum level of logged messages
+        LogLevel m_level;
+        // mask of logged message categories
+        uint32_t m_categoryMask;
+        // enabled categories for every level (empty for levels below minimum), so the check is a single test
+        std::array<uint32_t, LogLevelCount> m_enabledCategories;
+
+        // is the logger in asynchronous mode?
+        bool m_async;
+        // back-pressure behaviour
+        LoggerBackPressure m_backPressure;
+        // ring of records
+        RingBuffer<LogRecord> m_ring;
+        // number of dropped records
+        uint64_t m_droppedCount;
+
+        // writer thread
+        std::thread m_writer;
+        // mutex guarding writer wakeup and flush handshake
+        std::mutex m_writerMutex;
+        // writer wakeup signal
+        std::condition_variable m_writerWakeup;
+        // flush completion signal
+        std::condition_variable m_flushDone;
+        // flush was requested and not done yet
+        bool m_flushRequested;
+        // writer should finish
+        std::atomic<bool> m_stopRequested;
+        // writer sleeps on empty ring and waits for the producer to push a record
+        std::atomic<bool> m_writerSleeping;
 };
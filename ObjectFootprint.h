@@ -0,0 +1,56 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <cstdint>
+
+/*
+ * Footprint of dispatched object - GUIDs of objects, whose state is read or written by its Run method (the object
+ * itself is always written). Objects with disjoint footprints could be dispatched in parallel
+ * (see SimulationDispatchMode::PARALLEL_BATCH)
+ */
+class ObjectFootprint
+{
+    public:
+        // declares, that the state of object with given GUID is read
+        void Read(uint64_t guid)
+        {
+            m_reads.push_back(guid);
+        }
+
+        // declares, that the state of object with given GUID is written (or the object is scheduled, terminated, ...)
+        void Write(uint64_t guid)
+        {
+            m_writes.push_back(guid);
+        }
+
+        // retrieves GUIDs of read objects
+        std::vector<uint64_t> const& GetReads() const
+        {
+            return m_reads;
+        }
+
+        // retrieves GUIDs of written objects
+        std::vector<uint64_t> const& GetWrites() const
+        {
+            return m_writes;
+        }
+
+        // clears footprint
+        void Clear()
+        {
+            m_reads.clear();
+            m_writes.clear();
+        }
+
+    private:
+        // GUIDs of read objects
+        std::vector<uint64_t> m_reads;
+        // GUIDs of written objects
+        std::vector<uint64_t> m_writes;
+};
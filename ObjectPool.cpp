@@ -0,0 +1,88 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "ObjectPool.h"
+
+#include <atomic>
+#include <algorithm>
+
+size_t ObjectPool_NextTypeId()
+{
+    static std::atomic<size_t> nextTypeId(0);
+    return nextTypeId++;
+}
+
+ObjectPool::ObjectPool()
+    : m_blockSize(0), m_nextChunkBlocks(ObjectPool_InitialChunkBlocks), m_freeList(nullptr), m_usedCount(0), m_capacity(0)
+{
+    //
+}
+
+ObjectPool::~ObjectPool()
+{
+    for (void* chunk : m_chunks)
+        ::operator delete(chunk);
+}
+
+void ObjectPool::Grow()
+{
+    unsigned char* chunk = static_cast<unsigned char*>(::operator new(m_blockSize * m_nextChunkBlocks));
+    m_chunks.push_back(chunk);
+
+    // link blocks in reverse order, so they are taken in ascending address order
+    for (size_t i = m_nextChunkBlocks; i > 0; i--)
+    {
+        FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + (i - 1) * m_blockSize);
+        block->next = m_freeList;
+        m_freeList = block;
+    }
+
+    m_capacity += m_nextChunkBlocks;
+    m_nextChunkBlocks = std::min(m_nextChunkBlocks * 2, ObjectPool_MaxChunkBlocks);
+}
+
+void* ObjectPool::Allocate(size_t size)
+{
+    const size_t blockSize = ObjectPool_BlockSize(size);
+
+    // the first allocation determines block size
+    if (m_blockSize == 0)
+        m_blockSize = blockSize;
+    else if (m_blockSize != blockSize)
+        return nullptr;
+
+    if (!m_freeList)
+        Grow();
+
+    FreeBlock* block = m_freeList;
+    m_freeList = block->next;
+    m_usedCount++;
+
+    return block;
+}
+
+void ObjectPool::Deallocate(void* block)
+{
+    FreeBlock* freeBlock = static_cast<FreeBlock*>(block);
+    freeBlock->next = m_freeList;
+    m_freeList = freeBlock;
+    m_usedCount--;
+}
+
+size_t ObjectPool::GetBlockSize() const
+{
+    return m_blockSize;
+}
+
+size_t ObjectPool::GetUsedCount() const
+{
+    return m_usedCount;
+}
+
+size_t ObjectPool::GetCapacity() const
+{
+    return m_capacity;
+}
@@ -0,0 +1,151 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+
+// number of blocks in the first chunk of pool; every next chunk is twice as large
+constexpr size_t ObjectPool_InitialChunkBlocks = 64;
+// maximum number of blocks in single chunk of pool
+constexpr size_t ObjectPool_MaxChunkBlocks = 16384;
+
+// retrieves size of pool block able to hold object of given size
+constexpr size_t ObjectPool_BlockSize(size_t size)
+{
+    return ((size < sizeof(void*) ? sizeof(void*) : size) + alignof(std::max_align_t) - 1) / alignof(std::max_align_t) * alignof(std::max_align_t);
+}
+
+// object type identifier of objects not created by pool
+constexpr size_t ObjectPool_NoTypeId = std::numeric_limits<size_t>::max();
+
+// retrieves next free object type identifier
+size_t ObjectPool_NextTypeId();
+
+// retrieves identifier of object type; identifiers are assigned sequentially, so they could be used as an index
+template<typename T>
+size_t ObjectPool_TypeId()
+{
+    static const size_t typeId = ObjectPool_NextTypeId();
+    return typeId;
+}
+
+/*
+ * Pool of fixed-size memory blocks
+ *
+ * The block size is fixed by the first allocation; blocks are carved from chunks of growing size and the released
+ * blocks are kept in intrusive free list, so the allocation and release take O(1) without calling global allocator.
+ * The memory is returned to system when the pool is destroyed. The pool is not thread-safe
+ */
+class ObjectPool
+{
+    public:
+        ObjectPool();
+        ~ObjectPool();
+
+        ObjectPool(ObjectPool const&) = delete;
+        ObjectPool& operator=(ObjectPool const&) = delete;
+
+        // allocates block of given size; returns nullptr, if the size does not match block size of this pool
+        void* Allocate(size_t size);
+        // releases block previously allocated from this pool
+        void Deallocate(void* block);
+
+        // retrieves size of a single block (0 if nothing was allocated yet)
+        size_t GetBlockSize() const;
+        // retrieves number of blocks in use
+        size_t GetUsedCount() const;
+        // retrieves number of blocks allocated from system
+        size_t GetCapacity() const;
+
+    protected:
+        // allocates next chunk and puts its blocks to free list
+        void Grow();
+
+    private:
+        /*
+         * Free block; the link is stored in the block memory itself
+         */
+        struct FreeBlock
+        {
+            FreeBlock* next;
+        };
+
+        // size of a single block
+        size_t m_blockSize;
+        // number of blocks of next chunk
+        size_t m_nextChunkBlocks;
+        // chunks allocated from system
+        std::vector<void*> m_chunks;
+        // head of free list
+        FreeBlock* m_freeList;
+        // number of blocks in use
+        size_t m_usedCount;
+        // number of blocks allocated from system
+        size_t m_capacity;
+};
+
+using ObjectPoolPtr = std::shared_ptr<ObjectPool>;
+
+/*
+ * Allocator taking single objects from object pool; meant to be used with std::allocate_shared, so the object
+ * and its control block share one pooled block. The allocator holds the pool, so the pool lives as long as any
+ * object allocated from it. Arrays and over-aligned types are allocated by global allocator
+ */
+template<typename T>
+class PoolAllocator
+{
+    template<typename U>
+    friend class PoolAllocator;
+
+    public:
+        using value_type = T;
+
+        template<typename U>
+        struct rebind
+        {
+            using other = PoolAllocator<U>;
+        };
+
+        PoolAllocator(ObjectPoolPtr pool) : m_pool(std::move(pool)) { };
+
+        template<typename U>
+        PoolAllocator(PoolAllocator<U> const& other) : m_pool(other.m_pool) { };
+
+        T* allocate(size_t n)
+        {
+            if (n == 1 && alignof(T) <= alignof(std::max_align_t))
+            {
+                void* block = m_pool->Allocate(sizeof(T));
+                if (block)
+                    return static_cast<T*>(block);
+            }
+
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+        }
+
+        void deallocate(T* ptr, size_t n)
+        {
+            // the pool takes only blocks of its size, so the same condition as in allocate holds here
+            if (n == 1 && alignof(T) <= alignof(std::max_align_t) && m_pool->GetBlockSize() == ObjectPool_BlockSize(sizeof(T)))
+                m_pool->Deallocate(ptr);
+            else
+                ::operator delete(ptr);
+        }
+
+        template<typename U>
+        bool operator==(PoolAllocator<U> const& other) const { return m_pool == other.m_pool; }
+        template<typename U>
+        bool operator!=(PoolAllocator<U> const& other) const { return m_pool != other.m_pool; }
+
+    private:
+        // pool used for allocations
+        ObjectPoolPtr m_pool;
+};
@@ -0,0 +1,483 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "ObjectRegistry.h"
+#include "Simulation.h"
+
+// empty list returned for types and classes without objects
+static const ObjectDenseList _emptyDenseList;
+// empty pointer returned for invalid GUIDs
+static const SimulationObjectPtr _emptyObjectPtr;
+
+ObjectRegistry::ObjectRegistry()
+{
+    //
+}
+
+const ObjectRegistry::ObjectSlot* ObjectRegistry::FindSlot(uint64_t guid) const
+{
+    // lower half of GUID is slot index (plus one, so the GUID is never zero), upper half is slot generation
+    uint64_t index = (guid & 0xFFFFFFFFULL);
+    if (index == 0 || index > m_slots.size())
+        return nullptr;
+
+    const ObjectSlot& slot = m_slots[index - 1];
+    if (!slot.object || slot.generation != static_cast<uint32_t>(guid >> 32))
+        return nullptr;
+
+    return &slot;
+}
+
+void ObjectRegistry::DenseInsert(ObjectDenseList& list, SimulationObjectPtr const& object, ObjectRegistryList listId)
+{
+    object->m_registryPositions[static_cast<size_t>(listId)] = static_cast<uint32_t>(list.size());
+    list.push_back(object);
+}
+
+void ObjectRegistry::DenseRemove(ObjectDenseList& list, SimulationObject* object, ObjectRegistryList listId)
+{
+    const size_t listIndex = static_cast<size_t>(listId);
+    const uint32_t pos = object->m_registryPositions[listIndex];
+
+    // move the last object to the vacated position
+    if (pos != list.size() - 1)
+    {
+        list[pos] = std::move(list.back());
+        list[pos]->m_registryPositions[listIndex] = pos;
+    }
+
+    list.pop_back();
+}
+
+void ObjectRegistry::AttributeInsert(ObjectDenseList& list, SimulationObjectPtr const& object, SimulationObjectAttribute& attr)
+{
+    attr.indexPosition = static_cast<uint32_t>(list.size());
+    list.push_back(object);
+}
+
+void ObjectRegistry::AttributeRemove(AttributeIndex& index, SimulationObjectAttribute const& attr)
+{
+    auto itr = index.find(attr.value);
+    if (itr == index.end())
+        return;
+
+    ObjectDenseList& list = itr->second;
+    const uint32_t pos = attr.indexPosition;
+
+    // move the last object to the vacated position
+    if (pos != list.size() - 1)
+    {
+        list[pos] = std::move(list.back());
+        list[pos]->FindAttribute(attr.id)->indexPosition = pos;
+    }
+
+    list.pop_back();
+
+    // the values come and go, so the index would grow without bound otherwise
+    if (list.empty())
+        index.erase(itr);
+}
+
+uint64_t ObjectRegistry::GetTypeClassKey(SimulationObjectType type, uint32_t objectClass)
+{
+    return (static_cast<uint64_t>(type) << 32) | objectClass;
+}
+
+uint64_t ObjectRegistry::Add(SimulationObjectPtr const& object)
+{
+    // do not register the same object twice
+    if (Contains(object.get()))
+        return object->GetGUID();
+
+    uint32_t index;
+    if (!m_freeSlots.empty())
+    {
+        index = m_freeSlots.back();
+        m_freeSlots.pop_back();
+    }
+    else
+    {
+        index = static_cast<uint32_t>(m_slots.size());
+        m_slots.push_back({ nullptr, 0 });
+    }
+
+    ObjectSlot& slot = m_slots[index];
+    slot.object = object;
+
+    uint64_t guid = (static_cast<uint64_t>(slot.generation) << 32) | (static_cast<uint64_t>(index) + 1);
+    object->SetGUID(guid);
+
+    // from this point, the GUID, type and class are fixed and should not be changed!
+    DenseInsert(m_allObjects, object, ObjectRegistryList::ALL);
+    DenseInsert(m_typeLists[static_cast<size_t>(object->GetType())], object, ObjectRegistryList::TYPE);
+    DenseInsert(m_classLists[object->GetObjectClass()], object, ObjectRegistryList::CLASS);
+    DenseInsert(m_typeClassLists[GetTypeClassKey(object->GetType(), object->GetObjectClass())], object, ObjectRegistryList::TYPE_CLASS);
+
+    // attributes set before registration
+    for (auto& attr : object->m_attributes)
+    {
+        auto idxItr = m_attributeIndexes.find(attr.id);
+        if (idxItr != m_attributeIndexes.end())
+            AttributeInsert(idxItr->second[attr.value], object, attr);
+    }
+
+    object->m_registry = this;
+
+    return guid;
+}
+
+bool ObjectRegistry::Remove(SimulationObject* object)
+{
+    if (!Contains(object))
+        return false;
+
+    DenseRemove(m_allObjects, object, ObjectRegistryList::ALL);
+    DenseRemove(m_typeLists[static_cast<size_t>(object->GetType())], object, ObjectRegistryList::TYPE);
+
+    // lists of classes without objects are dropped, so the maps do not keep every class ever used
+    auto itr = m_classLists.find(object->GetObjectClass());
+    if (itr != m_classLists.end())
+    {
+        DenseRemove(itr->second, object, ObjectRegistryList::CLASS);
+        if (itr->second.empty())
+            m_classLists.erase(itr);
+    }
+
+    auto tcItr = m_typeClassLists.find(GetTypeClassKey(object->GetType(), object->GetObjectClass()));
+    if (tcItr != m_typeClassLists.end())
+    {
+        DenseRemove(tcItr->second, object, ObjectRegistryList::TYPE_CLASS);
+        if (tcItr->second.empty())
+            m_typeClassLists.erase(tcItr);
+    }
+
+    for (auto& attr : object->m_attributes)
+    {
+        auto idxItr = m_attributeIndexes.find(attr.id);
+        if (idxItr != m_attributeIndexes.end())
+            AttributeRemove(idxItr->second, attr);
+    }
+
+    object->m_registry = nullptr;
+
+    // release slot; the generation change invalidates the GUID
+    uint32_t index = static_cast<uint32_t>(object->GetGUID() & 0xFFFFFFFFULL) - 1;
+    m_slots[index].generation++;
+    m_freeSlots.push_back(index);
+
+    // this may destroy the object, so release it as the last thing
+    m_slots[index].object.reset();
+
+    return true;
+}
+
+bool ObjectRegistry::Contains(const SimulationObject* object) const
+{
+    const ObjectSlot* slot = FindSlot(object->GetGUID());
+    return (slot && slot->object.get() == object);
+}
+
+SimulationObjectPtr const& ObjectRegistry::GetByGUID(uint64_t guid) const
+{
+    const ObjectSlot* slot = FindSlot(guid);
+    if (!slot)
+        return _emptyObjectPtr;
+
+    return slot->object;
+}
+
+ObjectDenseList const& ObjectRegistry::GetAll() const
+{
+    return m_allObjects;
+}
+
+ObjectDenseList const& ObjectRegistry::GetByType(SimulationObjectType type) const
+{
+    return m_typeLists[static_cast<size_t>(type)];
+}
+
+ObjectDenseList const& ObjectRegistry::GetByClass(uint32_t objectClass) const
+{
+    auto itr = m_classLists.find(objectClass);
+    if (itr == m_classLists.end())
+        return _emptyDenseList;
+
+    return itr->second;
+}
+
+ObjectDenseList const& ObjectRegistry::GetByTypeAndClass(SimulationObjectType type, uint32_t objectClass) const
+{
+    auto itr = m_typeClassLists.find(GetTypeClassKey(type, objectClass));
+    if (itr == m_typeClassLists.end())
+        return _emptyDenseList;
+
+    return itr->second;
+}
+
+bool ObjectRegistry::RegisterAttributeIndex(uint32_t attributeId)
+{
+    if (m_attributeIndexes.find(attributeId) != m_attributeIndexes.end())
+        return false;
+
+    AttributeIndex& index = m_attributeIndexes[attributeId];
+
+    // index objects already registered
+    for (auto& object : m_allObjects)
+    {
+        SimulationObjectAttribute* attr = object->FindAttribute(attributeId);
+        if (attr)
+            AttributeInsert(index[attr->value], object, *attr);
+    }
+
+    return true;
+}
+
+bool ObjectRegistry::HasAttributeIndex(uint32_t attributeId) const
+{
+    return (m_attributeIndexes.find(attributeId) != m_attributeIndexes.end());
+}
+
+ObjectDenseList const& ObjectRegistry::GetByAttribute(uint32_t attributeId, int64_t value) const
+{
+    auto idxItr = m_attributeIndexes.find(attributeId);
+    if (idxItr == m_attributeIndexes.end())
+        return _emptyDenseList;
+
+    auto itr = idxItr->second.find(value);
+    if (itr == idxItr->second.end())
+        return _emptyDenseList;
+
+    return itr->second;
+}
+
+void ObjectRegistry::SetAttribute(SimulationObject* object, uint32_t attributeId, int64_t value)
+{
+    SimulationObjectAttribute* attr = object->FindAttribute(attributeId);
+    if (attr && attr->value == value)
+        return;
+
+    auto idxItr = m_attributeIndexes.find(attributeId);
+    if (idxItr == m_attributeIndexes.end())
+    {
+        // not indexed, just store the value
+        if (attr)
+            attr->value = value;
+        else
+            object->m_attributes.push_back({ attributeId, 0, value });
+        return;
+    }
+
+    // indexes are shared by all objects, so they could not be updated during parallel phase
+    assert(!Simulation::IsDeferring());
+
+    AttributeIndex& index = idxItr->second;
+
+    // move the object from list of old value to list of new value
+    if (attr)
+    {
+        AttributeRemove(index, *attr);
+        attr->value = value;
+    }
+    else
+    {
+        object->m_attributes.push_back({ attributeId, 0, value });
+        attr = &object->m_attributes.back();
+    }
+
+    AttributeInsert(index[value], m_allObjects[object->m_registryPositions[static_cast<size_t>(ObjectRegistryList::ALL)]], *attr);
+}
+
+size_t ObjectRegistry::Count() const
+{
+    return m_allObjects.size();
+}
+
+void ObjectRegistry::SaveList(CheckpointWriter& writer, ObjectDenseList const& list)
+{
+    writer.WriteVarUInt(list.size());
+    for (auto& object : list)
+        writer.WriteVarUInt((object->GetGUID() & 0xFFFFFFFFULL) - 1);
+}
+
+void ObjectRegistry::Save(CheckpointWriter& writer) const
+{
+    writer.WriteVarUInt(m_slots.size());
+    for (auto& slot : m_slots)
+        writer.WriteVarUInt(slot.generation);
+
+    writer.WriteVarUInt(m_freeSlots.size());
+    for (uint32_t index : m_freeSlots)
+        writer.WriteVarUInt(index);
+
+    // the order of objects within lists determines the order of event targets, so all of them are stored
+    SaveList(writer, m_allObjects);
+    for (auto& list : m_typeLists)
+        SaveList(writer, list);
+
+    writer.WriteVarUInt(m_classLists.size());
+    for (auto& entry : m_classLists)
+    {
+        writer.WriteVarUInt(entry.first);
+        SaveList(writer, entry.second);
+    }
+
+    writer.WriteVarUInt(m_typeClassLists.size());
+    for (auto& entry : m_typeClassLists)
+    {
+        writer.WriteVarUInt(entry.first);
+        SaveList(writer, entry.second);
+    }
+
+    writer.WriteVarUInt(m_attributeIndexes.size());
+    for (auto& index : m_attributeIndexes)
+    {
+        writer.WriteVarUInt(index.first);
+        writer.WriteVarUInt(index.second.size());
+        for (auto& entry : index.second)
+        {
+            writer.WriteVarInt(entry.first);
+            SaveList(writer, entry.second);
+        }
+    }
+}
+
+template<typename Pred>
+bool ObjectRegistry::RestoreList(CheckpointReader& reader, Pred const& pred, ObjectDenseList& list, ObjectRegistryList listId)
+{
+    const uint64_t count = reader.ReadVarUInt();
+    if (count > m_slots.size())
+        return false;
+
+    const size_t listIndex = static_cast<size_t>(listId);
+
+    for (uint64_t i = 0; i < count && reader.IsGood(); i++)
+    {
+        const uint64_t index = reader.ReadVarUInt();
+        if (index >= m_slots.size() || !m_slots[index].object || !pred(m_slots[index].object.get()))
+            return false;
+
+        // every object may be present just once
+        SimulationObjectPtr const& object = m_slots[index].object;
+        const uint32_t pos = object->m_registryPositions[listIndex];
+        if (pos < list.size() && list[pos] == object)
+            return false;
+
+        DenseInsert(list, object, listId);
+    }
+
+    return reader.IsGood();
+}
+
+bool ObjectRegistry::Restore(CheckpointReader& reader, std::vector<SimulationObjectPtr> const& objects)
+{
+    m_slots.clear();
+    m_freeSlots.clear();
+    m_allObjects.clear();
+    for (auto& list : m_typeLists)
+        list.clear();
+    m_classLists.clear();
+    m_typeClassLists.clear();
+    m_attributeIndexes.clear();
+
+    const uint64_t slotCount = reader.ReadVarUInt();
+    if (!reader.IsGood() || slotCount > 0xFFFFFFFFULL || slotCount < objects.size())
+        return false;
+
+    m_slots.resize(static_cast<size_t>(slotCount), { nullptr, 0 });
+    for (auto& slot : m_slots)
+        slot.generation = static_cast<uint32_t>(reader.ReadVarUInt());
+
+    // objects take the slots given by their GUIDs
+    for (auto& object : objects)
+    {
+        const uint64_t index = (object->GetGUID() & 0xFFFFFFFFULL);
+        if (index == 0 || index > m_slots.size())
+            return false;
+
+        ObjectSlot& slot = m_slots[index - 1];
+        if (slot.object || slot.generation != static_cast<uint32_t>(object->GetGUID() >> 32))
+            return false;
+
+        slot.object = object;
+        object->m_registry = this;
+        object->m_registryPositions.fill(std::numeric_limits<uint32_t>::max());
+    }
+
+    const uint64_t freeCount = reader.ReadVarUInt();
+    if (freeCount > m_slots.size())
+        return false;
+
+    for (uint64_t i = 0; i < freeCount && reader.IsGood(); i++)
+    {
+        const uint64_t index = reader.ReadVarUInt();
+        if (index >= m_slots.size() || m_slots[index].object)
+            return false;
+
+        m_freeSlots.push_back(static_cast<uint32_t>(index));
+    }
+
+    auto any = [](const SimulationObject*) { return true; };
+    if (!RestoreList(reader, any, m_allObjects, ObjectRegistryList::ALL) || m_allObjects.size() != objects.size())
+        return false;
+
+    for (size_t type = 0; type < SimulationObjectTypeCount; type++)
+    {
+        auto ofType = [type](const SimulationObject* object) { return static_cast<size_t>(object->GetType()) == type; };
+        if (!RestoreList(reader, ofType, m_typeLists[type], ObjectRegistryList::TYPE))
+            return false;
+    }
+
+    const uint64_t classCount = reader.ReadVarUInt();
+    for (uint64_t i = 0; i < classCount && reader.IsGood(); i++)
+    {
+        const uint32_t objectClass = static_cast<uint32_t>(reader.ReadVarUInt());
+        auto ofClass = [objectClass](const SimulationObject* object) { return object->GetObjectClass() == objectClass; };
+        if (!RestoreList(reader, ofClass, m_classLists[objectClass], ObjectRegistryList::CLASS))
+            return false;
+    }
+
+    const uint64_t typeClassCount = reader.ReadVarUInt();
+    for (uint64_t i = 0; i < typeClassCount && reader.IsGood(); i++)
+    {
+        const uint64_t key = reader.ReadVarUInt();
+        auto ofTypeClass = [key](const SimulationObject* object) { return GetTypeClassKey(object->GetType(), object->GetObjectClass()) == key; };
+        if (!RestoreList(reader, ofTypeClass, m_typeClassLists[key], ObjectRegistryList::TYPE_CLASS))
+            return false;
+    }
+
+    const uint64_t indexCount = reader.ReadVarUInt();
+    for (uint64_t i = 0; i < indexCount && reader.IsGood(); i++)
+    {
+        const uint32_t attributeId = static_cast<uint32_t>(reader.ReadVarUInt());
+        AttributeIndex& index = m_attributeIndexes[attributeId];
+
+        const uint64_t valueCount = reader.ReadVarUInt();
+        for (uint64_t j = 0; j < valueCount && reader.IsGood(); j++)
+        {
+            const int64_t value = reader.ReadVarInt();
+            ObjectDenseList& list = index[value];
+
+            const uint64_t count = reader.ReadVarUInt();
+            if (count > m_allObjects.size())
+                return false;
+
+            for (uint64_t k = 0; k < count && reader.IsGood(); k++)
+            {
+                const uint64_t slotIndex = reader.ReadVarUInt();
+                if (slotIndex >= m_slots.size() || !m_slots[slotIndex].object)
+                    return false;
+
+                SimulationObjectAttribute* attr = m_slots[slotIndex].object->FindAttribute(attributeId);
+                if (!attr || attr->value != value)
+                    return false;
+
+                AttributeInsert(list, m_slots[slotIndex].object, *attr);
+            }
+        }
+    }
+
+    return reader.IsGood();
+}
@@ -0,0 +1,123 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include "SimulationObject.h"
+
+#include <vector>
+#include <array>
+#include <unordered_map>
+
+// dense list of registered objects
+using ObjectDenseList = std::vector<SimulationObjectPtr>;
+
+/*
+ * Registry of simulation objects
+ *
+ * Objects are stored in a slot map - the GUID consists of slot index and generation of the slot, so the lookup
+ * by GUID is just an array access, and GUIDs of removed objects are never resolved to newly added objects.
+ * In addition, objects are stored in dense lists (all objects, per type, per class, per type and class); the object
+ * remembers its position within every list, so the removal is done by swapping with the last element in O(1).
+ * Secondary indexes on user attributes could be registered - the object notifies the registry when the indexed
+ * attribute changes, and the registry moves it to the dense list of the new value
+ */
+class ObjectRegistry
+{
+    public:
+        ObjectRegistry();
+
+        // adds object to registry; assigns and returns its GUID
+        uint64_t Add(SimulationObjectPtr const& object);
+        // removes object from registry; returns false, if the object was not registered
+        bool Remove(SimulationObject* object);
+
+        // is the object registered?
+        bool Contains(const SimulationObject* object) const;
+        // retrieves object by its GUID
+        SimulationObjectPtr const& GetByGUID(uint64_t guid) const;
+        // retrieves all registered objects
+        ObjectDenseList const& GetAll() const;
+        // retrieves objects of given type
+        ObjectDenseList const& GetByType(SimulationObjectType type) const;
+        // retrieves objects of given class
+        ObjectDenseList const& GetByClass(uint32_t objectClass) const;
+        // retrieves objects of given type and class
+        ObjectDenseList const& GetByTypeAndClass(SimulationObjectType type, uint32_t objectClass) const;
+
+        // registers index on user attribute; returns false, if the index already exists
+        bool RegisterAttributeIndex(uint32_t attributeId);
+        // is there an index on given user attribute?
+        bool HasAttributeIndex(uint32_t attributeId) const;
+        // retrieves objects with given value of indexed user attribute (empty, if the attribute is not indexed)
+        ObjectDenseList const& GetByAttribute(uint32_t attributeId, int64_t value) const;
+        // sets user attribute of registered object and updates attribute index
+        void SetAttribute(SimulationObject* object, uint32_t attributeId, int64_t value);
+
+        // retrieves number of registered objects
+        size_t Count() const;
+
+        // writes slot map and order of objects within all lists to checkpoint
+        void Save(CheckpointWriter& writer) const;
+        // replaces contents of registry with given objects restored from checkpoint (their GUIDs must be already set),
+        // and restores slot map and lists written by Save; returns false, if the checkpoint does not match the objects
+        bool Restore(CheckpointReader& reader, std::vector<SimulationObjectPtr> const& objects);
+
+    protected:
+        // index of single user attribute; objects by attribute value
+        using AttributeIndex = std::unordered_map<int64_t, ObjectDenseList>;
+
+        /*
+         * Slot of slot map
+         */
+        struct ObjectSlot
+        {
+            // stored object (empty if the slot is free)
+            SimulationObjectPtr object;
+            // generation of slot; incremented on every release
+            uint32_t generation;
+        };
+
+        // adds object to dense list, remembers its position
+        static void DenseInsert(ObjectDenseList& list, SimulationObjectPtr const& object, ObjectRegistryList listId);
+        // removes object from dense list by swapping it with the last one
+        static void DenseRemove(ObjectDenseList& list, SimulationObject* object, ObjectRegistryList listId);
+        // adds object to attribute index list, remembers its position within attribute record
+        static void AttributeInsert(ObjectDenseList& list, SimulationObjectPtr const& object, SimulationObjectAttribute& attr);
+        // removes object from list of its attribute value by swapping it with the last one; the list is dropped from
+        // index, when it becomes empty
+        static void AttributeRemove(AttributeIndex& index, SimulationObjectAttribute const& attr);
+
+        // retrieves key of composite index
+        static uint64_t GetTypeClassKey(SimulationObjectType type, uint32_t objectClass);
+
+        // retrieves slot of object with given GUID; nullptr if GUID is not valid
+        const ObjectSlot* FindSlot(uint64_t guid) const;
+
+        // writes slot indices of objects in dense list to checkpoint
+        static void SaveList(CheckpointWriter& writer, ObjectDenseList const& list);
+        // reads slot indices written by SaveList and fills dense list; objects not matching given predicate are
+        // refused, returns false then
+        template<typename Pred>
+        bool RestoreList(CheckpointReader& reader, Pred const& pred, ObjectDenseList& list, ObjectRegistryList listId);
+
+        // slots of slot map
+        std::vector<ObjectSlot> m_slots;
+        // free slot indices
+        std::vector<uint32_t> m_freeSlots;
+
+        // all objects
+        ObjectDenseList m_allObjects;
+        // objects by their type
+        std::array<ObjectDenseList, SimulationObjectTypeCount> m_typeLists;
+        // objects by their class
+        std::unordered_map<uint32_t, ObjectDenseList> m_classLists;
+        // objects by their type and class
+        std::unordered_map<uint64_t, ObjectDenseList> m_typeClassLists;
+
+        // registered user attribute indexes
+        std::unordered_map<uint32_t, AttributeIndex> m_attributeIndexes;
+};
@@ -0,0 +1,437 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "ParallelSimulation.h"
+
+#include <algorithm>
+
+// initial adaptive optimism window, in lookaheads
+static const simtime_t _initialOptimismWindow = 1;
+// maximum adaptive optimism window, in lookaheads
+static const simtime_t _maxOptimismWindow = 64;
+// rate of rolled back messages (to dispatches of epoch), above which the adaptive window is halved
+static const double _highRollbackRate = 0.05;
+// rate of rolled back messages, below which the adaptive window grows by one lookahead
+static const double _lowRollbackRate = 0.005;
+// number of consecutive epochs with low rollback rate, after which the adaptive window grows
+static const size_t _calmEpochs = 4;
+// number of dispatches between deliveries of incoming messages in optimistic mode
+static const size_t _optimisticBatchSize = 16;
+
+// adds time interval to time; saturates at SimulationTime_Never
+static simtime_t AddTime(simtime_t time, simtime_t interval)
+{
+    return (time > SimulationTime_Never - interval) ? SimulationTime_Never : time + interval;
+}
+
+ParallelSimulation::ParallelSimulation(size_t lpCount, size_t threadCount, ParallelSimulationMode mode)
+    : m_mode(mode), m_nullOutput(nullptr), m_pool(threadCount), m_writeParity(0), m_lookahead(1), m_optimismWindow(0),
+      m_adaptiveWindow(0), m_calmEpochCount(0), m_windowCount(0), m_rejectedMessages(0)
+{
+    if (lpCount == 0)
+        lpCount = 1;
+
+    for (size_t i = 0; i < lpCount; i++)
+    {
+        SimulationPtr lp = Simulation::Create(m_nullOutput);
+        lp->GetLogger().SetLevel(LogLevel::NONE);
+        lp->SetLogicalProcess(static_cast<uint32_t>(i), this);
+        lp->SetOptimistic(mode == ParallelSimulationMode::OPTIMISTIC);
+        m_lps.push_back(lp);
+    }
+
+    for (auto& outboxes : m_outboxes)
+        outboxes.assign(lpCount, std::vector<std::vector<SimulationMessage>>(lpCount));
+    for (auto& minTimes : m_outboxMinTime)
+        minTimes.assign(lpCount, SimulationTime_Never);
+
+    for (size_t i = 0; i < lpCount; i++)
+        m_incoming.emplace_back(new IncomingQueue());
+    m_delivered.resize(lpCount);
+    m_epochDispatches.assign(lpCount, 0);
+
+    // all logical processes share the master seed; their streams differ by logical process index
+    SetMasterSeed(m_lps[0]->GetMasterSeed());
+}
+
+ParallelSimulation::~ParallelSimulation()
+{
+    // the logical processes must not route messages to destroyed router
+    for (auto& lp : m_lps)
+        lp->SetLogicalProcess(lp->GetLogicalProcessIndex(), nullptr);
+}
+
+ParallelSimulationMode ParallelSimulation::GetMode() const
+{
+    return m_mode;
+}
+
+size_t ParallelSimulation::GetLogicalProcessCount() const
+{
+    return m_lps.size();
+}
+
+SimulationPtr const& ParallelSimulation::GetLogicalProcess(size_t index) const
+{
+    return m_lps[index];
+}
+
+void ParallelSimulation::SetLookahead(simtime_t lookahead)
+{
+    // zero lookahead would not allow any window to progress
+    m_lookahead = std::max<simtime_t>(lookahead, 1);
+    // the adaptive window starts over in new lookaheads
+    m_adaptiveWindow = 0;
+    m_calmEpochCount = 0;
+}
+
+simtime_t ParallelSimulation::GetLookahead() const
+{
+    return m_lookahead;
+}
+
+void ParallelSimulation::SetOptimismWindow(simtime_t window)
+{
+    m_optimismWindow = window;
+}
+
+simtime_t ParallelSimulation::GetOptimismWindow() const
+{
+    if (m_optimismWindow != 0)
+        return std::max(m_optimismWindow, m_lookahead);
+
+    if (m_adaptiveWindow != 0)
+        return m_adaptiveWindow;
+
+    return MultiplyLookahead(_initialOptimismWindow);
+}
+
+simtime_t ParallelSimulation::MultiplyLookahead(simtime_t count) const
+{
+    return (m_lookahead > SimulationTime_Never / count) ? SimulationTime_Never : m_lookahead * count;
+}
+
+void ParallelSimulation::AdaptOptimismWindow(uint64_t dispatched, uint64_t rolledBack)
+{
+    const simtime_t window = GetOptimismWindow();
+    const double rate = static_cast<double>(rolledBack) / static_cast<double>(std::max<uint64_t>(dispatched, 1));
+
+    m_adaptiveWindow = window;
+
+    // multiplicative decrease, slow additive increase; the speculation beyond the window is wasted, when the messages
+    // of other LPs keep coming into it
+    if (rate > _highRollbackRate)
+    {
+        m_adaptiveWindow = std::max(window / 2, m_lookahead);
+        m_calmEpochCount = 0;
+    }
+    else if (rate < _lowRollbackRate)
+    {
+        if (++m_calmEpochCount >= _calmEpochs)
+        {
+            m_adaptiveWindow = std::min(AddTime(window, m_lookahead), MultiplyLookahead(_maxOptimismWindow));
+            m_calmEpochCount = 0;
+        }
+    }
+    else
+        m_calmEpochCount = 0;
+}
+
+void ParallelSimulation::SetMasterSeed(uint64_t seed)
+{
+    for (auto& lp : m_lps)
+        lp->SetMasterSeed(seed);
+}
+
+bool ParallelSimulation::RouteMessage(SimulationMessage const& message)
+{
+    if (!CheckRoute(message.targetLP, message.time - message.sendTime))
+        return false;
+
+    if (m_mode == ParallelSimulationMode::OPTIMISTIC)
+    {
+        IncomingQueue& queue = *m_incoming[message.targetLP];
+
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        queue.messages.push_back(message);
+        queue.minTime = std::min(queue.minTime, message.time);
+
+        return true;
+    }
+
+    // called from thread of source LP only, so its outbox row is not shared
+    m_outboxes[m_writeParity][message.sourceLP][message.targetLP].push_back(message);
+
+    simtime_t& minTime = m_outboxMinTime[m_writeParity][message.sourceLP];
+    minTime = std::min(minTime, message.time);
+
+    return true;
+}
+
+bool ParallelSimulation::CheckRoute(uint32_t targetLP, simtime_t delay)
+{
+    if (targetLP >= m_lps.size() || delay < m_lookahead)
+    {
+        m_rejectedMessages++;
+        return false;
+    }
+
+    return true;
+}
+
+void ParallelSimulation::DeliverMessages(size_t lpIndex)
+{
+    Simulation& lp = *m_lps[lpIndex];
+    const size_t readParity = m_writeParity ^ 1;
+
+    // receive order is given by message comparator, so the order of delivery does not matter
+    for (auto& sourceOutboxes : m_outboxes[readParity])
+    {
+        std::vector<SimulationMessage>& outbox = sourceOutboxes[lpIndex];
+        for (auto& message : outbox)
+            lp.DeliverMessage(message);
+        outbox.clear();
+    }
+}
+
+void ParallelSimulation::RunWindow(size_t lpIndex, simtime_t windowEnd)
+{
+    DeliverMessages(lpIndex);
+
+    m_lps[lpIndex]->RunUntil(windowEnd);
+}
+
+bool ParallelSimulation::DeliverIncoming(size_t lpIndex)
+{
+    IncomingQueue& queue = *m_incoming[lpIndex];
+    std::vector<SimulationMessage>& delivered = m_delivered[lpIndex];
+
+    {
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.messages.empty())
+            return false;
+
+        delivered.swap(queue.messages);
+        queue.minTime = SimulationTime_Never;
+    }
+
+    // the queue keeps the send order, so the anti-message is never delivered before its message
+    Simulation& lp = *m_lps[lpIndex];
+    for (auto& message : delivered)
+        lp.DeliverMessage(message);
+    delivered.clear();
+
+    return true;
+}
+
+void ParallelSimulation::RunEpoch(size_t lpIndex, simtime_t gvt, simtime_t safeTime, simtime_t horizon)
+{
+    Simulation& lp = *m_lps[lpIndex];
+
+    // nothing could be rolled back before GVT
+    lp.CollectFossils(gvt);
+
+    // messages arriving after the LP ran out of work are delivered in the next epoch
+    while (true)
+    {
+        const bool delivered = DeliverIncoming(lpIndex);
+        const size_t count = lp.RunOptimistic(safeTime, horizon, _optimisticBatchSize);
+        m_epochDispatches[lpIndex] += count;
+
+        if (count == 0 && !delivered)
+            break;
+    }
+}
+
+bool ParallelSimulation::GetTerminatedExitCode(int64_t& exitCode) const
+{
+    for (auto& lp : m_lps)
+    {
+        if (lp->IsTerminated())
+        {
+            exitCode = lp->GetExitCode();
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool ParallelSimulation::GetCommittedExitCode(simtime_t gvt, int64_t& exitCode, simtime_t& terminateTime) const
+{
+    bool found = false;
+
+    // the soonest termination wins, no matter which LP got to it first
+    for (auto& lp : m_lps)
+    {
+        if (lp->IsTerminated() && lp->GetTerminateTime() < gvt && (!found || lp->GetTerminateTime() < terminateTime))
+        {
+            exitCode = lp->GetExitCode();
+            terminateTime = lp->GetTerminateTime();
+            found = true;
+        }
+    }
+
+    return found;
+}
+
+int64_t ParallelSimulation::Run()
+{
+    return RunUntil(SimulationTime_Never);
+}
+
+int64_t ParallelSimulation::RunUntil(simtime_t endTime)
+{
+    const int64_t exitCode = (m_mode == ParallelSimulationMode::OPTIMISTIC) ? RunOptimistic(endTime) : RunConservative(endTime);
+
+    // logical processes do not flush their output after every window
+    for (auto& lp : m_lps)
+        lp->FlushOutput();
+
+    return exitCode;
+}
+
+int64_t ParallelSimulation::RunConservative(simtime_t endTime)
+{
+    int64_t exitCode = SimulationExitCode_OK;
+
+    while (!GetTerminatedExitCode(exitCode))
+    {
+        // lower bound of time of any future event; the messages not yet delivered are counted in
+        simtime_t lowerBound = SimulationTime_Never;
+        for (size_t i = 0; i < m_lps.size(); i++)
+        {
+            lowerBound = std::min(lowerBound, m_lps[i]->GetNextEventTime());
+            lowerBound = std::min(lowerBound, m_outboxMinTime[m_writeParity][i]);
+        }
+
+        if (lowerBound == SimulationTime_Never || lowerBound >= endTime)
+            break;
+
+        // nothing sent within the window could be received sooner than its end
+        const simtime_t windowEnd = std::min(AddTime(lowerBound, m_lookahead), endTime);
+
+        // messages written so far are delivered within this window, new messages go to the other parity
+        m_writeParity ^= 1;
+        std::fill(m_outboxMinTime[m_writeParity].begin(), m_outboxMinTime[m_writeParity].end(), SimulationTime_Never);
+
+        for (size_t i = 0; i < m_lps.size(); i++)
+            m_pool.Submit([this, i, windowEnd]() { RunWindow(i, windowEnd); });
+        m_pool.Wait();
+
+        m_windowCount++;
+    }
+
+    return exitCode;
+}
+
+int64_t ParallelSimulation::RunOptimistic(simtime_t endTime)
+{
+    int64_t exitCode = SimulationExitCode_OK;
+
+    while (true)
+    {
+        // GVT - no rollback could go before it; the terminated LPs do not receive anything, until their termination
+        // is rolled back
+        simtime_t gvt = SimulationTime_Never;
+        for (size_t i = 0; i < m_lps.size(); i++)
+        {
+            if (!m_lps[i]->IsTerminated())
+                gvt = std::min(gvt, m_lps[i]->GetNextEventTime());
+            gvt = std::min(gvt, m_incoming[i]->minTime);
+        }
+
+        // the termination is final, when it could not be rolled back anymore; the events sooner than lookahead after it
+        // may have been dispatched safely (with no way back), so the LPs are rolled back and finished exactly to that
+        // time - the results then do not depend on how far the speculative execution got
+        simtime_t terminateTime;
+        if (GetCommittedExitCode(gvt, exitCode, terminateTime))
+        {
+            const simtime_t finalTime = AddTime(terminateTime, m_lookahead);
+
+            for (auto& lp : m_lps)
+                lp->Rollback(finalTime);
+
+            // nothing sent from now on could be received before final time, so single epoch is enough
+            for (size_t i = 0; i < m_lps.size(); i++)
+                m_pool.Submit([this, i, gvt, finalTime]() { RunEpoch(i, gvt, finalTime, finalTime); });
+            m_pool.Wait();
+
+            for (auto& lp : m_lps)
+                lp->CollectFossils(SimulationTime_Never);
+            break;
+        }
+
+        if (gvt == SimulationTime_Never || gvt >= endTime)
+        {
+            for (auto& lp : m_lps)
+                lp->CollectFossils(gvt);
+            break;
+        }
+
+        // nothing sent from now on could be received sooner than lookahead after GVT, so the objects scheduled
+        // before it are dispatched safely
+        const simtime_t safeTime = std::min(AddTime(gvt, m_lookahead), endTime);
+        const simtime_t horizon = std::min(AddTime(gvt, GetOptimismWindow()), endTime);
+
+        const uint64_t rolledBack = GetRolledBackMessageCount();
+        std::fill(m_epochDispatches.begin(), m_epochDispatches.end(), 0);
+
+        for (size_t i = 0; i < m_lps.size(); i++)
+            m_pool.Submit([this, i, gvt, safeTime, horizon]() { RunEpoch(i, gvt, safeTime, horizon); });
+        m_pool.Wait();
+
+        m_windowCount++;
+
+        if (m_optimismWindow == 0)
+        {
+            uint64_t dispatched = 0;
+            for (auto count : m_epochDispatches)
+                dispatched += count;
+
+            AdaptOptimismWindow(dispatched, GetRolledBackMessageCount() - rolledBack);
+        }
+    }
+
+    return exitCode;
+}
+
+simtime_t ParallelSimulation::GetSimulationTime() const
+{
+    simtime_t time = 0;
+    for (auto& lp : m_lps)
+        time = std::max(time, lp->GetSimulationTime());
+
+    return time;
+}
+
+uint64_t ParallelSimulation::GetWindowCount() const
+{
+    return m_windowCount;
+}
+
+uint64_t ParallelSimulation::GetRejectedMessageCount() const
+{
+    return m_rejectedMessages;
+}
+
+uint64_t ParallelSimulation::GetRollbackCount() const
+{
+    uint64_t count = 0;
+    for (auto& lp : m_lps)
+        count += lp->GetRollbackCount();
+
+    return count;
+}
+
+uint64_t ParallelSimulation::GetRolledBackMessageCount() const
+{
+    uint64_t count = 0;
+    for (auto& lp : m_lps)
+        count += lp->GetRolledBackMessageCount();
+
+    return count;
+}
@@ -0,0 +1,170 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <array>
+#include <atomic>
+#include <mutex>
+#include <memory>
+#include <iostream>
+
+#include "Simulation.h"
+#include "SimulationMessage.h"
+#include "ThreadPool.h"
+
+/*
+ * Synchronization modes of parallel simulation
+ */
+enum class ParallelSimulationMode
+{
+    CONSERVATIVE,   // synchronous windows bounded by lookahead (YAWNS); no event is ever executed out of order
+    OPTIMISTIC,     // messages are received speculatively beyond the lookahead and rolled back on stragglers (Time Warp)
+};
+
+/*
+ * Parallel discrete-event simulation of model partitioned to logical processes
+ *
+ * Every logical process (LP) is a standalone simulation with its own calendars and objects; the objects of different
+ * LPs interact only by timestamped messages (SendMessage / ReceiveMessage). The model declares its lookahead - the
+ * minimal delay of messages sent to other LPs. The LPs are executed in synchronous windows: the window starts at
+ * the soonest event time of all LPs and spans the lookahead, so no message sent within the window could be received
+ * within it. Messages are kept in outboxes of their source LP and delivered to target LPs at the start of the next
+ * window; the receive order does not depend on delivery order, so the results do not depend on number of threads
+ *
+ * In optimistic mode, the LPs run asynchronously in epochs and receive messages speculatively up to the optimism window
+ * ahead of global virtual time (GVT - the lower bound of time of any unprocessed event or undelivered message, computed
+ * between epochs). Messages are delivered to incoming queues of target LPs right away. The state of target process is
+ * saved before receive (or restored by reverse computation, see SimProcess::SetStateSavingMode); when a message arrives
+ * with time sooner than already received message (straggler), the LP is rolled back to its time, and the messages sent
+ * by rolled back receives are cancelled by anti-messages. Saved states older than GVT are discarded (fossil collection).
+ * Objects scheduled in calendars are still dispatched within lookahead of GVT only, since they could not be rolled back;
+ * the same holds for messages to objects without state saving. Received messages must not schedule or remove objects,
+ * their only side effects should be the state of target process and sent messages
+ */
+class ParallelSimulation : public MessageRouter
+{
+    public:
+        // creates parallel simulation with given number of logical processes, executed by given number of threads
+        // (0 stands for the number of hardware threads)
+        ParallelSimulation(size_t lpCount, size_t threadCount = 0, ParallelSimulationMode mode = ParallelSimulationMode::CONSERVATIVE);
+        virtual ~ParallelSimulation();
+
+        // retrieves synchronization mode
+        ParallelSimulationMode GetMode() const;
+        // retrieves number of logical processes
+        size_t GetLogicalProcessCount() const;
+        // retrieves simulation of logical process; the model is set up through it (calendars, objects)
+        SimulationPtr const& GetLogicalProcess(size_t index) const;
+
+        // sets lookahead - minimal delay of messages between logical processes (at least 1)
+        void SetLookahead(simtime_t lookahead);
+        // retrieves lookahead
+        simtime_t GetLookahead() const;
+        // sets optimism window - how far ahead of GVT the messages are received speculatively in optimistic mode;
+        // 0 stands for adaptive window, which starts at single lookahead and is halved, when too many messages are rolled
+        // back, and grows by a lookahead (up to 64 lookaheads) after a few epochs with almost no rollback
+        void SetOptimismWindow(simtime_t window);
+        // retrieves optimism window (current window, when adaptive)
+        simtime_t GetOptimismWindow() const;
+        // sets master seed of random streams of all logical processes; should be called before adding objects
+        void SetMasterSeed(uint64_t seed);
+
+        // runs simulation until all logical processes are empty, or until any of them is terminated; returns exit code
+        // of the first terminated logical process (SimulationExitCode_OK if none)
+        int64_t Run();
+        // runs simulation until all events scheduled before given time are executed; may be called repeatedly
+        int64_t RunUntil(simtime_t endTime);
+
+        // retrieves time reached by simulation (the latest time of logical processes)
+        simtime_t GetSimulationTime() const;
+        // retrieves number of executed windows (epochs in optimistic mode)
+        uint64_t GetWindowCount() const;
+        // retrieves number of messages rejected due to lookahead violation
+        uint64_t GetRejectedMessageCount() const;
+        // retrieves number of rollbacks of all logical processes (optimistic mode)
+        uint64_t GetRollbackCount() const;
+        // retrieves number of rolled back messages of all logical processes (optimistic mode)
+        uint64_t GetRolledBackMessageCount() const;
+
+        bool RouteMessage(SimulationMessage const& message) override;
+        bool CheckRoute(uint32_t targetLP, simtime_t delay) override;
+
+    protected:
+        // runs conservative windows until given end time
+        int64_t RunConservative(simtime_t endTime);
+        // runs optimistic epochs until GVT reaches given end time
+        int64_t RunOptimistic(simtime_t endTime);
+        // delivers messages sent to logical process in previous window
+        void DeliverMessages(size_t lpIndex);
+        // delivers messages sent to logical process in previous window and runs it until given end time
+        void RunWindow(size_t lpIndex, simtime_t windowEnd);
+        // delivers messages from incoming queue of logical process (optimistic mode); returns false, if there was none
+        bool DeliverIncoming(size_t lpIndex);
+        // discards states older than GVT and runs logical process optimistically, until there's nothing to receive
+        // before horizon; the incoming messages are delivered between short batches, so the stragglers are found early
+        void RunEpoch(size_t lpIndex, simtime_t gvt, simtime_t safeTime, simtime_t horizon);
+        // multiplies lookahead by given count; saturates at SimulationTime_Never
+        simtime_t MultiplyLookahead(simtime_t count) const;
+        // adapts optimism window to rate of rolled back messages of the last epoch
+        void AdaptOptimismWindow(uint64_t dispatched, uint64_t rolledBack);
+        // retrieves exit code of the first terminated logical process; returns false, if none was terminated
+        bool GetTerminatedExitCode(int64_t& exitCode) const;
+        // retrieves exit code and time of the soonest termination before given GVT (so it could not be rolled back
+        // anymore); returns false, if there's none
+        bool GetCommittedExitCode(simtime_t gvt, int64_t& exitCode, simtime_t& terminateTime) const;
+
+        // synchronization mode
+        ParallelSimulationMode m_mode;
+        // output stream without buffer; the logical processes log concurrently, so they log to nowhere by default
+        std::ostream m_nullOutput;
+        // logical processes
+        std::vector<SimulationPtr> m_lps;
+        // executes logical processes
+        ThreadPool m_pool;
+
+        // messages sent to other logical processes, indexed by [parity][source LP][target LP]; the messages are written
+        // to one parity during a window, while the other is being delivered
+        std::array<std::vector<std::vector<std::vector<SimulationMessage>>>, 2> m_outboxes;
+        // the soonest time of messages in outbox of each source LP, indexed by [parity][source LP]
+        std::array<std::vector<simtime_t>, 2> m_outboxMinTime;
+        // parity of outboxes written in current window
+        size_t m_writeParity;
+
+        /*
+         * Queue of messages sent to logical process (optimistic mode)
+         */
+        struct IncomingQueue
+        {
+            // guards the queue; messages are sent to it from threads of other LPs
+            std::mutex mutex;
+            // queued messages, in order of send
+            std::vector<SimulationMessage> messages;
+            // the soonest time of queued messages
+            simtime_t minTime = SimulationTime_Never;
+        };
+
+        // incoming queues, indexed by target LP
+        std::vector<std::unique_ptr<IncomingQueue>> m_incoming;
+        // messages being delivered from incoming queues, indexed by target LP (kept to reuse allocated memory)
+        std::vector<std::vector<SimulationMessage>> m_delivered;
+
+        // lookahead
+        simtime_t m_lookahead;
+        // optimism window (0 for adaptive)
+        simtime_t m_optimismWindow;
+        // current adaptive optimism window (0 until the first epoch)
+        simtime_t m_adaptiveWindow;
+        // number of consecutive epochs with low rollback rate
+        size_t m_calmEpochCount;
+        // number of dispatches of every logical process in the last epoch
+        std::vector<uint64_t> m_epochDispatches;
+        // number of executed windows
+        uint64_t m_windowCount;
+        // number of messages rejected due to lookahead violation
+        std::atomic<uint64_t> m_rejectedMessages;
+};
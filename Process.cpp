@@ -8,7 +8,7 @@
 #include "Simulation.h"
 
 SimProcess::SimProcess(SimulationPtr simulation, uint32_t objectClass)
-    : SimulationObject(SimulationObjectType::PROCESS, simulation, objectClass)
+    : SimulationObject(SimulationObjectType::PROCESS, simulation, objectClass), m_stateSaving(StateSavingMode::NONE)
 {
     //
 }
@@ -27,3 +27,28 @@ void SimProcess::ReceiveEvent(SimEvent& ev)
 {
     //
 }
+
+StateSavingMode SimProcess::GetStateSavingMode() const
+{
+    return m_stateSaving;
+}
+
+void SimProcess::SetStateSavingMode(StateSavingMode mode)
+{
+    m_stateSaving = mode;
+}
+
+void SimProcess::SaveState(ProcessSnapshot& snapshot) const
+{
+    //
+}
+
+void SimProcess::RestoreState(ProcessSnapshot const& snapshot)
+{
+    //
+}
+
+void SimProcess::ReverseMessage(SimulationMessage const& message)
+{
+    //
+}
@@ -7,6 +7,7 @@
 #pragma once
 
 #include "SimulationObject.h"
+#include "ProcessSnapshot.h"
 
 #include "Types.h"
 
@@ -24,9 +25,24 @@ class SimProcess : public SimulationObject
         // method called upon receiving event
         virtual void ReceiveEvent(SimEvent& ev);
 
+        // retrieves state saving mode (see ParallelSimulationMode::OPTIMISTIC)
+        StateSavingMode GetStateSavingMode() const;
+
     protected:
-        //
+        friend class Simulation;
+
+        // sets state saving mode; the process, which receives messages in optimistic parallel simulation, should support
+        // state saving, otherwise the messages are received only when they could not be rolled back
+        void SetStateSavingMode(StateSavingMode mode);
+
+        // saves state before receiving message (StateSavingMode::COPY)
+        virtual void SaveState(ProcessSnapshot& snapshot) const;
+        // restores state saved before receiving message, which is being rolled back (StateSavingMode::COPY)
+        virtual void RestoreState(ProcessSnapshot const& snapshot);
+        // reverts effect of received message, which is being rolled back (StateSavingMode::REVERSE)
+        virtual void ReverseMessage(SimulationMessage const& message);
 
     private:
-        //
+        // state saving mode
+        StateSavingMode m_stateSaving;
 };
@@ -0,0 +1,89 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <memory>
+#include <cassert>
+
+/*
+ * Supported modes of process state saving (used by optimistic parallel simulation to undo received messages)
+ */
+enum class StateSavingMode
+{
+    NONE,           // state could not be restored; messages are received only when they could not be rolled back
+    COPY,           // state is copied before every received message (SaveState / RestoreState)
+    REVERSE,        // effect of received message is reverted by reverse computation (ReverseMessage)
+};
+
+/*
+ * Saved copy of process state; holds a value of any copyable type (e.g. structure with all mutable members of process,
+ * including its random generators). The snapshots are reused, so storing the state of the same type again just assigns
+ * it without allocation
+ */
+class ProcessSnapshot
+{
+    public:
+        // stores copy of given state
+        template<typename T>
+        void Store(T const& state)
+        {
+            if (m_state && m_type == TypeTag<T>())
+                static_cast<Holder<T>*>(m_state.get())->state = state;
+            else
+            {
+                m_state.reset(new Holder<T>(state));
+                m_type = TypeTag<T>();
+            }
+        }
+
+        // retrieves stored state; the type must match the stored one
+        template<typename T>
+        T const& Get() const
+        {
+            assert(m_state && m_type == TypeTag<T>());
+            return static_cast<const Holder<T>*>(m_state.get())->state;
+        }
+
+        // is there any stored state?
+        bool empty() const
+        {
+            return !m_state;
+        }
+
+    private:
+        // retrieves unique tag of stored type
+        template<typename T>
+        static const void* TypeTag()
+        {
+            static const char tag = 0;
+            return &tag;
+        }
+
+        /*
+         * Type-erased base of stored state
+         */
+        struct HolderBase
+        {
+            virtual ~HolderBase() { };
+        };
+
+        /*
+         * Stored state of given type
+         */
+        template<typename T>
+        struct Holder : public HolderBase
+        {
+            Holder(T const& value) : state(value) { };
+
+            T state;
+        };
+
+        // stored state
+        std::unique_ptr<HolderBase> m_state;
+        // tag of stored type
+        const void* m_type = nullptr;
+};
@@ -0,0 +1,227 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "QuantileStatistic.h"
+#include "Simulation.h"
+#include "CheckpointWriter.h"
+#include "CheckpointReader.h"
+
+#include <cmath>
+#include <algorithm>
+#include <limits>
+
+// size of observation buffer relative to compression; larger buffer makes the merges less frequent
+static const size_t _bufferFactor = 5;
+
+QuantileStatistic::QuantileStatistic(double compression)
+    : m_compression(std::max(compression, 10.0)), m_count(0), m_min(0.0), m_max(0.0)
+{
+    m_bufferSize = static_cast<size_t>(m_compression) * _bufferFactor;
+
+    // the buffer takes the centroids during merge, so nothing is reallocated later
+    m_centroids.reserve(static_cast<size_t>(m_compression) + 1);
+    m_buffer.reserve(m_bufferSize + static_cast<size_t>(m_compression) + 1);
+}
+
+void QuantileStatistic::Add(double value)
+{
+    // statistics are shared by objects, so they could not be updated during parallel phase
+    assert(!Simulation::IsDeferring());
+
+    m_min = (m_count == 0) ? value : std::min(m_min, value);
+    m_max = (m_count == 0) ? value : std::max(m_max, value);
+    m_count++;
+
+    AddCentroid(value, 1.0);
+}
+
+void QuantileStatistic::Merge(QuantileStatistic const& other)
+{
+    if (other.m_count == 0)
+        return;
+
+    m_min = (m_count == 0) ? other.m_min : std::min(m_min, other.m_min);
+    m_max = (m_count == 0) ? other.m_max : std::max(m_max, other.m_max);
+    m_count += other.m_count;
+
+    other.Compress();
+    for (auto const& centroid : other.m_centroids)
+        AddCentroid(centroid.mean, centroid.weight);
+}
+
+void QuantileStatistic::Reset()
+{
+    m_centroids.clear();
+    m_buffer.clear();
+    m_count = 0;
+    m_min = 0.0;
+    m_max = 0.0;
+}
+
+void QuantileStatistic::Serialize(CheckpointWriter& writer) const
+{
+    writer.WriteDouble(m_compression);
+    writer.WriteVarUInt(m_count);
+    writer.WriteDouble(m_min);
+    writer.WriteDouble(m_max);
+
+    for (auto const* centroids : { &m_centroids, &m_buffer })
+    {
+        writer.WriteVarUInt(centroids->size());
+        for (auto const& centroid : *centroids)
+        {
+            writer.WriteDouble(centroid.mean);
+            writer.WriteDouble(centroid.weight);
+        }
+    }
+}
+
+bool QuantileStatistic::Deserialize(CheckpointReader& reader)
+{
+    // the buffers are sized by compression
+    const double compression = reader.ReadDouble();
+    if (compression != m_compression)
+        *this = QuantileStatistic(compression);
+
+    m_count = reader.ReadVarUInt();
+    m_min = reader.ReadDouble();
+    m_max = reader.ReadDouble();
+
+    for (auto* centroids : { &m_centroids, &m_buffer })
+    {
+        const uint64_t count = reader.ReadVarUInt();
+        centroids->clear();
+        for (uint64_t i = 0; i < count && reader.IsGood(); i++)
+        {
+            Centroid centroid;
+            centroid.mean = reader.ReadDouble();
+            centroid.weight = reader.ReadDouble();
+            centroids->push_back(centroid);
+        }
+    }
+
+    return reader.IsGood() && m_compression == compression && m_buffer.size() < m_bufferSize;
+}
+
+uint64_t QuantileStatistic::GetCount() const
+{
+    return m_count;
+}
+
+double QuantileStatistic::GetMin() const
+{
+    return m_min;
+}
+
+double QuantileStatistic::GetMax() const
+{
+    return m_max;
+}
+
+double QuantileStatistic::GetQuantile(double q) const
+{
+    Compress();
+
+    if (m_centroids.empty())
+        return 0.0;
+
+    q = std::min(std::max(q, 0.0), 1.0);
+
+    // interpolate between centers of centroids; the extremes are known exactly
+    const double position = q * static_cast<double>(m_count);
+    double previousPosition = 0.0;
+    double previousValue = m_min;
+    double weightSoFar = 0.0;
+
+    for (auto const& centroid : m_centroids)
+    {
+        const double center = weightSoFar + centroid.weight / 2.0;
+        if (position < center)
+            return previousValue + (centroid.mean - previousValue) * (position - previousPosition) / (center - previousPosition);
+
+        previousPosition = center;
+        previousValue = centroid.mean;
+        weightSoFar += centroid.weight;
+    }
+
+    const double total = static_cast<double>(m_count);
+    if (total <= previousPosition)
+        return m_max;
+
+    return previousValue + (m_max - previousValue) * (position - previousPosition) / (total - previousPosition);
+}
+
+double QuantileStatistic::GetCompression() const
+{
+    return m_compression;
+}
+
+void QuantileStatistic::AddCentroid(double mean, double weight)
+{
+    m_buffer.push_back({ mean, weight });
+
+    if (m_buffer.size() >= m_bufferSize)
+        Compress();
+}
+
+void QuantileStatistic::Compress() const
+{
+    if (m_buffer.empty())
+        return;
+
+    m_buffer.insert(m_buffer.end(), m_centroids.begin(), m_centroids.end());
+    std::sort(m_buffer.begin(), m_buffer.end(), [](Centroid const& a, Centroid const& b) { return a.mean < b.mean; });
+
+    double total = 0.0;
+    for (auto const& centroid : m_buffer)
+        total += centroid.weight;
+
+    // merge neighbouring centroids as long as the merged one spans at most one unit of index space; the scale grows
+    // with the logarithm of count, so the number of centroids stays bounded
+    const double normalizer = 4.0 * std::log(std::max(total / m_compression, 1.0)) + 24.0;
+
+    m_centroids.clear();
+
+    Centroid current = m_buffer.front();
+    double weightSoFar = 0.0;
+    double weightLimit = total * IndexToScale(ScaleToIndex(0.0, normalizer) + 1.0, normalizer);
+
+    for (size_t i = 1; i < m_buffer.size(); i++)
+    {
+        Centroid const& next = m_buffer[i];
+
+        if (weightSoFar + current.weight + next.weight <= weightLimit)
+        {
+            current.weight += next.weight;
+            current.mean += (next.mean - current.mean) * next.weight / current.weight;
+        }
+        else
+        {
+            weightSoFar += current.weight;
+            m_centroids.push_back(current);
+            weightLimit = total * IndexToScale(ScaleToIndex(weightSoFar / total, normalizer) + 1.0, normalizer);
+            current = next;
+        }
+    }
+
+    m_centroids.push_back(current);
+    m_buffer.clear();
+}
+
+double QuantileStatistic::ScaleToIndex(double q, double normalizer) const
+{
+    if (q <= 0.0)
+        return -std::numeric_limits<double>::infinity();
+    if (q >= 1.0)
+        return std::numeric_limits<double>::infinity();
+
+    return m_compression / normalizer * std::log(q / (1.0 - q));
+}
+
+double QuantileStatistic::IndexToScale(double k, double normalizer) const
+{
+    return 1.0 / (1.0 + std::exp(-k * normalizer / m_compression));
+}
@@ -0,0 +1,90 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+// default compression of quantile statistic (higher is more accurate and takes more memory)
+constexpr double QuantileStatistic_DefaultCompression = 200.0;
+
+/*
+ * Streaming estimate of quantiles of observed values (e.g. 95th percentile of response time)
+ *
+ * The values are summarized by merging t-digest (Dunning): observations are collected in a buffer, which is merged
+ * into a sorted list of weighted centroids when full. The centroids are small near both tails, so extreme quantiles
+ * are accurate. The number of centroids is bounded by the compression, so the statistic takes fixed memory; unlike P2
+ * estimator, the digests of replications could be merged
+ */
+class QuantileStatistic
+{
+    public:
+        QuantileStatistic(double compression = QuantileStatistic_DefaultCompression);
+
+        // adds observed value
+        void Add(double value);
+        // merges statistic of other observations (e.g. other replication)
+        void Merge(QuantileStatistic const& other);
+        // forgets all observations
+        void Reset();
+        // writes state to checkpoint (including observations not merged yet, so the continued run merges the same way)
+        void Serialize(CheckpointWriter& writer) const;
+        // reads state written by Serialize, including compression; returns false, if the state is not valid
+        bool Deserialize(CheckpointReader& reader);
+
+        // retrieves number of observations
+        uint64_t GetCount() const;
+        // retrieves minimum observed value
+        double GetMin() const;
+        // retrieves maximum observed value
+        double GetMax() const;
+        // retrieves estimate of given quantile (0 - 1)
+        double GetQuantile(double q) const;
+        // retrieves compression
+        double GetCompression() const;
+
+    protected:
+        /*
+         * Weighted centroid of observations
+         */
+        struct Centroid
+        {
+            // mean of observations
+            double mean;
+            // number of observations
+            double weight;
+        };
+
+        // adds centroid of given weight
+        void AddCentroid(double mean, double weight);
+        // merges buffered observations into centroids
+        void Compress() const;
+        // scale function; maps quantile to centroid index space (logistic scale, normalized by given value)
+        double ScaleToIndex(double q, double normalizer) const;
+        // inverse of scale function
+        double IndexToScale(double k, double normalizer) const;
+
+    private:
+        // compression (bounds the number of centroids)
+        double m_compression;
+        // number of buffered observations, that triggers merge
+        size_t m_bufferSize;
+        // centroids sorted by mean (compressed lazily, when queried)
+        mutable std::vector<Centroid> m_centroids;
+        // observations not merged yet
+        mutable std::vector<Centroid> m_buffer;
+        // number of observations
+        uint64_t m_count;
+        // minimum observed value
+        double m_min;
+        // maximum observed value
+        double m_max;
+};
@@ -0,0 +1,167 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "ReplicationRunner.h"
+
+uint64_t ReplicationContext::GetReplication() const
+{
+    return m_replication;
+}
+
+size_t ReplicationContext::GetWorkerIndex() const
+{
+    return m_workerIndex;
+}
+
+SimulationPtr const& ReplicationContext::GetSimulation() const
+{
+    return m_simulation;
+}
+
+int64_t ReplicationContext::GetExitCode() const
+{
+    return m_exitCode;
+}
+
+void ReplicationContext::Report(const std::string& name, double value)
+{
+    m_results.emplace_back(name, value);
+}
+
+std::vector<std::pair<std::string, double>> const& ReplicationContext::GetResults() const
+{
+    return m_results;
+}
+
+ReplicationRunner::ReplicationRunner(size_t threadCount)
+    : m_pool(threadCount)
+{
+    for (size_t i = 0; i < m_pool.GetThreadCount(); i++)
+        m_workerStates.emplace_back(new WorkerState());
+
+    m_masterSeed = (static_cast<uint64_t>(Simulation::GetTrueRandomNumber()) << 32) | Simulation::GetTrueRandomNumber();
+}
+
+void ReplicationRunner::SetModel(ReplicationModel model)
+{
+    m_model = model;
+}
+
+void ReplicationRunner::SetCollector(ReplicationCollector collector)
+{
+    m_collector = collector;
+}
+
+void ReplicationRunner::SetFinishedCallback(ReplicationCallback callback)
+{
+    m_finishedCallback = callback;
+}
+
+void ReplicationRunner::SetMasterSeed(uint64_t seed)
+{
+    m_masterSeed = seed;
+}
+
+uint64_t ReplicationRunner::GetMasterSeed() const
+{
+    return m_masterSeed;
+}
+
+size_t ReplicationRunner::GetThreadCount() const
+{
+    return m_pool.GetThreadCount();
+}
+
+uint64_t ReplicationRunner::Run(uint64_t count, uint64_t firstReplication)
+{
+    for (uint64_t i = 0; i < count; i++)
+    {
+        const uint64_t replication = firstReplication + i;
+        m_pool.Submit([this, replication]() { RunReplication(replication); });
+    }
+
+    m_pool.Wait();
+
+    // merge and reset worker aggregates
+    uint64_t failed = 0;
+    for (auto& state : m_workerStates)
+    {
+        for (auto& summary : state->summaries)
+            m_summaries[summary.first].Merge(summary.second);
+        m_statistics.Merge(state->statistics);
+
+        failed += state->failedCount;
+
+        state->summaries.clear();
+        state->statistics.Clear();
+        state->failedCount = 0;
+    }
+
+    return failed;
+}
+
+void ReplicationRunner::RunReplication(uint64_t replication)
+{
+    const size_t workerIndex = m_pool.GetCurrentWorkerIndex();
+    WorkerState& state = *m_workerStates[workerIndex];
+
+    ReplicationContext context;
+    context.m_replication = replication;
+    context.m_workerIndex = workerIndex;
+    context.m_exitCode = SimulationExitCode_Fail;
+
+    // the streams are seeded when the objects are added, so the seed must be set before the model is built
+    context.m_simulation = Simulation::Create(state.output);
+    context.m_simulation->SetMasterSeed(m_masterSeed);
+    context.m_simulation->SetReplication(replication);
+    context.m_simulation->GetLogger().SetLevel(LogLevel::NONE);
+
+    if (m_model)
+        m_model(context);
+
+    context.m_exitCode = context.m_simulation->Run();
+
+    if (m_collector)
+        m_collector(context);
+
+    for (auto& result : context.m_results)
+        state.summaries[result.first].Add(result.second);
+
+    // time-weighted statistics are accounted up to the end of run
+    context.m_simulation->GetStatistics().Close();
+    state.statistics.Merge(context.m_simulation->GetStatistics());
+
+    if (context.m_exitCode != SimulationExitCode_OK)
+        state.failedCount++;
+
+    if (m_finishedCallback)
+    {
+        std::lock_guard<std::mutex> lock(m_callbackMutex);
+        m_finishedCallback(context);
+    }
+
+    // release the simulation on worker, so the memory is reused by its next replication
+    context.m_simulation.reset();
+}
+
+std::map<std::string, TallyStatistic> const& ReplicationRunner::GetSummaries() const
+{
+    return m_summaries;
+}
+
+TallyStatistic ReplicationRunner::GetSummary(const std::string& name) const
+{
+    auto itr = m_summaries.find(name);
+    if (itr == m_summaries.end())
+        return TallyStatistic();
+
+    return itr->second;
+}
+
+StatisticRegistry const& ReplicationRunner::GetStatistics() const
+{
+    return m_statistics;
+}
@@ -0,0 +1,140 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include <map>
+#include <functional>
+#include <iostream>
+#include <mutex>
+
+#include "Simulation.h"
+#include "ThreadPool.h"
+
+/*
+ * Context of single replication; passed to model callbacks
+ */
+class ReplicationContext
+{
+    friend class ReplicationRunner;
+    public:
+        // retrieves replication number
+        uint64_t GetReplication() const;
+        // retrieves index of worker thread running the replication
+        size_t GetWorkerIndex() const;
+        // retrieves simulation of replication
+        SimulationPtr const& GetSimulation() const;
+        // retrieves simulation exit code (valid after the simulation finished)
+        int64_t GetExitCode() const;
+
+        // reports named result of replication
+        void Report(const std::string& name, double value);
+        // retrieves results reported so far
+        std::vector<std::pair<std::string, double>> const& GetResults() const;
+
+    private:
+        // replication number
+        uint64_t m_replication;
+        // index of worker thread
+        size_t m_workerIndex;
+        // simulation of replication
+        SimulationPtr m_simulation;
+        // simulation exit code
+        int64_t m_exitCode;
+        // reported results
+        std::vector<std::pair<std::string, double>> m_results;
+};
+
+// sets up model in simulation of replication (calendars, objects, ...)
+using ReplicationModel = std::function<void(ReplicationContext& context)>;
+// reports results of finished replication
+using ReplicationCollector = std::function<void(ReplicationContext& context)>;
+// notifies about finished replication; calls are serialized
+using ReplicationCallback = std::function<void(ReplicationContext const& context)>;
+
+/*
+ * Runner of independent replications of the same model
+ *
+ * Every replication gets its own simulation, seeded with common master seed and its replication number, so the runs
+ * are reproducible and use independent random streams. The replications are run on work-stealing thread pool; each
+ * worker aggregates results of its replications, and the aggregates are merged when all replications finish.
+ * The simulations log to nowhere, and the logging is disabled by default
+ */
+class ReplicationRunner
+{
+    public:
+        // creates runner with given number of worker threads; 0 stands for the number of hardware threads
+        explicit ReplicationRunner(size_t threadCount = 0);
+
+        // sets model setup callback
+        void SetModel(ReplicationModel model);
+        // sets callback reporting results of finished simulation
+        void SetCollector(ReplicationCollector collector);
+        // sets callback called after each replication is finished
+        void SetFinishedCallback(ReplicationCallback callback);
+
+        // sets master seed of all replications (by default, drawn from true random number device)
+        void SetMasterSeed(uint64_t seed);
+        // retrieves master seed of all replications
+        uint64_t GetMasterSeed() const;
+        // retrieves number of worker threads
+        size_t GetThreadCount() const;
+
+        // runs given number of replications, numbered from firstReplication; blocks until all of them finish,
+        // returns number of replications, that did not finish with SimulationExitCode_OK
+        uint64_t Run(uint64_t count, uint64_t firstReplication = 0);
+
+        // retrieves summaries of reported results, merged from all runs so far
+        std::map<std::string, TallyStatistic> const& GetSummaries() const;
+        // retrieves summary of named result (empty, if the result was never reported)
+        TallyStatistic GetSummary(const std::string& name) const;
+        // retrieves output statistics of simulations (see Simulation::GetStatistics), merged from all runs so far
+        StatisticRegistry const& GetStatistics() const;
+
+    protected:
+        /*
+         * State of single worker thread
+         */
+        struct WorkerState
+        {
+            WorkerState() : output(nullptr), failedCount(0) { };
+
+            // output stream without buffer; the simulations log to nowhere
+            std::ostream output;
+            // summaries of results of replications run by this worker
+            std::map<std::string, TallyStatistic> summaries;
+            // merged output statistics of replications run by this worker
+            StatisticRegistry statistics;
+            // number of failed replications
+            uint64_t failedCount;
+        };
+
+        // runs single replication on current worker
+        void RunReplication(uint64_t replication);
+
+        // worker threads
+        ThreadPool m_pool;
+        // worker states, indexed by worker index
+        std::vector<std::unique_ptr<WorkerState>> m_workerStates;
+
+        // model setup callback
+        ReplicationModel m_model;
+        // results collector
+        ReplicationCollector m_collector;
+        // finished replication callback
+        ReplicationCallback m_finishedCallback;
+        // serializes calls of finished replication callback
+        std::mutex m_callbackMutex;
+
+        // master seed
+        uint64_t m_masterSeed;
+        // merged summaries
+        std::map<std::string, TallyStatistic> m_summaries;
+        // merged output statistics
+        StatisticRegistry m_statistics;
+};
@@ -0,0 +1,116 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <vector>
+#include <atomic>
+#include <cstddef>
+
+// assumed size of cache line; producer and consumer positions are kept on separate lines
+constexpr size_t RingBuffer_CacheLineSize = 64;
+
+/*
+ * Bounded lock-free ring buffer for exactly one producer thread and one consumer thread
+ *
+ * The capacity is rounded up to power of two, so the positions could be masked. Both sides cache the position
+ * of the other side and reload it only when the cached value says the buffer is full (or empty), so the shared
+ * cache lines are touched only occasionally
+ */
+template<typename T>
+class RingBuffer
+{
+    public:
+        RingBuffer(size_t capacity = 0)
+        {
+            Reset(capacity);
+        }
+
+        // discards contents and reallocates buffer; must not be called while producer or consumer is active
+        void Reset(size_t capacity)
+        {
+            size_t rounded = 1;
+            while (rounded < capacity)
+                rounded *= 2;
+
+            m_items.assign(capacity ? rounded : 0, T());
+            m_mask = rounded - 1;
+            m_head.store(0, std::memory_order_relaxed);
+            m_tail.store(0, std::memory_order_relaxed);
+            m_cachedHead = 0;
+            m_cachedTail = 0;
+        }
+
+        // retrieves capacity of buffer
+        size_t Capacity() const
+        {
+            return m_items.size();
+        }
+
+        // producer: retrieves number of free positions (at least; the consumer may release more meanwhile)
+        size_t Free()
+        {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_cachedHead == m_items.size())
+                m_cachedHead = m_head.load(std::memory_order_acquire);
+
+            return m_items.size() - (tail - m_cachedHead);
+        }
+
+        // producer: pushes item to buffer; returns false, if the buffer is full
+        bool TryPush(T const& item)
+        {
+            const size_t tail = m_tail.load(std::memory_order_relaxed);
+            if (tail - m_cachedHead == m_items.size())
+            {
+                m_cachedHead = m_head.load(std::memory_order_acquire);
+                if (tail - m_cachedHead == m_items.size())
+                    return false;
+            }
+
+            m_items[tail & m_mask] = item;
+            m_tail.store(tail + 1, std::memory_order_release);
+            return true;
+        }
+
+        // consumer: retrieves number of items ready to be read
+        size_t Available()
+        {
+            m_cachedTail = m_tail.load(std::memory_order_acquire);
+            return m_cachedTail - m_head.load(std::memory_order_relaxed);
+        }
+
+        // consumer: retrieves item at given offset from the oldest one; the offset must be lower than Available()
+        T const& Peek(size_t offset) const
+        {
+            return m_items[(m_head.load(std::memory_order_relaxed) + offset) & m_mask];
+        }
+
+        // consumer: releases given count of the oldest items
+        void Release(size_t count)
+        {
+            m_head.store(m_head.load(std::memory_order_relaxed) + count, std::memory_order_release);
+        }
+
+    private:
+        // stored items
+        std::vector<T> m_items;
+        // mask of position
+        size_t m_mask;
+        char m_sharedPadding[RingBuffer_CacheLineSize];
+
+        // consumer position (next item to be read)
+        std::atomic<size_t> m_head;
+        // consumer cache of producer position
+        size_t m_cachedTail;
+        char m_consumerPadding[RingBuffer_CacheLineSize];
+
+        // producer position (next item to be written)
+        std::atomic<size_t> m_tail;
+        // producer cache of consumer position
+        size_t m_cachedHead;
+        char m_producerPadding[RingBuffer_CacheLineSize];
+};
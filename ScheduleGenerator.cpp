@@ -0,0 +1,92 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "ScheduleGenerator.h"
+
+ScheduleGenerator::ScheduleGenerator()
+    : m_generator(nullptr), m_ops(nullptr), m_kind(ScheduleGeneratorKind::NONE)
+{
+    //
+}
+
+ScheduleGenerator::~ScheduleGenerator()
+{
+    Reset();
+}
+
+void ScheduleGenerator::Reset()
+{
+    if (m_kind == ScheduleGeneratorKind::NONE)
+        return;
+
+    m_ops->destroy(m_generator);
+
+    m_generator = nullptr;
+    m_ops = nullptr;
+    m_kind = ScheduleGeneratorKind::NONE;
+}
+
+void ScheduleGenerator::Seed(uint64_t key, uint64_t stream)
+{
+    if (m_kind == ScheduleGeneratorKind::NONE)
+        return;
+
+    m_ops->seed(m_generator, key, stream);
+}
+
+bool ScheduleGenerator::Save(random_state_sink& sink) const
+{
+    sink.write_state(static_cast<uint64_t>(m_kind));
+
+    switch (m_kind)
+    {
+        case ScheduleGeneratorKind::NONE:
+            return true;
+        case ScheduleGeneratorKind::CONSTANT:
+            static_cast<const constant_generator<simtime_t>*>(m_generator)->save(sink);
+            return true;
+        case ScheduleGeneratorKind::UNIFORM_INT:
+            static_cast<const uniform_int_generator<simtime_t>*>(m_generator)->save(sink);
+            return true;
+        case ScheduleGeneratorKind::EXPONENTIAL:
+            static_cast<const exponential_generator<simtime_t>*>(m_generator)->save(sink);
+            return true;
+        case ScheduleGeneratorKind::GAUSSIAN:
+            static_cast<const gaussian_generator<simtime_t>*>(m_generator)->save(sink);
+            return true;
+        default:
+            return false;
+    }
+}
+
+bool ScheduleGenerator::Load(random_state_source& source)
+{
+    uint64_t kind;
+    if (!source.read_state(kind))
+        return false;
+
+    // the generator is constructed with any parameters, they are overwritten by the stored state
+    switch (static_cast<ScheduleGeneratorKind>(kind))
+    {
+        case ScheduleGeneratorKind::NONE:
+            Reset();
+            return true;
+        case ScheduleGeneratorKind::CONSTANT:
+            Emplace<constant_generator<simtime_t>>(0);
+            return static_cast<constant_generator<simtime_t>*>(m_generator)->load(source);
+        case ScheduleGeneratorKind::UNIFORM_INT:
+            Emplace<uniform_int_generator<simtime_t>>(0, 0);
+            return static_cast<uniform_int_generator<simtime_t>*>(m_generator)->load(source);
+        case ScheduleGeneratorKind::EXPONENTIAL:
+            Emplace<exponential_generator<simtime_t>>(1.0);
+            return static_cast<exponential_generator<simtime_t>*>(m_generator)->load(source);
+        case ScheduleGeneratorKind::GAUSSIAN:
+            Emplace<gaussian_generator<simtime_t>>(0.0, 0.0);
+            return static_cast<gaussian_generator<simtime_t>*>(m_generator)->load(source);
+        default:
+            return false;
+    }
+}
@@ -0,0 +1,196 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <type_traits>
+#include <utility>
+#include <new>
+
+#include "Types.h"
+#include "random/base_generator.h"
+#include "random/constant_generator.h"
+#include "random/uniform_generator.h"
+#include "random/exponential_generator.h"
+#include "random/gaussian_generator.h"
+
+// retrieves the larger of two sizes
+constexpr size_t ScheduleGenerator_MaxSize(size_t a, size_t b)
+{
+    return (a > b) ? a : b;
+}
+
+// size of inline storage for schedule generator; fits all the standard generators, larger generators are allocated on heap
+constexpr size_t ScheduleGenerator_InlineSize = ScheduleGenerator_MaxSize(
+    ScheduleGenerator_MaxSize(sizeof(constant_generator<simtime_t>), sizeof(uniform_int_generator<simtime_t>)),
+    ScheduleGenerator_MaxSize(sizeof(exponential_generator<simtime_t>), sizeof(gaussian_generator<simtime_t>)));
+
+/*
+ * Kind of stored schedule generator
+ */
+enum class ScheduleGeneratorKind : uint8_t
+{
+    NONE,           // no generator stored
+    CONSTANT,       // constant_generator<simtime_t>
+    UNIFORM_INT,    // uniform_int_generator<simtime_t>
+    EXPONENTIAL,    // exponential_generator<simtime_t>
+    GAUSSIAN,       // gaussian_generator<simtime_t>
+    CUSTOM          // any other generator, called through function table
+};
+
+/*
+ * Table of operations of stored generator type
+ */
+struct ScheduleGeneratorOps
+{
+    // draws next number from generator
+    simtime_t (*next)(void* generator);
+    // destroys generator (and releases its memory, if allocated on heap)
+    void (*destroy)(void* generator);
+    // seeds generator engine
+    void (*seed)(void* generator, uint64_t key, uint64_t stream);
+};
+
+/*
+ * Holder of periodic schedule generator
+ *
+ * The generator is stored inline (if it fits), so setting up a periodic schedule does not allocate. Standard generators
+ * are recognized at compile time and called directly (the call may be inlined), other generators are called through
+ * function table specialized for their type
+ */
+class ScheduleGenerator
+{
+    public:
+        ScheduleGenerator();
+        ~ScheduleGenerator();
+
+        ScheduleGenerator(ScheduleGenerator const&) = delete;
+        ScheduleGenerator& operator=(ScheduleGenerator const&) = delete;
+
+        // constructs generator of given type in place of the current one
+        template<typename T, typename ...Args>
+        void Emplace(Args&&... args)
+        {
+            Reset();
+
+            // generators not fitting to inline storage are allocated on heap
+            Construct<T>(std::integral_constant<bool, (sizeof(T) > ScheduleGenerator_InlineSize || alignof(T) > alignof(std::max_align_t))>(), std::forward<Args>(args)...);
+            m_kind = KindOf<T>();
+        }
+
+        // destroys stored generator
+        void Reset();
+        // seeds engine of stored generator with given key and stream; does nothing, if there's no generator stored
+        void Seed(uint64_t key, uint64_t stream);
+        // writes kind and state of stored generator to sink; returns false for custom generators, which could not be
+        // recreated from their state
+        bool Save(random_state_sink& sink) const;
+        // recreates generator written by Save; returns false, if the state could not be read
+        bool Load(random_state_source& source);
+
+        // is there a generator stored?
+        bool IsSet() const
+        {
+            return m_kind != ScheduleGeneratorKind::NONE;
+        }
+
+        // retrieves kind of stored generator
+        ScheduleGeneratorKind GetKind() const
+        {
+            return m_kind;
+        }
+
+        // draws next number from stored generator; the generator must be set
+        simtime_t operator()()
+        {
+            // qualified calls do not go through virtual table
+            switch (m_kind)
+            {
+                case ScheduleGeneratorKind::CONSTANT:
+                    return static_cast<constant_generator<simtime_t>*>(m_generator)->constant_generator<simtime_t>::operator()();
+                case ScheduleGeneratorKind::UNIFORM_INT:
+                    return static_cast<uniform_int_generator<simtime_t>*>(m_generator)->uniform_int_generator<simtime_t>::operator()();
+                case ScheduleGeneratorKind::EXPONENTIAL:
+                    return static_cast<exponential_generator<simtime_t>*>(m_generator)->exponential_generator<simtime_t>::operator()();
+                case ScheduleGeneratorKind::GAUSSIAN:
+                    return static_cast<gaussian_generator<simtime_t>*>(m_generator)->gaussian_generator<simtime_t>::operator()();
+                default:
+                    return m_ops->next(m_generator);
+            }
+        }
+
+    protected:
+        // constructs generator in inline storage
+        template<typename T, typename ...Args>
+        void Construct(std::false_type, Args&&... args)
+        {
+            m_generator = new (m_storage) T(std::forward<Args>(args)...);
+            m_ops = &OpsOf<T, false>::table;
+        }
+
+        // constructs generator on heap
+        template<typename T, typename ...Args>
+        void Construct(std::true_type, Args&&... args)
+        {
+            m_generator = new T(std::forward<Args>(args)...);
+            m_ops = &OpsOf<T, true>::table;
+        }
+
+        // retrieves kind of generator type
+        template<typename T>
+        static constexpr ScheduleGeneratorKind KindOf()
+        {
+            return std::is_same<T, constant_generator<simtime_t>>::value ? ScheduleGeneratorKind::CONSTANT
+                : std::is_same<T, uniform_int_generator<simtime_t>>::value ? ScheduleGeneratorKind::UNIFORM_INT
+                : std::is_same<T, exponential_generator<simtime_t>>::value ? ScheduleGeneratorKind::EXPONENTIAL
+                : std::is_same<T, gaussian_generator<simtime_t>>::value ? ScheduleGeneratorKind::GAUSSIAN
+                : ScheduleGeneratorKind::CUSTOM;
+        }
+
+        /*
+         * Function table of generator type
+         */
+        template<typename T, bool Heap>
+        struct OpsOf
+        {
+            static simtime_t Next(void* generator)
+            {
+                return static_cast<T*>(generator)->T::operator()();
+            }
+
+            static void Seed(void* generator, uint64_t key, uint64_t stream)
+            {
+                static_cast<T*>(generator)->seed(key, stream);
+            }
+
+            static void Destroy(void* generator)
+            {
+                if (Heap)
+                    delete static_cast<T*>(generator);
+                else
+                    static_cast<T*>(generator)->~T();
+            }
+
+            static const ScheduleGeneratorOps table;
+        };
+
+    private:
+        // inline storage of generator
+        alignas(std::max_align_t) unsigned char m_storage[ScheduleGenerator_InlineSize];
+        // stored generator (points to inline storage or to heap)
+        void* m_generator;
+        // function table of stored generator
+        const ScheduleGeneratorOps* m_ops;
+        // kind of stored generator
+        ScheduleGeneratorKind m_kind;
+};
+
+template<typename T, bool Heap>
+const ScheduleGeneratorOps ScheduleGenerator::OpsOf<T, Heap>::table = {
+    &ScheduleGenerator::OpsOf<T, Heap>::Next, &ScheduleGenerator::OpsOf<T, Heap>::Destroy, &ScheduleGenerator::OpsOf<T, Heap>::Seed
+};
@@ -5,14 +5,31 @@
  ************************************************************/
 
 #include <iostream>
+#include <algorithm>
+#include <cstdio>
 #include "Simulation.h"
+#include "Process.h"
 
 std::random_device Simulation::m_randDev;
+std::mutex Simulation::m_randDevMutex;
+
+// operations deferred by object dispatched in parallel by this thread (nullptr if not dispatching in parallel)
+static thread_local std::vector<DeferredOperation>* _deferredOperations = nullptr;
+// is this thread receiving message speculatively (optimistic logical process)?
+static thread_local bool _receivingSpeculatively = false;
+
+// number of chunks of parallel phase per dispatch thread; more chunks balance the load better
+static const size_t _phaseChunksPerThread = 4;
+// minimum number of work items per range of parallel fan-out; smaller fan-outs are not worth the synchronization
+static const size_t _fanOutMinRangeSize = 256;
 
 Simulation::Simulation(std::ostream& logOutput)
-    : m_guidNext(1), m_logger(logOutput), m_simMode(SimulationMode::CONTINUOUS), m_simulationTime(0)
+    : m_dispatching(false), m_logger(logOutput), m_simulationTime(0), m_simMode(SimulationMode::CONTINUOUS),
+      m_dispatchMode(SimulationDispatchMode::SINGLE), m_dispatchThreads(0), m_exitCode(SimulationExitCode_OK), m_running(false), m_terminated(false), m_step(0),
+      m_messageRouter(nullptr), m_lpIndex(0), m_messageSequence(0), m_optimistic(false), m_speculative(false),
+      m_terminateTime(0), m_rollbackCount(0), m_rolledBackMessages(0), m_statistics(this), m_replication(0)
 {
-    //
+    m_masterSeed = (static_cast<uint64_t>(GetTrueRandomNumber()) << 32) | GetTrueRandomNumber();
 }
 
 Simulation::~Simulation()
@@ -37,21 +54,114 @@ SimulationMode Simulation::GetSimulationMode() const
     return m_simMode;
 }
 
+void Simulation::SetDispatchMode(SimulationDispatchMode mode)
+{
+    m_dispatchMode = mode;
+}
+
+SimulationDispatchMode Simulation::GetDispatchMode() const
+{
+    return m_dispatchMode;
+}
+
+void Simulation::SetDispatchThreadCount(size_t threadCount)
+{
+    m_dispatchThreads = threadCount;
+    m_dispatchPool.reset();
+}
+
+size_t Simulation::GetDispatchThreadCount() const
+{
+    return m_dispatchPool ? m_dispatchPool->GetThreadCount() : m_dispatchThreads;
+}
+
+bool Simulation::IsDeferring()
+{
+    return (_deferredOperations != nullptr);
+}
+
+bool Simulation::IsReceivingSpeculatively()
+{
+    return _receivingSpeculatively;
+}
+
+DeferredOperation& Simulation::Defer(DeferredOperationKind kind, SimulationObjectPtr const& object)
+{
+    _deferredOperations->emplace_back();
+
+    DeferredOperation& op = _deferredOperations->back();
+    op.kind = kind;
+    op.object = object;
+    if (object)
+    {
+        op.previousCalendar = object->m_currCalendar;
+        op.previousTime = object->m_simTimeNext;
+    }
+
+    return op;
+}
+
 Logger& Simulation::GetLogger()
 {
     return m_logger;
 }
 
+StatisticRegistry& Simulation::GetStatistics()
+{
+    return m_statistics;
+}
+
+StatisticRegistry const& Simulation::GetStatistics() const
+{
+    return m_statistics;
+}
+
+void Simulation::SetTraceWriter(TraceWriterPtr writer)
+{
+    m_traceWriter = writer;
+}
+
+TraceWriterPtr Simulation::GetTraceWriter() const
+{
+    return m_traceWriter;
+}
+
 unsigned int Simulation::GetTrueRandomNumber()
 {
+    std::lock_guard<std::mutex> lock(m_randDevMutex);
     return m_randDev();
 }
 
+void Simulation::SetMasterSeed(uint64_t seed)
+{
+    m_masterSeed = seed;
+}
+
+uint64_t Simulation::GetMasterSeed() const
+{
+    return m_masterSeed;
+}
+
+void Simulation::SetReplication(uint64_t replication)
+{
+    m_replication = replication;
+}
+
+uint64_t Simulation::GetReplication() const
+{
+    return m_replication;
+}
+
+uint64_t Simulation::GetRandomStreamKey(uint32_t streamId) const
+{
+    return random_stream_key(m_masterSeed, m_replication, streamId, m_lpIndex);
+}
+
 void Simulation::Setup(CalendarPtr mainCalendar)
 {
     m_calendarList.push_back(mainCalendar);
 
-    m_logger(GetSimulationTime()) << "Setting up simulation";
+    SIMLIB_LOG(m_logger, LogLevel::INFO, LogCategory_Simulation)(GetSimulationTime()) << "Setting up simulation";
 }
 
 void Simulation::AddCalendar(CalendarPtr nextCalendar)
@@ -64,7 +174,7 @@ CalendarPtr Simulation::GetMainCalendar() const
     if (m_calendarList.empty())
         return nullptr;
 
-    return *(m_calendarList.begin());
+    return m_calendarList.front();
 }
 
 simtime_t Simulation::GetSimulationTime() const
@@ -77,16 +187,38 @@ bool Simulation::IsRunning() const
     return m_running;
 }
 
+bool Simulation::IsTerminated() const
+{
+    return m_terminated;
+}
+
+int64_t Simulation::GetExitCode() const
+{
+    return m_exitCode;
+}
+
 void Simulation::Terminate(int64_t exitCode, SimulationObjectPtr initiator)
 {
     if (!IsRunning())
         return;
 
+    // dispatched in parallel - the termination takes effect after the parallel phase
+    if (IsDeferring())
+    {
+        Defer(DeferredOperationKind::TERMINATE_SIMULATION, initiator).exitCode = exitCode;
+        return;
+    }
+
     m_running = false;
+    m_terminated = true;
     m_exitCode = exitCode;
     m_exitInitiator = initiator;
+    m_terminateTime = m_simulationTime;
+
+    SIMLIB_LOG(m_logger, LogLevel::INFO, LogCategory_Simulation)(GetSimulationTime()) << "Simulation termination requested with code " << m_exitCode;
 
-    m_logger(GetSimulationTime()) << "Simulation termination requested with code " << m_exitCode;
+    // write everything logged so far, so the output is complete even if the application exits right away
+    FlushOutput();
 }
 
 SimulationObjectPtr Simulation::GetTerminateInitiator() const
@@ -96,129 +228,1100 @@ SimulationObjectPtr Simulation::GetTerminateInitiator() const
 
 int64_t Simulation::Run()
 {
-    // step counter
-    size_t step = 0;
-
     // by default, assume that everything's ok
     m_exitCode = SimulationExitCode_OK;
+    m_terminated = false;
+    m_step = 0;
+
+    return RunUntil(SimulationTime_Never);
+}
+
+int64_t Simulation::RunUntil(simtime_t endTime)
+{
+    if (m_terminated)
+        return m_exitCode;
+
+    m_running = true;
+
+    while (m_running && DispatchNext(endTime))
+        ;
+
+    m_running = false;
+    ReleaseDispatchedObjects();
+
+    // logical process runs once per window, its output is flushed at the end of the parallel run
+    if (!m_messageRouter)
+        FlushOutput();
+
+    return m_exitCode;
+}
+
+bool Simulation::Step()
+{
+    if (m_terminated)
+        return false;
 
     m_running = true;
+    const bool dispatched = DispatchNext(SimulationTime_Never);
+    m_running = false;
+
+    return dispatched;
+}
+
+simtime_t Simulation::GetNextEventTime() const
+{
+    simtime_t next = m_inbox.empty() ? SimulationTime_Never : m_inbox.front().time;
+
+    CalendarPtr cal = m_calendarList.top_calendar();
+    if (cal && cal->top_entry().time < next)
+        next = cal->top_entry().time;
 
-    while (!m_calendarList.all_empty() && m_running)
+    return next;
+}
+
+bool Simulation::DispatchNext(simtime_t endTime)
+{
+    const simtime_t next = GetNextEventTime();
+    if (next == SimulationTime_Never || next >= endTime)
+        return false;
+
+    m_step++;
+
+    // if stepped simulation mode is selected, wait for key press every step
+    if (m_simMode == SimulationMode::STEPPED)
     {
-        step++;
+        SIMLIB_LOG(m_logger, LogLevel::INFO, LogCategory_Simulation)(GetSimulationTime()) << "Step: " << m_step;
+        m_logger.Flush();
+        std::cin.get();
+    }
 
-        // if stepped simulation mode is selected, wait for key press every step
-        if (m_simMode == SimulationMode::STEPPED)
-        {
-            m_logger(GetSimulationTime()) << "Step: " << step;
-            std::cin.get();
-        }
+    // messages are received before objects scheduled to the same time
+    if (!m_inbox.empty() && m_inbox.front().time == next)
+        DispatchMessage();
+    else
+        DispatchObjects();
 
-        // retrieve head of calendar queues (all of calendars)
-        auto obj = m_calendarList.top();
-        m_calendarList.pop();
+    return true;
+}
+
+void Simulation::DispatchObjects()
+{
+    if (m_dispatchMode != SimulationDispatchMode::SINGLE)
+        DispatchBatch();
+    else
+    {
+        // retrieve head of calendar queues (all of calendars) and remove it
+        auto obj = m_calendarList.pop_top();
 
         // set current simulation time
         m_simulationTime = obj->GetNextSimTime();
 
-        m_logger(GetSimulationTime()) << "Object " << obj->GetGUID() << " (type: " << static_cast<int>(obj->GetType()) << ", class: " << obj->GetObjectClass() << ") fired";
+        DispatchObject(obj);
+    }
+}
+
+void Simulation::DispatchMessage(bool speculative)
+{
+    std::pop_heap(m_inbox.begin(), m_inbox.end(), SimulationMessageCmp());
+    SimulationMessage message = m_inbox.back();
+    m_inbox.pop_back();
+
+    m_simulationTime = message.time;
+
+    ProcessedMessage* processed = nullptr;
+    if (speculative)
+    {
+        m_processed.emplace_back();
+        processed = &m_processed.back();
+        processed->message = message;
+        processed->stateSaving = StateSavingMode::NONE;
+        processed->sentCount = 0;
+
+        if (!m_freeSnapshots.empty())
+        {
+            processed->snapshot = std::move(m_freeSnapshots.back());
+            m_freeSnapshots.pop_back();
+        }
+    }
+
+    // the target may be gone meanwhile
+    SimulationObjectPtr const& target = m_objects.GetByGUID(message.targetGUID);
+    if (!target)
+        return;
+
+    // keep the target alive, even if it terminates itself
+    SimulationObjectPtr obj = target;
+
+    if (processed && obj->GetType() == SimulationObjectType::PROCESS)
+    {
+        SimProcess* process = static_cast<SimProcess*>(obj.get());
+        processed->stateSaving = process->GetStateSavingMode();
+        if (processed->stateSaving == StateSavingMode::COPY)
+            process->SaveState(processed->snapshot);
+    }
+
+    m_dispatching = true;
+    m_speculative = speculative;
+    _receivingSpeculatively = speculative;
+    obj->ReceiveMessage(message);
+    _receivingSpeculatively = false;
+    m_speculative = false;
+    m_dispatching = false;
+
+    ReleaseDispatchedObjects();
+}
+
+void Simulation::PushMessage(SimulationMessage const& message)
+{
+    m_inbox.push_back(message);
+    std::push_heap(m_inbox.begin(), m_inbox.end(), SimulationMessageCmp());
+}
+
+void Simulation::DropCancelledMessages()
+{
+    while (!m_cancelled.empty() && !m_inbox.empty())
+    {
+        auto itr = m_cancelled.find(std::make_pair(m_inbox.front().sourceLP, m_inbox.front().sequence));
+        if (itr == m_cancelled.end())
+            break;
+
+        m_cancelled.erase(itr);
+        std::pop_heap(m_inbox.begin(), m_inbox.end(), SimulationMessageCmp());
+        m_inbox.pop_back();
+    }
+}
+
+bool Simulation::CanRollback(SimulationMessage const& message) const
+{
+    SimulationObjectPtr const& target = m_objects.GetByGUID(message.targetGUID);
+
+    // message for object, that is gone, has no effect
+    if (!target)
+        return true;
+
+    if (target->GetType() != SimulationObjectType::PROCESS)
+        return false;
+
+    return static_cast<SimProcess*>(target.get())->GetStateSavingMode() != StateSavingMode::NONE;
+}
+
+bool Simulation::SendMessage(uint32_t targetLP, uint64_t targetGUID, simtime_t delay, uint32_t kind, SimulationMessageData const& data)
+{
+    // dispatched in parallel - the message is sent after the parallel phase, so the sequence numbers follow
+    // the order of dispatch; the message is validated right away, so the result is the same as in sequential dispatch
+    if (IsDeferring())
+    {
+        if (targetLP != m_lpIndex && (!m_messageRouter || !m_messageRouter->CheckRoute(targetLP, delay)))
+            return false;
+
+        DeferredOperation& op = Defer(DeferredOperationKind::SEND_MESSAGE, nullptr);
+        op.time = delay;
+        op.message.targetLP = targetLP;
+        op.message.targetGUID = targetGUID;
+        op.message.kind = kind;
+        op.message.data = data;
+        return true;
+    }
+
+    SimulationMessage message;
+    message.time = m_simulationTime + delay;
+    message.sendTime = m_simulationTime;
+    message.targetGUID = targetGUID;
+    message.sequence = m_messageSequence++;
+    message.sourceLP = m_lpIndex;
+    message.targetLP = targetLP;
+    message.kind = kind;
+    message.flags = 0;
+    message.data = data;
+
+    if (targetLP == m_lpIndex)
+        PushMessage(message);
+    else if (!m_messageRouter || !m_messageRouter->RouteMessage(message))
+        return false;
+
+    // the send is undone by anti-message, when the receive of current message is rolled back
+    if (m_speculative)
+    {
+        m_sentMessages.push_back(message);
+        m_processed.back().sentCount++;
+    }
+
+    return true;
+}
 
-        // run scope
+void Simulation::DeliverMessage(SimulationMessage const& message)
+{
+    if (m_optimistic)
+    {
+        // straggler (or anti-message of already received message) - roll back everything received since its time
+        if (!m_processed.empty() && m_processed.back().message.time >= message.time)
+            Rollback(message.time);
+
+        // the cancelled message is in inbox now; it is dropped when it gets to the top
+        if (message.flags & SimulationMessageFlag_Anti)
         {
-            CalendarPtr cal = obj->GetCurrentCalendar();
+            m_cancelled.insert(std::make_pair(message.sourceLP, message.sequence));
+            return;
+        }
+    }
+
+    PushMessage(message);
+}
+
+uint32_t Simulation::GetLogicalProcessIndex() const
+{
+    return m_lpIndex;
+}
+
+void Simulation::SetLogicalProcess(uint32_t index, MessageRouter* router)
+{
+    m_lpIndex = index;
+    m_messageRouter = router;
+}
+
+void Simulation::SetOptimistic(bool optimistic)
+{
+    m_optimistic = optimistic;
+}
+
+uint64_t Simulation::GetRollbackCount() const
+{
+    return m_rollbackCount;
+}
+
+uint64_t Simulation::GetRolledBackMessageCount() const
+{
+    return m_rolledBackMessages;
+}
+
+simtime_t Simulation::GetTerminateTime() const
+{
+    return m_terminateTime;
+}
+
+size_t Simulation::RunOptimistic(simtime_t safeTime, simtime_t horizon, size_t maxCount)
+{
+    if (m_terminated)
+        return 0;
+
+    m_running = true;
 
-            // at first, clear schedule info from object, so the object is no longer considered "scheduled"
-            obj->ClearScheduleInfo();
-            // fire Run method
-            obj->Run();
+    size_t count = 0;
+    for (; m_running && count < maxCount; count++)
+    {
+        DropCancelledMessages();
+
+        const simtime_t messageTime = m_inbox.empty() ? SimulationTime_Never : m_inbox.front().time;
+        CalendarPtr cal = m_calendarList.top_calendar();
+        const simtime_t objectTime = cal ? cal->top_entry().time : SimulationTime_Never;
+
+        // messages are received before objects scheduled to the same time
+        if (messageTime != SimulationTime_Never && messageTime <= objectTime)
+        {
+            if (messageTime >= horizon)
+                break;
 
-            // if the object have periodic schedule plan, perform planning
-            if (obj->HasPeriodicSchedule())
-                obj->NextPeriodicSchedule(cal);
+            if (messageTime < safeTime)
+                DispatchMessage(false);
+            // the receive could be rolled back only if the target is able to restore its state
+            else if (CanRollback(m_inbox.front()))
+                DispatchMessage(true);
+            else
+                break;
         }
+        // objects could not be rolled back, so they are dispatched only before safe time
+        else if (objectTime < safeTime)
+            DispatchObjects();
+        else
+            break;
     }
 
     m_running = false;
+    ReleaseDispatchedObjects();
 
-    return m_exitCode;
+    return count;
 }
 
-uint64_t Simulation::AddObject(SimulationObjectPtr object)
+void Simulation::Rollback(simtime_t time)
 {
-    // assign GUID
-    object->SetGUID(m_guidNext);
+    if (m_processed.empty() || m_processed.back().message.time < time)
+        return;
+
+    m_rollbackCount++;
+
+    // undo in reverse order of receive
+    while (!m_processed.empty() && m_processed.back().message.time >= time)
+    {
+        ProcessedMessage& processed = m_processed.back();
+
+        SimulationObjectPtr const& target = m_objects.GetByGUID(processed.message.targetGUID);
+        if (target && target->GetType() == SimulationObjectType::PROCESS)
+        {
+            SimProcess* process = static_cast<SimProcess*>(target.get());
+            if (processed.stateSaving == StateSavingMode::COPY)
+                process->RestoreState(processed.snapshot);
+            else if (processed.stateSaving == StateSavingMode::REVERSE)
+                process->ReverseMessage(processed.message);
+        }
+
+        for (size_t i = 0; i < processed.sentCount; i++)
+        {
+            SimulationMessage& sent = m_sentMessages.back();
+
+            // local messages are still in inbox (their receive was already rolled back), so they are just cancelled
+            if (sent.targetLP == m_lpIndex)
+                m_cancelled.insert(std::make_pair(sent.sourceLP, sent.sequence));
+            else if (m_messageRouter)
+            {
+                sent.flags |= SimulationMessageFlag_Anti;
+                m_messageRouter->RouteMessage(sent);
+            }
 
-    // add object to all maps; from this point, the GUID, type and class are fixed and should not be changed!
-    m_objectGuidMap[m_guidNext] = object;
-    m_objectTypeMap[object->GetType()].push_back(object);
-    m_objectClassMap[object->GetObjectClass()].push_back(object);
+            m_sentMessages.pop_back();
+        }
 
-    m_logger(GetSimulationTime()) << "Adding object (GUID: " << m_guidNext << ", type: " << static_cast<int>(object->GetType()) << ", class: " << object->GetObjectClass() << ")";
+        PushMessage(processed.message);
+        m_freeSnapshots.push_back(std::move(processed.snapshot));
+        m_processed.pop_back();
+        m_rolledBackMessages++;
+    }
 
-    return m_guidNext++;
+    // termination requested by rolled back message did not happen
+    if (m_terminated && m_terminateTime >= time)
+    {
+        m_terminated = false;
+        m_exitCode = SimulationExitCode_OK;
+        m_exitInitiator = nullptr;
+    }
 }
 
-void Simulation::RemoveObjectFromList(SimulationObjectList& simList, SimulationObjectPtr object)
+void Simulation::CollectFossils(simtime_t time)
 {
-    for (auto itr = simList.begin(); itr != simList.end(); )
+    while (!m_processed.empty() && m_processed.front().message.time < time)
     {
-        if ((*itr)->GetGUID() == object->GetGUID())
-            itr = simList.erase(itr);
+        ProcessedMessage& processed = m_processed.front();
+
+        m_sentMessages.erase(m_sentMessages.begin(), m_sentMessages.begin() + processed.sentCount);
+        m_freeSnapshots.push_back(std::move(processed.snapshot));
+        m_processed.pop_front();
+    }
+}
+
+void Simulation::DispatchObject(SimulationObjectPtr const& obj)
+{
+    CalendarPtr cal = PrepareDispatch(obj.get());
+
+    m_dispatching = true;
+    FireObject(obj.get(), cal);
+    m_dispatching = false;
+
+    // nothing refers to removed objects anymore
+    ReleaseDispatchedObjects();
+}
+
+CalendarPtr Simulation::PrepareDispatch(SimulationObject* obj)
+{
+    if (SIMLIB_LOG_ENABLED(m_logger, LogLevel::TRACE, LogCategory_Dispatch))
+        m_logger.LogObject(LogRecordKind::OBJECT_FIRED, GetSimulationTime(), obj->GetGUID(), static_cast<uint32_t>(obj->GetType()), obj->GetObjectClass());
+    if (m_traceWriter)
+        m_traceWriter->Record(TraceEventKind::FIRED, GetSimulationTime(), obj->GetGUID(), static_cast<uint32_t>(obj->GetType()), obj->GetObjectClass());
+
+    CalendarPtr cal = obj->GetCurrentCalendar();
+
+    // clear schedule info from object, so the object is no longer considered "scheduled"
+    obj->ClearScheduleInfo();
+
+    return cal;
+}
+
+void Simulation::FireObject(SimulationObject* obj, CalendarPtr const& cal)
+{
+    obj->Run();
+
+    // if the object have periodic schedule plan, perform planning
+    if (obj->HasPeriodicSchedule())
+        obj->NextPeriodicSchedule(cal);
+}
+
+void Simulation::ReleaseDispatchedObjects()
+{
+    m_releasedObjects.clear();
+
+    for (auto& obj : m_recycledPending)
+        m_recycledObjects[obj->m_recycleTypeId].push_back(std::move(obj));
+    m_recycledPending.clear();
+}
+
+void Simulation::FlushOutput()
+{
+    m_logger.Flush();
+    if (m_traceWriter)
+        m_traceWriter->Flush();
+}
+
+void Simulation::DispatchBatch()
+{
+    // the batch is in FIFO order, stable sort keeps it within the groups
+    m_simulationTime = m_calendarList.pop_batch(m_batch);
+    std::stable_sort(m_batch.begin(), m_batch.end(), [](SimulationObjectPtr const& a, SimulationObjectPtr const& b) {
+        return a->GetObjectClass() < b->GetObjectClass();
+    });
+
+    OnTimeStep(m_batch);
+
+    const bool parallel = (m_dispatchMode == SimulationDispatchMode::PARALLEL_BATCH);
+
+    for (auto& obj : m_batch)
+    {
+        // objects with known footprint are collected to parallel phase; the phase is dispatched, when the next object
+        // conflicts with it, so the result is the same as if the objects were dispatched one by one
+        bool known = false;
+        if (parallel)
+        {
+            m_footprint.Clear();
+            known = obj->GetFootprint(m_footprint);
+            m_footprint.Write(obj->GetGUID());
+
+            if (!known || ConflictsWithPhase(m_footprint))
+                DispatchPhase();
+        }
+
+        // objects rescheduled, cancelled or terminated by preceding objects of batch are no longer "taken" from calendar
+        if (!obj->m_currCalendar || obj->m_calendarHandle != CalendarHandle_Invalid)
+            continue;
+
+        // return the rest to calendars, when the simulation was terminated
+        if (!m_running)
+        {
+            obj->Schedule(obj->m_currCalendar, m_simulationTime);
+            continue;
+        }
+
+        if (known)
+            AddToPhase(obj.get(), m_footprint);
         else
-            ++itr;
+            DispatchObject(obj);
+    }
+
+    DispatchPhase();
+
+    m_batch.clear();
+}
+
+bool Simulation::ConflictsWithPhase(ObjectFootprint const& footprint) const
+{
+    // written objects must not be touched by anyone else in the phase, read objects must not be written
+    for (uint64_t guid : footprint.GetWrites())
+    {
+        if (m_phaseWrites.count(guid) || m_phaseReads.count(guid))
+            return true;
+    }
+    for (uint64_t guid : footprint.GetReads())
+    {
+        if (m_phaseWrites.count(guid))
+            return true;
+    }
+
+    return false;
+}
+
+void Simulation::AddToPhase(SimulationObject* obj, ObjectFootprint const& footprint)
+{
+    m_phaseWrites.insert(footprint.GetWrites().begin(), footprint.GetWrites().end());
+    m_phaseReads.insert(footprint.GetReads().begin(), footprint.GetReads().end());
+    m_phase.push_back(obj);
+}
+
+void Simulation::DispatchPhase()
+{
+    if (m_phase.empty())
+        return;
+
+    m_phaseWrites.clear();
+    m_phaseReads.clear();
+
+    // single object does not need any threads
+    if (m_phase.size() == 1)
+    {
+        SimulationObject* obj = m_phase.front();
+        m_phase.clear();
+
+        DispatchObject(obj->shared_from_this());
+        return;
+    }
+
+    for (SimulationObject* obj : m_phase)
+        m_phaseCalendars.push_back(PrepareDispatch(obj));
+
+    const size_t count = m_phase.size();
+
+    m_dispatching = true;
+    RunDeferred(count, std::min(count, GetDispatchPool().GetThreadCount() * _phaseChunksPerThread), [this](size_t first, size_t last) {
+        for (size_t i = first; i < last; i++)
+            FireObject(m_phase[i], m_phaseCalendars[i]);
+    });
+    m_dispatching = false;
+
+    m_phase.clear();
+    m_phaseCalendars.clear();
+
+    ReleaseDispatchedObjects();
+}
+
+ThreadPool& Simulation::GetDispatchPool()
+{
+    if (!m_dispatchPool)
+        m_dispatchPool.reset(new ThreadPool(m_dispatchThreads));
+
+    return *m_dispatchPool;
+}
+
+void Simulation::RunDeferred(size_t count, size_t rangeCount, SimulationFanOutRange const& range)
+{
+    ThreadPool& pool = GetDispatchPool();
+
+    // every range defers its operations to its own list, so the lists concatenated in range order are in order
+    // of work items
+    if (m_deferredOperations.size() < rangeCount)
+        m_deferredOperations.resize(rangeCount);
+
+    for (size_t r = 0; r < rangeCount; r++)
+    {
+        const size_t first = r * count / rangeCount;
+        const size_t last = (r + 1) * count / rangeCount;
+
+        pool.Submit([this, &range, r, first, last]() {
+            _deferredOperations = &m_deferredOperations[r];
+            range(first, last);
+            _deferredOperations = nullptr;
+        });
+    }
+    pool.Wait();
+
+    for (size_t r = 0; r < rangeCount; r++)
+    {
+        for (auto& op : m_deferredOperations[r])
+            ApplyDeferredOperation(op);
+        m_deferredOperations[r].clear();
+    }
+}
+
+void Simulation::FanOut(size_t count, SimulationFanOutRange const& range)
+{
+    // nested fan-out would wait for the pool it runs on, so it runs on calling thread as well as small fan-outs
+    const size_t rangeCount = IsDeferring() ? 1 : std::min(count / _fanOutMinRangeSize, GetDispatchPool().GetThreadCount() * _phaseChunksPerThread);
+    if (rangeCount < 2)
+    {
+        range(0, count);
+        return;
+    }
+
+    RunDeferred(count, rangeCount, range);
+}
+
+void Simulation::ApplyDeferredOperation(DeferredOperation& op)
+{
+    SimulationObject* obj = op.object.get();
+
+    // the operation is applied to the schedule the object had, when it requested the operation
+    if (obj && op.kind != DeferredOperationKind::TERMINATE_SIMULATION)
+    {
+        obj->m_currCalendar = std::move(op.previousCalendar);
+        obj->m_simTimeNext = op.previousTime;
+    }
+
+    switch (op.kind)
+    {
+        case DeferredOperationKind::SCHEDULE:
+            obj->Schedule(op.calendar, op.time);
+            break;
+        case DeferredOperationKind::UNSCHEDULE:
+            obj->Unschedule();
+            break;
+        case DeferredOperationKind::TERMINATE_OBJECT:
+            obj->Terminate();
+            break;
+        case DeferredOperationKind::RECYCLE_OBJECT:
+            obj->Recycle();
+            break;
+        case DeferredOperationKind::TERMINATE_SIMULATION:
+            Terminate(op.exitCode, op.object);
+            break;
+        case DeferredOperationKind::SEND_MESSAGE:
+            SendMessage(op.message.targetLP, op.message.targetGUID, op.time, op.message.kind, op.message.data);
+            break;
     }
 }
 
+void Simulation::OnTimeStep(SimulationBatch const& batch)
+{
+    //
+}
+
+uint64_t Simulation::AddObject(SimulationObjectPtr object)
+{
+    // registry is not thread-safe, and the object would not be removed by rollback
+    assert(!IsDeferring() && !IsReceivingSpeculatively());
+
+    // assign GUID and add object to registry
+    uint64_t guid = m_objects.Add(object);
+
+    // the streams are keyed by GUID, so they could be seeded only now
+    object->SeedRandomStreams(*this);
+
+    if (SIMLIB_LOG_ENABLED(m_logger, LogLevel::VERBOSE, LogCategory_Objects))
+        m_logger.LogObject(LogRecordKind::OBJECT_ADDED, GetSimulationTime(), guid, static_cast<uint32_t>(object->GetType()), object->GetObjectClass());
+    if (m_traceWriter)
+        m_traceWriter->Record(TraceEventKind::ADDED, GetSimulationTime(), guid, static_cast<uint32_t>(object->GetType()), object->GetObjectClass());
+
+    return guid;
+}
+
 void Simulation::RemoveObject(SimulationObjectPtr object)
 {
-    m_logger(GetSimulationTime()) << "Removing object (GUID: " << object->GetGUID() << ", type: " << static_cast<int>(object->GetType()) << ", class: " << object->GetObjectClass() << ")";
+    if (SIMLIB_LOG_ENABLED(m_logger, LogLevel::VERBOSE, LogCategory_Objects))
+        m_logger.LogObject(LogRecordKind::OBJECT_REMOVED, GetSimulationTime(), object->GetGUID(), static_cast<uint32_t>(object->GetType()), object->GetObjectClass());
+    if (m_traceWriter)
+        m_traceWriter->Record(TraceEventKind::REMOVED, GetSimulationTime(), object->GetGUID(), static_cast<uint32_t>(object->GetType()), object->GetObjectClass());
+
+    if (m_objects.Remove(object.get()))
+        m_releasedObjects.push_back(object);
+}
 
-    if (m_objectGuidMap.find(object->GetGUID()) != m_objectGuidMap.end())
-        m_objectGuidMap.erase(object->GetGUID());
+void Simulation::RecycleObject(SimulationObjectPtr object)
+{
+    // only objects created by pool could be reused, and only when they are not in simulation
+    if (object->m_recycleTypeId == ObjectPool_NoTypeId || m_objects.Contains(object.get()))
+        return;
 
-    auto itr = m_objectTypeMap.find(object->GetType());
-    if (itr != m_objectTypeMap.end())
-        RemoveObjectFromList(itr->second, object);
+    if (m_recycledObjects.size() <= object->m_recycleTypeId)
+        m_recycledObjects.resize(object->m_recycleTypeId + 1);
 
-    auto itr2 = m_objectClassMap.find(object->GetObjectClass());
-    if (itr2 != m_objectClassMap.end())
-        RemoveObjectFromList(itr2->second, object);
+    if (m_dispatching)
+        m_recycledPending.push_back(std::move(object));
+    else
+        m_recycledObjects[object->m_recycleTypeId].push_back(std::move(object));
 }
 
-SimulationObjectPtr Simulation::GetObjectByGUID(uint64_t guid) const
+ObjectPoolPtr const& Simulation::GetObjectPool(size_t typeId)
 {
-    auto itr = m_objectGuidMap.find(guid);
-    if (itr != m_objectGuidMap.end())
-        return itr->second;
+    if (m_objectPools.size() <= typeId)
+        m_objectPools.resize(typeId + 1);
+
+    if (!m_objectPools[typeId])
+        m_objectPools[typeId] = std::make_shared<ObjectPool>();
 
-    return nullptr;
+    return m_objectPools[typeId];
 }
 
-SimulationObjectList Simulation::GetObjectsByType(SimulationObjectType type) const
+bool Simulation::RegisterCheckpointType(uint32_t checkpointTypeId, std::type_index type, CheckpointObjectFactory factory)
 {
-    auto itr = m_objectTypeMap.find(type);
-    if (itr != m_objectTypeMap.end())
-        return itr->second;
+    return m_checkpointTypes.Register(checkpointTypeId, type, std::move(factory));
+}
+
+bool Simulation::ReadSection(CheckpointReader& reader, CheckpointSection section)
+{
+    if (reader.ReadVarUInt() != static_cast<uint64_t>(section))
+        reader.Fail();
 
-    return SimulationObjectList();
+    return reader.IsGood();
 }
 
-SimulationObjectList Simulation::GetObjectsByClass(uint32_t objectClass) const
+bool Simulation::WriteObject(CheckpointWriter& writer, SimulationObject const& obj) const
 {
-    auto itr = m_objectClassMap.find(objectClass);
-    if (itr != m_objectClassMap.end())
-        return itr->second;
+    uint32_t checkpointTypeId;
+    if (!obj.IsSerializable() || !m_checkpointTypes.GetTypeId(std::type_index(typeid(obj)), checkpointTypeId))
+        return false;
+
+    writer.WriteVarUInt(obj.m_guid);
+    writer.WriteVarUInt(checkpointTypeId);
+    writer.WriteVarUInt(obj.m_objectClass);
 
-    return SimulationObjectList();
+    writer.WriteVarUInt(obj.m_attributes.size());
+    for (auto& attr : obj.m_attributes)
+    {
+        writer.WriteVarUInt(attr.id);
+        writer.WriteVarInt(attr.value);
+    }
+
+    if (!obj.m_scheduleGenerator.Save(writer))
+        return false;
+
+    obj.Serialize(writer);
+    writer.WriteVarUInt(CheckpointObject_EndMarker);
+
+    return true;
 }
 
-SimulationObjectList Simulation::GetAllObjects() const
+SimulationObjectPtr Simulation::ReadObject(CheckpointReader& reader)
 {
-    SimulationObjectList lst;
+    const uint64_t guid = reader.ReadVarUInt();
+    const uint32_t checkpointTypeId = static_cast<uint32_t>(reader.ReadVarUInt());
+    if (!reader.IsGood())
+        return nullptr;
 
-    for (auto& pr : m_objectGuidMap)
-        lst.push_back(pr.second);
+    SimulationObjectPtr obj = m_checkpointTypes.Create(checkpointTypeId, *this);
+    if (!obj)
+        return nullptr;
+
+    obj->SetGUID(guid);
+    obj->SetObjectClass(static_cast<uint32_t>(reader.ReadVarUInt()));
+    obj->SetSimulation(shared_from_this());
+
+    const uint64_t attributeCount = reader.ReadVarUInt();
+    obj->m_attributes.clear();
+    for (uint64_t i = 0; i < attributeCount && reader.IsGood(); i++)
+    {
+        const uint32_t id = static_cast<uint32_t>(reader.ReadVarUInt());
+        obj->m_attributes.push_back({ id, 0, reader.ReadVarInt() });
+    }
+
+    if (!obj->m_scheduleGenerator.Load(reader) || !obj->Deserialize(reader) || reader.ReadVarUInt() != CheckpointObject_EndMarker || !reader.IsGood())
+        return nullptr;
+
+    return obj;
+}
+
+bool Simulation::WriteCalendars(CheckpointWriter& writer) const
+{
+    /*
+     * Scheduled object of any calendar
+     */
+    struct ScheduledEntry
+    {
+        // calendar entry
+        CalendarEntry entry;
+        // index of calendar within calendar list
+        size_t calendar;
+    };
+
+    std::vector<ScheduledEntry> scheduled;
+    std::vector<CalendarEntry> entries;
+
+    size_t calendarIndex = 0;
+    for (auto& cal : m_calendarList)
+    {
+        entries.clear();
+        cal->collect(entries);
+
+        for (auto& entry : entries)
+        {
+            if (!m_objects.Contains(cal->object_of(entry.handle).get()))
+                return false;
+
+            scheduled.push_back({ entry, calendarIndex });
+        }
+
+        calendarIndex++;
+    }
+
+    // the entries are rescheduled in order of dispatch, so they receive new sequence numbers in the same order
+    TimePriorityCmp cmp;
+    std::sort(scheduled.begin(), scheduled.end(), [&cmp](ScheduledEntry const& a, ScheduledEntry const& b) {
+        return cmp(b.entry, a.entry);
+    });
+
+    writer.WriteVarUInt(m_calendarList.size());
+    writer.WriteVarUInt(scheduled.size());
+
+    // the times are increasing, so just the differences are stored
+    simtime_t lastTime = 0;
+    for (auto& item : scheduled)
+    {
+        SimulationObjectPtr const& obj = m_calendarList.begin()[item.calendar]->object_of(item.entry.handle);
+
+        writer.WriteVarUInt(item.calendar);
+        writer.WriteVarUInt(obj->GetGUID());
+        writer.WriteVarUInt(item.entry.time - lastTime);
+
+        lastTime = item.entry.time;
+    }
+
+    return true;
+}
 
-    return lst;
+bool Simulation::ReadCalendars(CheckpointReader& reader)
+{
+    if (reader.ReadVarUInt() != m_calendarList.size())
+        return false;
+
+    const uint64_t count = reader.ReadVarUInt();
+
+    simtime_t time = 0;
+    for (uint64_t i = 0; i < count && reader.IsGood(); i++)
+    {
+        const uint64_t calendarIndex = reader.ReadVarUInt();
+        SimulationObjectPtr obj = m_objects.GetByGUID(reader.ReadVarUInt());
+        time += reader.ReadVarUInt();
+
+        if (calendarIndex >= m_calendarList.size() || !obj || obj->m_currCalendar)
+            return false;
+
+        obj->m_currCalendar = m_calendarList.begin()[calendarIndex];
+        obj->m_simTimeNext = time;
+        obj->m_currCalendar->push(obj);
+    }
+
+    return reader.IsGood();
+}
+
+bool Simulation::WriteCheckpoint(CheckpointWriter& writer)
+{
+    writer.WriteVarUInt(static_cast<uint64_t>(CheckpointSection::SIMULATION));
+    writer.WriteVarUInt(m_simulationTime);
+    writer.WriteVarUInt(m_step);
+    writer.WriteVarUInt(m_masterSeed);
+    writer.WriteVarUInt(m_replication);
+    writer.WriteVarUInt(m_messageSequence);
+    writer.WriteBool(m_terminated);
+    writer.WriteVarInt(m_exitCode);
+
+    // objects are written in order of registry list of all objects, so they are restored in the same order
+    ObjectDenseList const& objects = m_objects.GetAll();
+
+    writer.WriteVarUInt(static_cast<uint64_t>(CheckpointSection::OBJECTS));
+    writer.WriteVarUInt(objects.size());
+    for (auto& obj : objects)
+    {
+        if (!WriteObject(writer, *obj))
+        {
+            SIMLIB_LOG(m_logger, LogLevel::CRITICAL, LogCategory_Simulation)(GetSimulationTime()) << "Object " << obj->GetGUID()
+                << " could not be written to checkpoint (unregistered type, custom periodic schedule generator or state not serializable)";
+            return false;
+        }
+    }
+
+    writer.WriteVarUInt(static_cast<uint64_t>(CheckpointSection::REGISTRY));
+    m_objects.Save(writer);
+
+    writer.WriteVarUInt(static_cast<uint64_t>(CheckpointSection::CALENDARS));
+    if (!WriteCalendars(writer))
+        return false;
+
+    // the inbox is a heap, it is stored as it is
+    writer.WriteVarUInt(static_cast<uint64_t>(CheckpointSection::MESSAGES));
+    writer.WriteVarUInt(m_inbox.size());
+    for (auto& message : m_inbox)
+        writer.WriteMessage(message);
+
+    writer.WriteVarUInt(static_cast<uint64_t>(CheckpointSection::STATISTICS));
+    m_statistics.Save(writer);
+
+    writer.WriteVarUInt(static_cast<uint64_t>(CheckpointSection::END));
+
+    return writer.IsGood();
+}
+
+bool Simulation::IsStateCapturable() const
+{
+    // objects of batch are already taken from calendars, while OnTimeStep or their dispatch runs
+    return !m_dispatching && m_batch.empty();
+}
+
+bool Simulation::Checkpoint(std::string const& path)
+{
+    // objects being dispatched and speculative state of logical processes could not be captured
+    if (!IsStateCapturable() || m_messageRouter)
+        return false;
+
+    CheckpointWriter writer;
+    if (!writer.Open(path))
+        return false;
+
+    const bool written = WriteCheckpoint(writer);
+    if (!writer.Close() || !written)
+    {
+        std::remove(path.c_str());
+        return false;
+    }
+
+    SIMLIB_LOG(m_logger, LogLevel::INFO, LogCategory_Simulation)(GetSimulationTime()) << "Checkpoint written to " << path;
+
+    return true;
+}
+
+bool Simulation::ReadCheckpoint(CheckpointReader& reader)
+{
+    if (!ReadSection(reader, CheckpointSection::SIMULATION))
+        return false;
+
+    m_simulationTime = reader.ReadVarUInt();
+    m_step = static_cast<size_t>(reader.ReadVarUInt());
+    m_masterSeed = reader.ReadVarUInt();
+    m_replication = reader.ReadVarUInt();
+    m_messageSequence = reader.ReadVarUInt();
+    m_terminated = reader.ReadBool();
+    m_exitCode = reader.ReadVarInt();
+
+    if (!ReadSection(reader, CheckpointSection::OBJECTS))
+        return false;
+
+    const uint64_t objectCount = reader.ReadVarUInt();
+
+    std::vector<SimulationObjectPtr> objects;
+    for (uint64_t i = 0; i < objectCount && reader.IsGood(); i++)
+    {
+        SimulationObjectPtr obj = ReadObject(reader);
+        if (!obj)
+            return false;
+
+        objects.push_back(std::move(obj));
+    }
+
+    if (!ReadSection(reader, CheckpointSection::REGISTRY) || !m_objects.Restore(reader, objects))
+        return false;
+
+    if (!ReadSection(reader, CheckpointSection::CALENDARS) || !ReadCalendars(reader))
+        return false;
+
+    if (!ReadSection(reader, CheckpointSection::MESSAGES))
+        return false;
+
+    const uint64_t messageCount = reader.ReadVarUInt();
+    m_inbox.clear();
+    for (uint64_t i = 0; i < messageCount && reader.IsGood(); i++)
+    {
+        SimulationMessage message;
+        reader.ReadMessage(message);
+
+        m_inbox.push_back(message);
+    }
+
+    if (!ReadSection(reader, CheckpointSection::STATISTICS) || !m_statistics.Restore(reader))
+        return false;
+
+    if (!ReadSection(reader, CheckpointSection::END))
+        return false;
+
+    // all objects exist now, so they could resolve references to each other
+    for (auto& obj : objects)
+        obj->AfterRestore();
+
+    return true;
+}
+
+bool Simulation::Restore(std::string const& path)
+{
+    if (!IsStateCapturable() || m_messageRouter || m_objects.Count() > 0)
+        return false;
+
+    CheckpointReader reader;
+    if (!reader.Open(path))
+        return false;
+
+    if (!ReadCheckpoint(reader))
+    {
+        SIMLIB_LOG(m_logger, LogLevel::CRITICAL, LogCategory_Simulation)(GetSimulationTime()) << "Checkpoint " << path << " could not be restored";
+        return false;
+    }
+
+    SIMLIB_LOG(m_logger, LogLevel::INFO, LogCategory_Simulation)(GetSimulationTime()) << "Simulation restored from " << path;
+
+    return true;
+}
+
+SimulationPtr Simulation::Fork(std::ostream& logOutput)
+{
+    std::vector<SimulationPtr> forks = Fork(1, logOutput);
+    if (forks.empty())
+        return nullptr;
+
+    return forks.front();
+}
+
+std::vector<SimulationPtr> Simulation::Fork(size_t count, std::ostream& logOutput)
+{
+    std::vector<SimulationPtr> forks;
+
+    if (!IsStateCapturable() || m_messageRouter || count == 0)
+        return forks;
+
+    // the state is captured to memory image once and restored in every copy, so the copies share nothing
+    std::vector<unsigned char> image;
+    CheckpointWriter writer;
+    writer.Open(image);
+
+    const bool written = WriteCheckpoint(writer);
+    if (!writer.Close() || !written)
+        return forks;
+
+    forks.reserve(count);
+    for (size_t i = 0; i < count; i++)
+    {
+        SimulationPtr fork = CreateFork(image, logOutput);
+        if (!fork)
+        {
+            SIMLIB_LOG(m_logger, LogLevel::CRITICAL, LogCategory_Simulation)(GetSimulationTime()) << "Simulation could not be forked";
+            forks.clear();
+            return forks;
+        }
+
+        forks.push_back(std::move(fork));
+    }
+
+    SIMLIB_LOG(m_logger, LogLevel::INFO, LogCategory_Simulation)(GetSimulationTime()) << "Simulation forked to " << count << " copies (" << image.size() << " bytes of state)";
+
+    return forks;
+}
+
+SimulationPtr Simulation::CreateFork(std::vector<unsigned char> const& image, std::ostream& logOutput) const
+{
+    SimulationPtr fork = Create(logOutput);
+
+    fork->m_logger.SetLevel(m_logger.GetLevel());
+    fork->m_logger.SetCategoryMask(m_logger.GetCategoryMask());
+    fork->m_simMode = m_simMode;
+    fork->m_dispatchMode = m_dispatchMode;
+    fork->m_dispatchThreads = m_dispatchThreads;
+    fork->m_checkpointTypes = m_checkpointTypes;
+
+    // calendars are restored by index, only their engines need to match
+    for (auto const& calendar : m_calendarList)
+        fork->m_calendarList.push_back(Calendar::Create(calendar->GetEngine()));
+
+    CheckpointReader reader;
+    if (!reader.Open(image) || !fork->ReadCheckpoint(reader))
+        return nullptr;
+
+    return fork;
+}
+
+SimulationObjectPtr Simulation::GetObjectByGUID(uint64_t guid) const
+{
+    return m_objects.GetByGUID(guid);
+}
+
+SimulationObjectView Simulation::GetObjectsByType(SimulationObjectType type) const
+{
+    return m_objects.GetByType(type);
+}
+
+SimulationObjectView Simulation::GetObjectsByClass(uint32_t objectClass) const
+{
+    return m_objects.GetByClass(objectClass);
+}
+
+SimulationObjectView Simulation::GetObjectsByTypeAndClass(SimulationObjectType type, uint32_t objectClass) const
+{
+    return m_objects.GetByTypeAndClass(type, objectClass);
+}
+
+SimulationObjectView Simulation::GetAllObjects() const
+{
+    return m_objects.GetAll();
+}
+
+void Simulation::RegisterAttributeIndex(uint32_t attributeId)
+{
+    m_objects.RegisterAttributeIndex(attributeId);
+}
+
+bool Simulation::HasAttributeIndex(uint32_t attributeId) const
+{
+    return m_objects.HasAttributeIndex(attributeId);
+}
+
+SimulationObjectView Simulation::GetObjectsByAttribute(uint32_t attributeId, int64_t value) const
+{
+    return m_objects.GetByAttribute(attributeId, value);
 }
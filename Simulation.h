@@ -7,19 +7,38 @@
 #pragma once
 
 #include <iostream>
-#include <map>
 #include <random>
+#include <mutex>
+#include <deque>
+#include <set>
+#include <unordered_set>
+#include <functional>
+#include <string>
+#include <typeindex>
+#include <cassert>
 
 #include "SimulationObject.h"
 #include "Logger.h"
 #include "Types.h"
 #include "Calendar.h"
+#include "ObjectRegistry.h"
+#include "ObjectPool.h"
+#include "TraceWriter.h"
+#include "SimulationMessage.h"
+#include "ProcessSnapshot.h"
+#include "DeferredOperation.h"
+#include "ThreadPool.h"
+#include "CheckpointTypeRegistry.h"
+#include "StatisticRegistry.h"
 
 // exit code for successfull simulation
 constexpr int64_t SimulationExitCode_OK = 0;
 // exit code for errorneous simulation (terminated due to problems)
 constexpr int64_t SimulationExitCode_Fail = -1;
 
+// executes work items [first; last) of fan-out
+using SimulationFanOutRange = std::function<void(size_t first, size_t last)>;
+
 /*
  * Supported simulation modes
  */
@@ -29,6 +48,18 @@ enum class SimulationMode
     STEPPED,        // request enter key press on every step
 };
 
+/*
+ * Supported modes of dispatching scheduled objects
+ */
+enum class SimulationDispatchMode
+{
+    SINGLE,         // take objects from calendars one by one
+    BATCH,          // take all objects scheduled to the same time at once, dispatch them grouped by class
+    PARALLEL_BATCH, // as BATCH, but objects with disjoint footprints are dispatched in parallel (see GetFootprint);
+                    // objects dispatched in parallel must not create objects, set indexed attributes, log
+                    // or update statistics
+};
+
 /*
  * Simulation class
  */
@@ -52,28 +83,67 @@ class Simulation : public std::enable_shared_from_this<Simulation>
         void SetSimulationMode(SimulationMode mode);
         // retrieves current simulation mode
         SimulationMode GetSimulationMode() const;
+        // sets mode of dispatching scheduled objects
+        void SetDispatchMode(SimulationDispatchMode mode);
+        // retrieves mode of dispatching scheduled objects
+        SimulationDispatchMode GetDispatchMode() const;
+        // sets number of threads used in parallel batch dispatch mode and parallel fan-out of events (0 stands for
+        // the number of hardware threads)
+        void SetDispatchThreadCount(size_t threadCount);
+        // retrieves number of threads used in parallel batch dispatch mode and parallel fan-out of events
+        size_t GetDispatchThreadCount() const;
 
         // runs simulation; Setup method must be called prior calling Run; returns simulation "exit code"
         int64_t Run();
+        // runs simulation until all objects and messages scheduled before given time are dispatched; may be called
+        // repeatedly with increasing end time, returns simulation "exit code"
+        int64_t RunUntil(simtime_t endTime);
+        // dispatches objects (or message) scheduled to the soonest time; returns false, if there's nothing to dispatch
+        // or the simulation was terminated
+        bool Step();
+        // retrieves time of the soonest scheduled object or message; SimulationTime_Never if there's none
+        simtime_t GetNextEventTime() const;
 
         // is the simulation running?
         bool IsRunning() const;
+        // was the simulation terminated (by Terminate call)?
+        bool IsTerminated() const;
+        // retrieves simulation "exit code"
+        int64_t GetExitCode() const;
         // terminates simulation with given exit code
         void Terminate(int64_t exitCode = SimulationExitCode_OK, SimulationObjectPtr initiator = nullptr);
         // retrieves object, that initiated simulation termination
         SimulationObjectPtr GetTerminateInitiator() const;
 
-        // adds an object to simulation, assigns GUID and returns it
+        // adds an object to simulation, assigns GUID and returns it; not allowed during parallel phase
         uint64_t AddObject(SimulationObjectPtr object);
 
-        // creates object using standard templated approach; the object needs to be child of SimulationObject
+        // creates object using standard templated approach; the object needs to be child of SimulationObject;
+        // recycled object of the same type is reused, if there is any, otherwise the object is allocated from pool;
+        // not allowed during parallel phase
         template<typename T>
         typename std::enable_if<std::is_base_of<SimulationObject, T>::value, std::shared_ptr<T>>::type
         CreateObject(uint32_t objectClass = ObjectClass_NotSpecified)
         {
+            // pools and registry are not thread-safe, and the object would not be removed by rollback
+            assert(!IsDeferring() && !IsReceivingSpeculatively());
+
             SimulationPtr self = (SimulationPtr)shared_from_this();
 
-            auto ptr = std::make_shared<T>();
+            const size_t typeId = ObjectPool_TypeId<T>();
+
+            std::shared_ptr<T> ptr;
+            if (typeId < m_recycledObjects.size() && !m_recycledObjects[typeId].empty())
+            {
+                ptr = std::static_pointer_cast<T>(m_recycledObjects[typeId].back());
+                m_recycledObjects[typeId].pop_back();
+
+                ptr->ResetState();
+                ptr->Reinitialize();
+            }
+            else
+                ptr = AllocateObject<T>();
+
             // override class setting only if the object didn't specify its own in constructor
             if (ptr->GetObjectClass() == ObjectClass_NotSpecified)
                 ptr->SetObjectClass(objectClass);
@@ -85,46 +155,262 @@ class Simulation : public std::enable_shared_from_this<Simulation>
 
         // removes object from simulation
         void RemoveObject(SimulationObjectPtr object);
+        // takes removed object for reuse by CreateObject; objects not created by CreateObject are ignored
+        void RecycleObject(SimulationObjectPtr object);
+
+        // sends message to object with given GUID in given logical process; the message is received after given delay
+        // by ReceiveMessage method of target object; returns false, if the message could not be routed (unknown logical
+        // process, or delay shorter than lookahead of parallel simulation)
+        bool SendMessage(uint32_t targetLP, uint64_t targetGUID, simtime_t delay, uint32_t kind, SimulationMessageData const& data = SimulationMessageData());
+        // delivers message to this simulation; the message is received at its time
+        void DeliverMessage(SimulationMessage const& message);
+        // retrieves index of logical process (0 if the simulation is not part of parallel simulation)
+        uint32_t GetLogicalProcessIndex() const;
+        // retrieves number of rollbacks (optimistic parallel simulation only)
+        uint64_t GetRollbackCount() const;
+        // retrieves number of rolled back messages (optimistic parallel simulation only)
+        uint64_t GetRolledBackMessageCount() const;
+
+        // registers type of objects, that could be restored from checkpoint, under given identifier; the identifier
+        // must be the same when writing and restoring the checkpoint; returns false, if the identifier or the type
+        // is already registered
+        template<typename T>
+        typename std::enable_if<std::is_base_of<SimulationObject, T>::value, bool>::type
+        RegisterCheckpointType(uint32_t checkpointTypeId)
+        {
+            return RegisterCheckpointType(checkpointTypeId, std::type_index(typeid(T)), [](Simulation& simulation) -> SimulationObjectPtr {
+                return simulation.AllocateObject<T>();
+            });
+        }
+        // registers type of objects with custom factory (e.g. for types without default constructor)
+        bool RegisterCheckpointType(uint32_t checkpointTypeId, std::type_index type, CheckpointObjectFactory factory);
+        // writes complete state of simulation (time, objects, registry, calendars, messages and statistics) to file.
+        // It must not be called while dispatching, including OnTimeStep (e.g. call it between RunUntil calls), nor
+        // on logical process of parallel simulation. All objects must be of registered types and serializable in their
+        // current state. Returns false, if the checkpoint could not be written
+        bool Checkpoint(std::string const& path);
+        // restores state written by Checkpoint; the simulation must be set up with the same number of calendars, must
+        // not contain any objects and the object types must be registered; returns false, if the checkpoint could not
+        // be restored - the simulation should be discarded then
+        bool Restore(std::string const& path);
+        // creates independent copy of simulation continuing from its current state (time, objects, registry, calendars,
+        // messages, statistics and random streams), e.g. to explore alternatives from warmed-up state; the copy uses
+        // the same modes and calendar engines and logs to given stream; the same restrictions as for Checkpoint apply;
+        // returns empty pointer, if the simulation could not be forked
+        SimulationPtr Fork(std::ostream& logOutput = std::cout);
+        // creates given number of independent copies of simulation; the state is captured just once for all of them;
+        // returns empty vector, if the simulation could not be forked
+        std::vector<SimulationPtr> Fork(size_t count, std::ostream& logOutput = std::cout);
 
         // retrieves object by its GUID
         SimulationObjectPtr GetObjectByGUID(uint64_t guid) const;
-        // retrieves object list with given type
-        SimulationObjectList GetObjectsByType(SimulationObjectType type) const;
-        // retrieves object list with given class
-        SimulationObjectList GetObjectsByClass(uint32_t objectClass) const;
-        // retrieves list of all objects in simulation
-        SimulationObjectList GetAllObjects() const;
+        // retrieves objects with given type; the view is valid until an object is added or removed
+        SimulationObjectView GetObjectsByType(SimulationObjectType type) const;
+        // retrieves objects with given class; the view is valid until an object is added or removed
+        SimulationObjectView GetObjectsByClass(uint32_t objectClass) const;
+        // retrieves objects with given type and class; the view is valid until an object is added or removed
+        SimulationObjectView GetObjectsByTypeAndClass(SimulationObjectType type, uint32_t objectClass) const;
+        // retrieves all objects in simulation; the view is valid until an object is added or removed
+        SimulationObjectView GetAllObjects() const;
+
+        // registers index on user attribute, so the objects could be effectively selected by its value
+        void RegisterAttributeIndex(uint32_t attributeId);
+        // is there an index on given user attribute?
+        bool HasAttributeIndex(uint32_t attributeId) const;
+        // retrieves objects with given value of indexed user attribute; the view is valid until an object is added,
+        // removed or its attribute changes
+        SimulationObjectView GetObjectsByAttribute(uint32_t attributeId, int64_t value) const;
 
         // retrieves simulation logger
         Logger& GetLogger();
+        // retrieves output statistics of simulation; the statistics are written to checkpoint and carried over
+        // to forked simulation
+        StatisticRegistry& GetStatistics();
+        StatisticRegistry const& GetStatistics() const;
+        // sets binary event trace writer (empty pointer disables tracing); the writer should be open
+        void SetTraceWriter(TraceWriterPtr writer);
+        // retrieves binary event trace writer
+        TraceWriterPtr GetTraceWriter() const;
 
-        // retrieves a number from true random number device
+        // retrieves a number from true random number device; thread-safe
         static unsigned int GetTrueRandomNumber();
 
+        // is the calling thread dispatching object in parallel? operations on shared state must be deferred then
+        static bool IsDeferring();
+        // is the calling thread receiving message speculatively in optimistic parallel simulation? the objects must not
+        // be created, scheduled or removed then, since rollback does not undo it
+        static bool IsReceivingSpeculatively();
+        // defers operation on given object until the end of parallel phase; remembers current schedule info of object
+        static DeferredOperation& Defer(DeferredOperationKind kind, SimulationObjectPtr const& object);
+        // runs given number of independent work items (e.g. event targets); large fan-outs are split to contiguous
+        // ranges executed on dispatch threads, operations on shared state requested by them are deferred and applied
+        // in order of items afterwards; small fan-outs and fan-outs from objects dispatched in parallel run on calling
+        // thread
+        void FanOut(size_t count, SimulationFanOutRange const& range);
+
+        // sets master seed of random streams; should be called before adding objects, since the objects are seeded
+        // when added (by default, the seed is drawn from true random number device)
+        void SetMasterSeed(uint64_t seed);
+        // retrieves master seed of random streams
+        uint64_t GetMasterSeed() const;
+        // sets replication number; replications with the same master seed use independent random streams
+        void SetReplication(uint64_t replication);
+        // retrieves replication number
+        uint64_t GetReplication() const;
+        // retrieves engine key of given random stream (see random/random_stream.h); the object GUID selects
+        // the stream of object
+        uint64_t GetRandomStreamKey(uint32_t streamId) const;
+
         // retrieves current simulation time
         simtime_t GetSimulationTime() const;
 
+        // called in batch dispatch mode with all objects scheduled to current time, before they are dispatched;
+        // the objects are grouped by class, objects of the same class are ordered by their insertion to calendar
+        virtual void OnTimeStep(SimulationBatch const& batch);
+
     protected:
-        // objects stored by their GUID
-        std::map<uint64_t, SimulationObjectPtr> m_objectGuidMap;
-        // objects stored in lists by their type
-        std::map<SimulationObjectType, SimulationObjectList> m_objectTypeMap;
-        // objects stored in lists by their class
-        std::map<uint32_t, SimulationObjectList> m_objectClassMap;
+        friend class ParallelSimulation;
+        friend class SimCoroutine;
 
-        // removes specified object from given list
-        void RemoveObjectFromList(SimulationObjectList& simList, SimulationObjectPtr object);
+        // binds simulation to parallel simulation as logical process with given index
+        void SetLogicalProcess(uint32_t index, MessageRouter* router);
+        // enables optimistic execution of logical process; received messages could be rolled back
+        void SetOptimistic(bool optimistic);
+        // dispatches at most given number of objects scheduled before safe time and messages received before horizon;
+        // messages received at safe time or later are received speculatively, so they could be rolled back; returns
+        // number of dispatches
+        size_t RunOptimistic(simtime_t safeTime, simtime_t horizon, size_t maxCount);
+        // rolls back all messages received at given time or later, sends anti-messages for messages sent by them
+        void Rollback(simtime_t time);
+        // discards saved states of messages received before given time (global virtual time); such messages are
+        // never rolled back
+        void CollectFossils(simtime_t time);
+        // retrieves time of termination
+        simtime_t GetTerminateTime() const;
+
+        // registry of all objects in simulation
+        ObjectRegistry m_objects;
+        // objects removed during current dispatch; kept alive until the dispatch ends, so the non-owning selections
+        // of objects remain valid
+        std::vector<SimulationObjectPtr> m_releasedObjects;
+
+        // pools of objects created by CreateObject, indexed by object type identifier
+        std::vector<ObjectPoolPtr> m_objectPools;
+        // recycled objects ready for reuse, indexed by object type identifier
+        std::vector<std::vector<SimulationObjectPtr>> m_recycledObjects;
+        // objects recycled during current dispatch; they are made available for reuse after the dispatch ends, since
+        // the recycled object may still be running
+        std::vector<SimulationObjectPtr> m_recycledPending;
+        // is an object being dispatched?
+        bool m_dispatching;
+
+        // retrieves pool for objects of given type identifier
+        ObjectPoolPtr const& GetObjectPool(size_t typeId);
+
+        // allocates new object from pool of its type
+        template<typename T>
+        std::shared_ptr<T> AllocateObject()
+        {
+            const size_t typeId = ObjectPool_TypeId<T>();
+
+            std::shared_ptr<T> ptr = std::allocate_shared<T>(PoolAllocator<T>(GetObjectPool(typeId)));
+            ptr->m_recycleTypeId = typeId;
+            ptr->m_recycleClass = ptr->GetObjectClass();
+
+            return ptr;
+        }
+
+        // writes base state of object (class, attributes, periodic schedule) and its user state to checkpoint; returns
+        // false, if the object could not be restored from checkpoint
+        bool WriteObject(CheckpointWriter& writer, SimulationObject const& obj) const;
+        // creates object and restores its state written by WriteObject; empty pointer, if the object could not be read
+        SimulationObjectPtr ReadObject(CheckpointReader& reader);
+        // writes scheduled objects of all calendars to checkpoint; returns false, if any of them is not registered
+        bool WriteCalendars(CheckpointWriter& writer) const;
+        // reschedules objects written by WriteCalendars
+        bool ReadCalendars(CheckpointReader& reader);
+        // reads section tag and checks it; returns false, if it's not the expected one
+        static bool ReadSection(CheckpointReader& reader, CheckpointSection section);
+        // could the state be captured or replaced now? not while an object or a batch taken from calendars is dispatched
+        bool IsStateCapturable() const;
+        // writes checkpoint to open writer
+        bool WriteCheckpoint(CheckpointWriter& writer);
+        // restores checkpoint from open reader
+        bool ReadCheckpoint(CheckpointReader& reader);
+        // creates simulation with the same settings and calendar engines and restores given checkpoint image in it
+        SimulationPtr CreateFork(std::vector<unsigned char> const& image, std::ostream& logOutput) const;
+        // releases objects removed or recycled during dispatch
+        void ReleaseDispatchedObjects();
+        // writes buffered log and trace output
+        void FlushOutput();
+
+        // fires object just taken from calendar
+        void DispatchObject(SimulationObjectPtr const& obj);
+        // logs dispatch of object and clears its schedule info; returns calendar, the object was taken from
+        CalendarPtr PrepareDispatch(SimulationObject* obj);
+        // runs object and plans its next periodic schedule
+        void FireObject(SimulationObject* obj, CalendarPtr const& cal);
+        // takes all objects scheduled to the soonest time and dispatches them
+        void DispatchBatch();
+        // does the footprint conflict with objects of parallel phase?
+        bool ConflictsWithPhase(ObjectFootprint const& footprint) const;
+        // adds object with given footprint to parallel phase
+        void AddToPhase(SimulationObject* obj, ObjectFootprint const& footprint);
+        // dispatches objects of parallel phase and applies their deferred operations in order of dispatch
+        void DispatchPhase();
+        // applies operation deferred during parallel phase
+        void ApplyDeferredOperation(DeferredOperation& op);
+        // retrieves thread pool of parallel dispatch; creates it on first use
+        ThreadPool& GetDispatchPool();
+        // executes work items split to given number of contiguous ranges on dispatch threads, then applies operations
+        // deferred by them in order of ranges
+        void RunDeferred(size_t count, size_t rangeCount, SimulationFanOutRange const& range);
+        // dispatches objects scheduled to the soonest time
+        void DispatchObjects();
+        // delivers message from top of inbox to its target object; speculatively received message is recorded, so it
+        // could be rolled back
+        void DispatchMessage(bool speculative = false);
+        // adds message to inbox
+        void PushMessage(SimulationMessage const& message);
+        // removes messages cancelled by anti-messages from top of inbox
+        void DropCancelledMessages();
+        // could the message be rolled back after being received? (is its target able to restore state?)
+        bool CanRollback(SimulationMessage const& message) const;
+        // dispatches objects or message scheduled to the soonest time, if it's sooner than given end time; returns
+        // false, if there's nothing to dispatch
+        bool DispatchNext(simtime_t endTime);
 
     private:
-        // next GUID to be assigned
-        uint64_t m_guidNext;
         // logger instance
         Logger m_logger;
+        // binary event trace writer
+        TraceWriterPtr m_traceWriter;
 
         // current simulation time
         simtime_t m_simulationTime;
         // simulation mode used
         SimulationMode m_simMode;
+        // dispatch mode used
+        SimulationDispatchMode m_dispatchMode;
+        // batch of objects being dispatched (kept to reuse allocated memory)
+        SimulationBatch m_batch;
+
+        // number of threads used in parallel batch dispatch mode
+        size_t m_dispatchThreads;
+        // thread pool of parallel batch dispatch mode and parallel fan-out (created on first use)
+        std::unique_ptr<ThreadPool> m_dispatchPool;
+        // objects of current parallel phase, in order of dispatch
+        std::vector<SimulationObject*> m_phase;
+        // calendars, the objects of parallel phase were taken from
+        std::vector<CalendarPtr> m_phaseCalendars;
+        // GUIDs read by objects of parallel phase
+        std::unordered_set<uint64_t> m_phaseReads;
+        // GUIDs written by objects of parallel phase
+        std::unordered_set<uint64_t> m_phaseWrites;
+        // footprint of object being added to parallel phase (kept to reuse allocated memory)
+        ObjectFootprint m_footprint;
+        // operations deferred during parallel phase or fan-out, one list per range
+        std::vector<std::vector<DeferredOperation>> m_deferredOperations;
         // all calendars in consideration
         CalendarList m_calendarList;
 
@@ -134,7 +420,66 @@ class Simulation : public std::enable_shared_from_this<Simulation>
         SimulationObjectPtr m_exitInitiator;
         // is the simulation still running?
         bool m_running;
+        // was the simulation terminated?
+        bool m_terminated;
+        // number of dispatch steps (used in stepped mode)
+        size_t m_step;
+
+        // received messages; min-heap ordered by receive time
+        std::vector<SimulationMessage> m_inbox;
+        // router of messages to other logical processes (nullptr if not part of parallel simulation)
+        MessageRouter* m_messageRouter;
+        // index of logical process
+        uint32_t m_lpIndex;
+        // sequence number of next sent message
+        uint64_t m_messageSequence;
+
+        /*
+         * Message received speculatively in optimistic mode
+         */
+        struct ProcessedMessage
+        {
+            // received message
+            SimulationMessage message;
+            // state saving mode of target at time of receive
+            StateSavingMode stateSaving;
+            // saved state of target (StateSavingMode::COPY)
+            ProcessSnapshot snapshot;
+            // number of messages sent by target while receiving the message
+            size_t sentCount;
+        };
+
+        // is the logical process executed optimistically?
+        bool m_optimistic;
+        // is a message being received speculatively?
+        bool m_speculative;
+        // messages received speculatively, in order of receive
+        std::deque<ProcessedMessage> m_processed;
+        // messages sent while receiving speculatively, in order of send
+        std::deque<SimulationMessage> m_sentMessages;
+        // snapshots of discarded processed messages, ready for reuse
+        std::vector<ProcessSnapshot> m_freeSnapshots;
+        // messages in inbox cancelled by anti-messages, identified by source LP and sequence number
+        std::set<std::pair<uint32_t, uint64_t>> m_cancelled;
+        // time of termination
+        simtime_t m_terminateTime;
+        // number of rollbacks
+        uint64_t m_rollbackCount;
+        // number of rolled back messages
+        uint64_t m_rolledBackMessages;
+
+        // object types, that could be restored from checkpoint
+        CheckpointTypeRegistry m_checkpointTypes;
+        // output statistics
+        StatisticRegistry m_statistics;
+
+        // master seed of random streams
+        uint64_t m_masterSeed;
+        // replication number
+        uint64_t m_replication;
 
         // static random device used for ocassional TRNG generations
         static std::random_device m_randDev;
+        // guards the random device, which is shared by all simulations
+        static std::mutex m_randDevMutex;
 };
@@ -0,0 +1,84 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+#include <limits>
+
+#include "Types.h"
+
+// time of events, that never happen (e.g. next event time of empty simulation)
+constexpr simtime_t SimulationTime_Never = std::numeric_limits<simtime_t>::max();
+
+// number of user data items carried by message
+constexpr size_t SimulationMessage_DataCount = 4;
+
+// flag of anti-message, which cancels previously sent message with the same source LP and sequence number (sent by
+// optimistic parallel simulation, when the send is rolled back)
+constexpr uint32_t SimulationMessageFlag_Anti = 1;
+
+// user data carried by message
+using SimulationMessageData = std::array<int64_t, SimulationMessage_DataCount>;
+
+/*
+ * Timestamped message sent to simulation object, possibly in another logical process; plain structure, so it could be
+ * copied between message queues of logical processes
+ */
+struct SimulationMessage
+{
+    // time of receive
+    simtime_t time;
+    // time of send
+    simtime_t sendTime;
+    // GUID of target object (within target logical process)
+    uint64_t targetGUID;
+    // sequence number of message within source logical process
+    uint64_t sequence;
+    // index of source logical process
+    uint32_t sourceLP;
+    // index of target logical process
+    uint32_t targetLP;
+    // user-defined message kind
+    uint32_t kind;
+    // message flags (SimulationMessageFlag_*)
+    uint32_t flags;
+    // user data
+    SimulationMessageData data;
+};
+
+/*
+ * Comparator functor for messages; returns true, if message a is received after message b. Messages received at
+ * the same time are ordered by their source logical process and send order, so the order does not depend on the order
+ * of delivery
+ */
+struct SimulationMessageCmp
+{
+    bool operator()(SimulationMessage const& a, SimulationMessage const& b) const
+    {
+        if (a.time != b.time)
+            return a.time > b.time;
+        if (a.sourceLP != b.sourceLP)
+            return a.sourceLP > b.sourceLP;
+        return a.sequence > b.sequence;
+    }
+};
+
+/*
+ * Interface of router of messages between logical processes
+ */
+class MessageRouter
+{
+    public:
+        virtual ~MessageRouter() { };
+
+        // routes message to its target logical process; returns false, if the message could not be routed
+        virtual bool RouteMessage(SimulationMessage const& message) = 0;
+        // checks, if message with given target and delay would be routed, without routing it; must be callable from
+        // dispatch threads (see Simulation::IsDeferring)
+        virtual bool CheckRoute(uint32_t targetLP, simtime_t delay) = 0;
+};
@@ -7,12 +7,14 @@
 #include "SimulationObject.h"
 #include "Simulation.h"
 #include "Calendar.h"
+#include "ObjectRegistry.h"
 
 #include "Process.h"
 #include "Event.h"
 
 SimulationObject::SimulationObject(SimulationObjectType type, SimulationPtr simulation, uint32_t objectClass)
-    : m_type(type), m_objectClass(objectClass), m_simulation(simulation)
+    : m_type(type), m_objectClass(objectClass), m_registry(nullptr), m_simulation(simulation), m_simTimeNext(0), m_calendarHandle(CalendarHandle_Invalid),
+      m_recycleTypeId(ObjectPool_NoTypeId), m_recycleClass(objectClass)
 {
     m_guid = 0;
 }
@@ -64,23 +66,46 @@ CalendarPtr SimulationObject::GetCurrentCalendar() const
 
 void SimulationObject::Schedule(CalendarPtr calendar, simtime_t scheduleTime, bool relative)
 {
-    auto self = shared_from_this();
-
-    // remove from calendar, if present
-    if (m_currCalendar)
-        m_currCalendar->remove(self);
+    // calendars are not rolled back
+    assert(!Simulation::IsReceivingSpeculatively());
 
     // relative time needs to have base schedule time retrieved from simulation object
     if (relative)
     {
         SimulationPtr simulation = GetSimulation();
-        if (simulation)
-            m_simTimeNext = simulation->GetSimulationTime() + scheduleTime;
-        else
+        if (!simulation)
             return;
+
+        scheduleTime += simulation->GetSimulationTime();
     }
-    else
+
+    // dispatched in parallel - the calendar is updated after the parallel phase
+    if (Simulation::IsDeferring())
+    {
+        DeferredOperation& op = Simulation::Defer(DeferredOperationKind::SCHEDULE, shared_from_this());
+        op.calendar = calendar;
+        op.time = scheduleTime;
+
+        m_currCalendar = calendar;
+        m_simTimeNext = scheduleTime;
+        return;
+    }
+
+    // already present in the same calendar - just move the entry using its handle
+    if (m_currCalendar == calendar && m_calendarHandle != CalendarHandle_Invalid)
+    {
         m_simTimeNext = scheduleTime;
+        m_currCalendar->update(m_calendarHandle);
+        return;
+    }
+
+    auto self = shared_from_this();
+
+    // remove from calendar, if present (the object taken from calendar with batch has no entry there)
+    if (m_currCalendar && m_calendarHandle != CalendarHandle_Invalid)
+        m_currCalendar->remove(self);
+
+    m_simTimeNext = scheduleTime;
 
     m_currCalendar = calendar;
     m_currCalendar->push(self);
@@ -92,6 +117,88 @@ void SimulationObject::ClearScheduleInfo()
     m_currCalendar = nullptr;
 }
 
+void SimulationObject::Unschedule()
+{
+    assert(!Simulation::IsReceivingSpeculatively());
+
+    if (m_currCalendar)
+    {
+        if (m_calendarHandle != CalendarHandle_Invalid)
+            m_currCalendar->remove(shared_from_this());
+        m_currCalendar = nullptr;
+    }
+    m_simTimeNext = 0;
+}
+
+SimulationObjectAttribute* SimulationObject::FindAttribute(uint32_t attributeId)
+{
+    for (auto& attr : m_attributes)
+    {
+        if (attr.id == attributeId)
+            return &attr;
+    }
+
+    return nullptr;
+}
+
+const SimulationObjectAttribute* SimulationObject::FindAttribute(uint32_t attributeId) const
+{
+    for (auto& attr : m_attributes)
+    {
+        if (attr.id == attributeId)
+            return &attr;
+    }
+
+    return nullptr;
+}
+
+void SimulationObject::SetAttribute(uint32_t attributeId, int64_t value)
+{
+    // registered object - let the registry move it between attribute index lists
+    if (m_registry)
+    {
+        m_registry->SetAttribute(this, attributeId, value);
+        return;
+    }
+
+    SimulationObjectAttribute* attr = FindAttribute(attributeId);
+    if (attr)
+        attr->value = value;
+    else
+        m_attributes.push_back({ attributeId, 0, value });
+}
+
+int64_t SimulationObject::GetAttribute(uint32_t attributeId, int64_t defaultValue) const
+{
+    const SimulationObjectAttribute* attr = FindAttribute(attributeId);
+    return attr ? attr->value : defaultValue;
+}
+
+bool SimulationObject::HasAttribute(uint32_t attributeId) const
+{
+    return (FindAttribute(attributeId) != nullptr);
+}
+
+bool SimulationObject::IsSerializable() const
+{
+    return true;
+}
+
+void SimulationObject::Serialize(CheckpointWriter& writer) const
+{
+    //
+}
+
+bool SimulationObject::Deserialize(CheckpointReader& reader)
+{
+    return true;
+}
+
+void SimulationObject::AfterRestore()
+{
+    //
+}
+
 SimProcess* SimulationObject::ToProcess()
 {
     return dynamic_cast<SimProcess*>(this);
@@ -104,19 +211,24 @@ SimEvent* SimulationObject::ToEvent()
 
 void SimulationObject::Terminate()
 {
+    assert(!Simulation::IsReceivingSpeculatively());
+
     auto simulation = GetSimulation();
     if (!simulation)
         return;
 
     auto self = (SimulationObjectPtr)shared_from_this();
 
-    // at first, remove from calendar
-    if (m_currCalendar)
+    // dispatched in parallel - the object is removed after the parallel phase
+    if (Simulation::IsDeferring())
     {
-        m_currCalendar->remove(self);
-        m_currCalendar = nullptr;
+        Simulation::Defer(DeferredOperationKind::TERMINATE_OBJECT, self);
+        ClearScheduleInfo();
+        return;
     }
-    m_simTimeNext = 0;
+
+    // at first, remove from calendar
+    Unschedule();
 
     // remove from simulation
     simulation->RemoveObject(self);
@@ -124,37 +236,115 @@ void SimulationObject::Terminate()
     m_simulation.reset();
 }
 
+void SimulationObject::Recycle()
+{
+    assert(!Simulation::IsReceivingSpeculatively());
+
+    auto simulation = GetSimulation();
+    if (!simulation)
+        return;
+
+    auto self = (SimulationObjectPtr)shared_from_this();
+
+    if (Simulation::IsDeferring())
+    {
+        Simulation::Defer(DeferredOperationKind::RECYCLE_OBJECT, self);
+        ClearScheduleInfo();
+        return;
+    }
+
+    Terminate();
+
+    simulation->RecycleObject(self);
+}
+
+void SimulationObject::ResetState()
+{
+    m_guid = 0;
+    m_objectClass = m_recycleClass;
+    m_attributes.clear();
+    m_scheduleGenerator.Reset();
+    ClearScheduleInfo();
+}
+
+void SimulationObject::Reinitialize()
+{
+    //
+}
+
+void SimulationObject::ReceiveMessage(SimulationMessage const& message)
+{
+    //
+}
+
+bool SimulationObject::GetFootprint(ObjectFootprint& footprint) const
+{
+    return false;
+}
+
+bool SimulationObject::SendMessage(uint32_t targetLP, uint64_t targetGUID, simtime_t delay, uint32_t kind, SimulationMessageData const& data)
+{
+    auto simulation = GetSimulation();
+    if (!simulation)
+        return false;
+
+    return simulation->SendMessage(targetLP, targetGUID, delay, kind, data);
+}
+
+void SimulationObject::SeedRandomStreams(Simulation const& simulation)
+{
+    m_scheduleGenerator.Seed(simulation.GetRandomStreamKey(random_stream_schedule), m_guid);
+}
+
+bool SimulationObject::GetRandomStreamKey(uint32_t streamId, uint64_t& key) const
+{
+    if (!m_registry)
+        return false;
+
+    auto simulation = GetSimulation();
+    if (!simulation)
+        return false;
+
+    key = simulation->GetRandomStreamKey(streamId);
+    return true;
+}
+
+void SimulationObject::SeedScheduleGenerator()
+{
+    uint64_t key;
+    if (GetRandomStreamKey(random_stream_schedule, key))
+        m_scheduleGenerator.Seed(key, m_guid);
+}
+
 bool SimulationObject::HasPeriodicSchedule() const
 {
-    return (m_scheduleGenerator != nullptr);
+    return m_scheduleGenerator.IsSet();
 }
 
 void SimulationObject::NextPeriodicSchedule(CalendarPtr calendar)
 {
-    if (!m_scheduleGenerator)
+    if (!m_scheduleGenerator.IsSet())
         return;
 
-    Schedule(calendar, (*m_scheduleGenerator)(), true);
+    Schedule(calendar, m_scheduleGenerator(), true);
 }
 
 void SimulationObject::CancelPeriodicSchedule(bool removeFromCalendar)
 {
-    if (!m_scheduleGenerator)
+    if (!m_scheduleGenerator.IsSet())
         return;
 
-    m_scheduleGenerator.reset();
+    m_scheduleGenerator.Reset();
 
     if (removeFromCalendar)
     {
-        auto self = (SimulationObjectPtr)shared_from_this();
-
-        // at first, remove from calendar
-        if (m_currCalendar)
+        if (Simulation::IsDeferring())
         {
-            m_currCalendar->remove(self);
-            m_currCalendar = nullptr;
+            Simulation::Defer(DeferredOperationKind::UNSCHEDULE, shared_from_this());
+            ClearScheduleInfo();
+            return;
         }
-        // then reset time
-        m_simTimeNext = 0;
+
+        Unschedule();
     }
 }
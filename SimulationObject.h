@@ -10,9 +10,17 @@
 #include <cstdint>
 #include <list>
 #include <limits>
+#include <array>
+#include <vector>
 
 #include "Types.h"
-#include "random/base_generator.h"
+#include "ObjectPool.h"
+#include "ScheduleGenerator.h"
+#include "random/random_stream.h"
+#include "SimulationMessage.h"
+#include "ObjectFootprint.h"
+#include "CheckpointWriter.h"
+#include "CheckpointReader.h"
 
 /*
  * Type of object in simulation
@@ -23,15 +31,47 @@ enum class SimulationObjectType
     EVENT
 };
 
+// number of object types
+constexpr size_t SimulationObjectTypeCount = 2;
+
+/*
+ * Dense lists of object registry; the object remembers its position within each of them
+ */
+enum class ObjectRegistryList
+{
+    ALL,        // list of all objects
+    TYPE,       // list of objects of the same type
+    CLASS,      // list of objects of the same class
+    TYPE_CLASS  // list of objects of the same type and class (composite index)
+};
+
+// number of object registry lists
+constexpr size_t ObjectRegistryListCount = 4;
+
 // class is not specified (default)
 constexpr uint32_t ObjectClass_NotSpecified = 0;
 
+/*
+ * User-defined attribute of simulation object (e.g. integer state code)
+ */
+struct SimulationObjectAttribute
+{
+    // attribute identifier
+    uint32_t id;
+    // position within attribute index list (maintained by object registry, if the attribute is indexed)
+    uint32_t indexPosition;
+    // attribute value
+    int64_t value;
+};
+
 /*
  * Class representing a single simulation object
  */
 class SimulationObject : public std::enable_shared_from_this<SimulationObject>
 {
     friend class Simulation;
+    friend class Calendar;
+    friend class ObjectRegistry;
     public:
         SimulationObject(SimulationObjectType type, SimulationPtr simulation, uint32_t objectClass = ObjectClass_NotSpecified);
 
@@ -57,9 +97,10 @@ class SimulationObject : public std::enable_shared_from_this<SimulationObject>
         typename std::enable_if<std::is_base_of<base_generator<simtime_t>, T>::value, void>::type
             SchedulePeriodic(CalendarPtr calendar, bool initialFire, Args... args)
         {
-            m_scheduleGenerator = std::make_unique<T>(args...);
+            m_scheduleGenerator.Emplace<T>(args...);
+            SeedScheduleGenerator();
 
-            Schedule(calendar, initialFire ? 0 : (*m_scheduleGenerator)(), true);
+            Schedule(calendar, initialFire ? 0 : m_scheduleGenerator(), true);
         }
 
         // does this object have periodic schedule
@@ -69,8 +110,37 @@ class SimulationObject : public std::enable_shared_from_this<SimulationObject>
         // cancels periodic schedule if set up previously
         void CancelPeriodicSchedule(bool removeFromCalendar = false);
 
+        // seeds user generator with stream of this object (see random_stream_user); the object must be added
+        // to simulation, otherwise the generator is left untouched
+        template<typename T>
+        void SeedGenerator(base_generator<T>& generator, uint32_t streamId)
+        {
+            uint64_t key;
+            if (GetRandomStreamKey(streamId, key))
+                generator.seed(key, m_guid);
+        }
+
         // called when scheduled object is fired
         virtual void Run() = 0;
+        // declares objects read and written by Run method (besides this object); returns false, if the footprint
+        // is not known - then the object is never dispatched in parallel (default); Run method of object with known
+        // footprint must not create objects, set indexed attributes, log or update statistics
+        virtual bool GetFootprint(ObjectFootprint& footprint) const;
+        // called when message sent to this object is received; empty implementation here
+        virtual void ReceiveMessage(SimulationMessage const& message);
+        // could the object be written to checkpoint in its current state? true here; when false, the checkpoint
+        // and fork fail
+        virtual bool IsSerializable() const;
+        // writes user state of object to checkpoint (base state, attributes and periodic schedule are written
+        // by simulation); empty implementation here
+        virtual void Serialize(CheckpointWriter& writer) const;
+        // reads user state written by Serialize; references to other objects should be resolved in AfterRestore, since
+        // the objects may not be restored yet; returns false, if the state is not valid
+        virtual bool Deserialize(CheckpointReader& reader);
+        // called after all objects are restored from checkpoint; empty implementation here
+        virtual void AfterRestore();
+        // sends message to object in given logical process (see Simulation::SendMessage)
+        bool SendMessage(uint32_t targetLP, uint64_t targetGUID, simtime_t delay, uint32_t kind, SimulationMessageData const& data = SimulationMessageData());
 
         // casts this object to process
         SimProcess* ToProcess();
@@ -79,6 +149,17 @@ class SimulationObject : public std::enable_shared_from_this<SimulationObject>
 
         // terminates this object within current simulation
         void Terminate();
+        // terminates this object and returns it to simulation, so the next CreateObject call of the same type reuses
+        // it without allocation; the object must not be used by caller after this call
+        void Recycle();
+
+        // sets user attribute value; the indexes registered in simulation are notified about the change, so indexed
+        // attributes could not be set during parallel phase
+        void SetAttribute(uint32_t attributeId, int64_t value);
+        // retrieves user attribute value; returns defaultValue, if the attribute is not set
+        int64_t GetAttribute(uint32_t attributeId, int64_t defaultValue = 0) const;
+        // is user attribute set?
+        bool HasAttribute(uint32_t attributeId) const;
 
     protected:
         // sets GUID (used from within Simulation object only); DO NOT call after adding to simulation
@@ -88,6 +169,14 @@ class SimulationObject : public std::enable_shared_from_this<SimulationObject>
         // sets simulation which contains this object; DO NOT call after adding to simulation
         void SetSimulation(SimulationPtr simulation);
 
+        // called when recycled object is being reused; resets state of derived object, empty implementation here
+        virtual void Reinitialize();
+        // called after the object is added to simulation and has its GUID; seeds random streams of the object
+        virtual void SeedRandomStreams(Simulation const& simulation);
+
+        // retrieves key of random stream of this object; returns false, if the object is not in simulation
+        bool GetRandomStreamKey(uint32_t streamId, uint64_t& key) const;
+
     private:
         // object GUID (assigned by simulation)
         uint64_t m_guid;
@@ -95,18 +184,40 @@ class SimulationObject : public std::enable_shared_from_this<SimulationObject>
         SimulationObjectType m_type;
         // object custom class
         uint32_t m_objectClass;
+        // positions within object registry lists
+        std::array<uint32_t, ObjectRegistryListCount> m_registryPositions;
+        // registry this object is registered in (nullptr if not registered)
+        ObjectRegistry* m_registry;
+        // user attributes; there's usually just a few of them, so the lookup is linear
+        std::vector<SimulationObjectAttribute> m_attributes;
 
         // simulation, where this object belongs
         SimulationWeakPtr m_simulation;
 
-        // random 
-        std::unique_ptr<base_generator<simtime_t>> m_scheduleGenerator;
+        // generator of periodic schedule
+        ScheduleGenerator m_scheduleGenerator;
 
         // scheduled time (0 if not scheduled)
         simtime_t m_simTimeNext;
         // scheduled calendar (empty ptr if not scheduled)
         CalendarPtr m_currCalendar;
+        // handle of entry within scheduled calendar (maintained by calendar)
+        CalendarHandle m_calendarHandle;
+
+        // identifier of object type for recycling (ObjectPool_NoTypeId if not created by simulation)
+        size_t m_recycleTypeId;
+        // class set by object constructor; restored when the object is recycled
+        uint32_t m_recycleClass;
 
         // clears schedule info
         void ClearScheduleInfo();
+        // removes object from its calendar and clears schedule info
+        void Unschedule();
+        // seeds periodic schedule generator, if the object is already in simulation
+        void SeedScheduleGenerator();
+        // resets base object state before reusing recycled object
+        void ResetState();
+        // retrieves user attribute record; nullptr if the attribute is not set
+        SimulationObjectAttribute* FindAttribute(uint32_t attributeId);
+        const SimulationObjectAttribute* FindAttribute(uint32_t attributeId) const;
 };
@@ -0,0 +1,202 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "StatisticRegistry.h"
+#include "Simulation.h"
+#include "CheckpointWriter.h"
+#include "CheckpointReader.h"
+
+StatisticRegistry::StatisticRegistry(Simulation const* simulation)
+    : m_simulation(simulation)
+{
+    //
+}
+
+TallyStatistic& StatisticRegistry::GetTally(std::string const& name)
+{
+    // the statistics are created on retrieval, so the registry could not be used during parallel phase
+    assert(!Simulation::IsDeferring());
+
+    return m_tallies[name];
+}
+
+TimeWeightedStatistic& StatisticRegistry::GetTimeWeighted(std::string const& name)
+{
+    assert(!Simulation::IsDeferring());
+
+    auto itr = m_timeWeighted.find(name);
+    if (itr == m_timeWeighted.end())
+        itr = m_timeWeighted.emplace(name, TimeWeightedStatistic(m_simulation)).first;
+
+    return itr->second;
+}
+
+QuantileStatistic& StatisticRegistry::GetQuantiles(std::string const& name, double compression)
+{
+    assert(!Simulation::IsDeferring());
+
+    auto itr = m_quantiles.find(name);
+    if (itr == m_quantiles.end())
+        itr = m_quantiles.emplace(name, QuantileStatistic(compression)).first;
+
+    return itr->second;
+}
+
+HistogramStatistic& StatisticRegistry::GetHistogram(std::string const& name, double minValue, double maxValue, size_t binCount)
+{
+    assert(!Simulation::IsDeferring());
+
+    auto itr = m_histograms.find(name);
+    if (itr == m_histograms.end())
+        itr = m_histograms.emplace(name, HistogramStatistic(minValue, maxValue, binCount)).first;
+
+    return itr->second;
+}
+
+std::map<std::string, TallyStatistic> const& StatisticRegistry::GetTallies() const
+{
+    return m_tallies;
+}
+
+std::map<std::string, TimeWeightedStatistic> const& StatisticRegistry::GetTimeWeighted() const
+{
+    return m_timeWeighted;
+}
+
+std::map<std::string, QuantileStatistic> const& StatisticRegistry::GetQuantiles() const
+{
+    return m_quantiles;
+}
+
+std::map<std::string, HistogramStatistic> const& StatisticRegistry::GetHistograms() const
+{
+    return m_histograms;
+}
+
+void StatisticRegistry::Close()
+{
+    for (auto& statistic : m_timeWeighted)
+        statistic.second.Close();
+}
+
+void StatisticRegistry::Close(simtime_t time)
+{
+    for (auto& statistic : m_timeWeighted)
+        statistic.second.Close(time);
+}
+
+bool StatisticRegistry::Merge(StatisticRegistry const& other)
+{
+    for (auto const& statistic : other.m_tallies)
+        m_tallies[statistic.first].Merge(statistic.second);
+
+    for (auto const& statistic : other.m_timeWeighted)
+        GetTimeWeighted(statistic.first).Merge(statistic.second);
+
+    for (auto const& statistic : other.m_quantiles)
+        GetQuantiles(statistic.first, statistic.second.GetCompression()).Merge(statistic.second);
+
+    // the histogram not present here takes the layout of the merged one
+    bool merged = true;
+    for (auto const& statistic : other.m_histograms)
+    {
+        auto itr = m_histograms.find(statistic.first);
+        if (itr == m_histograms.end())
+            m_histograms.emplace(statistic.first, statistic.second);
+        else if (!itr->second.Merge(statistic.second))
+            merged = false;
+    }
+
+    return merged;
+}
+
+void StatisticRegistry::Reset()
+{
+    for (auto& statistic : m_tallies)
+        statistic.second.Reset();
+    for (auto& statistic : m_timeWeighted)
+        statistic.second.Reset();
+    for (auto& statistic : m_quantiles)
+        statistic.second.Reset();
+    for (auto& statistic : m_histograms)
+        statistic.second.Reset();
+}
+
+void StatisticRegistry::Clear()
+{
+    m_tallies.clear();
+    m_timeWeighted.clear();
+    m_quantiles.clear();
+    m_histograms.clear();
+}
+
+void StatisticRegistry::Save(CheckpointWriter& writer) const
+{
+    writer.WriteVarUInt(m_tallies.size());
+    for (auto const& statistic : m_tallies)
+    {
+        writer.WriteString(statistic.first);
+        statistic.second.Serialize(writer);
+    }
+
+    writer.WriteVarUInt(m_timeWeighted.size());
+    for (auto const& statistic : m_timeWeighted)
+    {
+        writer.WriteString(statistic.first);
+        statistic.second.Serialize(writer);
+    }
+
+    writer.WriteVarUInt(m_quantiles.size());
+    for (auto const& statistic : m_quantiles)
+    {
+        writer.WriteString(statistic.first);
+        statistic.second.Serialize(writer);
+    }
+
+    writer.WriteVarUInt(m_histograms.size());
+    for (auto const& statistic : m_histograms)
+    {
+        writer.WriteString(statistic.first);
+        statistic.second.Serialize(writer);
+    }
+}
+
+bool StatisticRegistry::Restore(CheckpointReader& reader)
+{
+    // the model may hold references to statistics retrieved before restore, so they are overwritten, not replaced
+    Reset();
+
+    uint64_t count = reader.ReadVarUInt();
+    for (uint64_t i = 0; i < count && reader.IsGood(); i++)
+    {
+        if (!GetTally(reader.ReadString()).Deserialize(reader))
+            return false;
+    }
+
+    count = reader.ReadVarUInt();
+    for (uint64_t i = 0; i < count && reader.IsGood(); i++)
+    {
+        if (!GetTimeWeighted(reader.ReadString()).Deserialize(reader))
+            return false;
+    }
+
+    // compression and layout are restored as well
+    count = reader.ReadVarUInt();
+    for (uint64_t i = 0; i < count && reader.IsGood(); i++)
+    {
+        if (!GetQuantiles(reader.ReadString()).Deserialize(reader))
+            return false;
+    }
+
+    count = reader.ReadVarUInt();
+    for (uint64_t i = 0; i < count && reader.IsGood(); i++)
+    {
+        if (!GetHistogram(reader.ReadString()).Deserialize(reader))
+            return false;
+    }
+
+    return reader.IsGood();
+}
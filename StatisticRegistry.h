@@ -0,0 +1,79 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <map>
+#include <string>
+
+#include "Types.h"
+#include "TallyStatistic.h"
+#include "TimeWeightedStatistic.h"
+#include "QuantileStatistic.h"
+#include "HistogramStatistic.h"
+
+/*
+ * Named output statistics of simulation
+ *
+ * The statistics are created on first retrieval and stay at the same address, so the model should retrieve them once
+ * (e.g. when set up) and update them directly. Registries of replications could be merged statistic by statistic.
+ * Neither the registry nor the statistics could be used by objects dispatched in parallel (see GetFootprint)
+ */
+class StatisticRegistry
+{
+    public:
+        StatisticRegistry(Simulation const* simulation = nullptr);
+
+        // retrieves tally statistic of given name; creates it, if it does not exist
+        TallyStatistic& GetTally(std::string const& name);
+        // retrieves time-weighted statistic of given name (driven by simulation time); creates it, if it does not exist
+        TimeWeightedStatistic& GetTimeWeighted(std::string const& name);
+        // retrieves quantile statistic of given name; creates it with given compression, if it does not exist
+        QuantileStatistic& GetQuantiles(std::string const& name, double compression = QuantileStatistic_DefaultCompression);
+        // retrieves histogram of given name; creates it with given layout, if it does not exist
+        HistogramStatistic& GetHistogram(std::string const& name, double minValue = 1.0, double maxValue = 1e6,
+                                         size_t binCount = HistogramStatistic_DefaultBinCount);
+
+        // retrieves all tally statistics by name
+        std::map<std::string, TallyStatistic> const& GetTallies() const;
+        // retrieves all time-weighted statistics by name
+        std::map<std::string, TimeWeightedStatistic> const& GetTimeWeighted() const;
+        // retrieves all quantile statistics by name
+        std::map<std::string, QuantileStatistic> const& GetQuantiles() const;
+        // retrieves all histograms by name
+        std::map<std::string, HistogramStatistic> const& GetHistograms() const;
+
+        // accounts current values of time-weighted statistics up to current simulation time (e.g. at the end of run)
+        void Close();
+        // accounts current values of time-weighted statistics up to given time
+        void Close(simtime_t time);
+        // merges statistics of other registry (e.g. of other replication) by their names; returns false, if some
+        // histograms could not be merged due to different layout
+        bool Merge(StatisticRegistry const& other);
+        // forgets observations of all statistics (e.g. after warm-up period); the statistics are kept
+        void Reset();
+        // removes all statistics
+        void Clear();
+
+        // writes all statistics to checkpoint
+        void Save(CheckpointWriter& writer) const;
+        // restores statistics written by Save; existing statistics stay at their addresses (those missing
+        // in checkpoint are reset); returns false, if the checkpoint is not valid
+        bool Restore(CheckpointReader& reader);
+
+    private:
+        // simulation providing time to time-weighted statistics (nullptr, if the registry just merges others)
+        Simulation const* m_simulation;
+
+        // tally statistics by name
+        std::map<std::string, TallyStatistic> m_tallies;
+        // time-weighted statistics by name
+        std::map<std::string, TimeWeightedStatistic> m_timeWeighted;
+        // quantile statistics by name
+        std::map<std::string, QuantileStatistic> m_quantiles;
+        // histograms by name
+        std::map<std::string, HistogramStatistic> m_histograms;
+};
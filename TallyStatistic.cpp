@@ -0,0 +1,119 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "TallyStatistic.h"
+#include "Simulation.h"
+#include "CheckpointWriter.h"
+#include "CheckpointReader.h"
+
+#include <cmath>
+#include <algorithm>
+
+TallyStatistic::TallyStatistic()
+{
+    Reset();
+}
+
+void TallyStatistic::Add(double value)
+{
+    // statistics are shared by objects, so they could not be updated during parallel phase
+    assert(!Simulation::IsDeferring());
+
+    m_count++;
+
+    const double delta = value - m_mean;
+    m_mean += delta / static_cast<double>(m_count);
+    m_m2 += delta * (value - m_mean);
+
+    m_min = (m_count == 1) ? value : std::min(m_min, value);
+    m_max = (m_count == 1) ? value : std::max(m_max, value);
+}
+
+void TallyStatistic::Merge(TallyStatistic const& other)
+{
+    if (other.m_count == 0)
+        return;
+
+    if (m_count == 0)
+    {
+        *this = other;
+        return;
+    }
+
+    // parallel variant of Welford's method (Chan et al.)
+    const double total = static_cast<double>(m_count + other.m_count);
+    const double delta = other.m_mean - m_mean;
+
+    m_mean += delta * static_cast<double>(other.m_count) / total;
+    m_m2 += other.m_m2 + delta * delta * static_cast<double>(m_count) * static_cast<double>(other.m_count) / total;
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+    m_count += other.m_count;
+}
+
+void TallyStatistic::Reset()
+{
+    m_count = 0;
+    m_mean = 0.0;
+    m_m2 = 0.0;
+    m_min = 0.0;
+    m_max = 0.0;
+}
+
+void TallyStatistic::Serialize(CheckpointWriter& writer) const
+{
+    writer.WriteVarUInt(m_count);
+    writer.WriteDouble(m_mean);
+    writer.WriteDouble(m_m2);
+    writer.WriteDouble(m_min);
+    writer.WriteDouble(m_max);
+}
+
+bool TallyStatistic::Deserialize(CheckpointReader& reader)
+{
+    m_count = reader.ReadVarUInt();
+    m_mean = reader.ReadDouble();
+    m_m2 = reader.ReadDouble();
+    m_min = reader.ReadDouble();
+    m_max = reader.ReadDouble();
+
+    return reader.IsGood();
+}
+
+uint64_t TallyStatistic::GetCount() const
+{
+    return m_count;
+}
+
+double TallyStatistic::GetMean() const
+{
+    return m_mean;
+}
+
+double TallyStatistic::GetVariance() const
+{
+    return (m_count > 1) ? m_m2 / static_cast<double>(m_count - 1) : 0.0;
+}
+
+double TallyStatistic::GetStdDev() const
+{
+    return std::sqrt(GetVariance());
+}
+
+double TallyStatistic::GetMin() const
+{
+    return m_min;
+}
+
+double TallyStatistic::GetMax() const
+{
+    return m_max;
+}
+
+double TallyStatistic::GetConfidenceHalfWidth(double z) const
+{
+    return (m_count > 1) ? z * std::sqrt(GetVariance() / static_cast<double>(m_count)) : 0.0;
+}
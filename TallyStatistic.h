@@ -0,0 +1,62 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/*
+ * Streaming statistic of observed values (e.g. waiting times)
+ *
+ * Mean and variance are updated by Welford's method, so the statistic takes constant memory and stays numerically
+ * stable for long runs; statistics of replications could be merged
+ */
+class TallyStatistic
+{
+    public:
+        TallyStatistic();
+
+        // adds observed value
+        void Add(double value);
+        // merges statistic of other observations (e.g. other replication)
+        void Merge(TallyStatistic const& other);
+        // forgets all observations
+        void Reset();
+        // writes state to checkpoint
+        void Serialize(CheckpointWriter& writer) const;
+        // reads state written by Serialize; returns false, if the state is not valid
+        bool Deserialize(CheckpointReader& reader);
+
+        // retrieves number of observations
+        uint64_t GetCount() const;
+        // retrieves mean of observations
+        double GetMean() const;
+        // retrieves sample variance
+        double GetVariance() const;
+        // retrieves sample standard deviation
+        double GetStdDev() const;
+        // retrieves minimum observed value
+        double GetMin() const;
+        // retrieves maximum observed value
+        double GetMax() const;
+        // retrieves half width of confidence interval of mean for given quantile of normal distribution
+        double GetConfidenceHalfWidth(double z = 1.96) const;
+
+    private:
+        // number of observations
+        uint64_t m_count;
+        // mean of observations
+        double m_mean;
+        // sum of squared differences from mean
+        double m_m2;
+        // minimum observed value
+        double m_min;
+        // maximum observed value
+        double m_max;
+};
@@ -0,0 +1,159 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "ThreadPool.h"
+
+// pool of current worker thread (nullptr for other threads)
+static thread_local const ThreadPool* _currentPool = nullptr;
+// index of current worker thread within its pool
+static thread_local size_t _currentWorkerIndex = ThreadPool_NoWorker;
+
+ThreadPool::ThreadPool(size_t threadCount)
+    : m_queuedCount(0), m_pendingCount(0), m_sleepingCount(0), m_waitingCount(0), m_nextQueue(0), m_stopping(false)
+{
+    if (threadCount == 0)
+        threadCount = std::thread::hardware_concurrency();
+    if (threadCount == 0)
+        threadCount = 1;
+
+    for (size_t i = 0; i < threadCount; i++)
+        m_queues.emplace_back(new WorkerQueue());
+
+    // the queues must exist before any worker starts stealing
+    for (size_t i = 0; i < threadCount; i++)
+        m_threads.emplace_back(&ThreadPool::WorkerLoop, this, i);
+}
+
+ThreadPool::~ThreadPool()
+{
+    Wait();
+
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_stopping = true;
+    }
+    m_workAvailable.notify_all();
+
+    for (auto& thread : m_threads)
+        thread.join();
+}
+
+size_t ThreadPool::GetThreadCount() const
+{
+    return m_threads.size();
+}
+
+size_t ThreadPool::GetCurrentWorkerIndex() const
+{
+    return (_currentPool == this) ? _currentWorkerIndex : ThreadPool_NoWorker;
+}
+
+void ThreadPool::Submit(Task task)
+{
+    size_t index = GetCurrentWorkerIndex();
+    if (index == ThreadPool_NoWorker)
+        index = m_nextQueue++ % m_queues.size();
+
+    // the counters are increased before the task is queued, so the task could not be taken (and the counters
+    // decreased) sooner
+    m_pendingCount.fetch_add(1, std::memory_order_relaxed);
+    m_queuedCount.fetch_add(1, std::memory_order_seq_cst);
+
+    {
+        std::lock_guard<std::mutex> lock(m_queues[index]->mutex);
+        m_queues[index]->tasks.push_back(std::move(task));
+    }
+
+    // the worker going to sleep announces itself before it checks the queued count, so either it sees the task, or
+    // this thread sees the worker (both accesses are sequentially consistent); the lock makes sure, that the worker
+    // either did not check the count yet, or already waits for the notification
+    if (m_sleepingCount.load(std::memory_order_seq_cst) > 0)
+    {
+        std::lock_guard<std::mutex> lock(m_stateMutex);
+        m_workAvailable.notify_one();
+    }
+}
+
+void ThreadPool::Wait()
+{
+    if (m_pendingCount.load(std::memory_order_acquire) == 0)
+        return;
+
+    m_waitingCount.fetch_add(1, std::memory_order_seq_cst);
+    {
+        std::unique_lock<std::mutex> lock(m_stateMutex);
+        m_allDone.wait(lock, [this]() { return m_pendingCount.load(std::memory_order_seq_cst) == 0; });
+    }
+    m_waitingCount.fetch_sub(1, std::memory_order_relaxed);
+}
+
+bool ThreadPool::TakeTask(size_t index, Task& task)
+{
+    // own queue first, the most recent task
+    {
+        WorkerQueue& own = *m_queues[index];
+        std::lock_guard<std::mutex> lock(own.mutex);
+        if (!own.tasks.empty())
+        {
+            task = std::move(own.tasks.back());
+            own.tasks.pop_back();
+            m_queuedCount--;
+            return true;
+        }
+    }
+
+    // steal the oldest task of other workers, starting with the next one, so the thieves spread over the queues
+    for (size_t i = 1; i < m_queues.size(); i++)
+    {
+        WorkerQueue& victim = *m_queues[(index + i) % m_queues.size()];
+        std::lock_guard<std::mutex> lock(victim.mutex);
+        if (!victim.tasks.empty())
+        {
+            task = std::move(victim.tasks.front());
+            victim.tasks.pop_front();
+            m_queuedCount--;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ThreadPool::WorkerLoop(size_t index)
+{
+    _currentPool = this;
+    _currentWorkerIndex = index;
+
+    Task task;
+    while (true)
+    {
+        if (TakeTask(index, task))
+        {
+            task();
+            task = nullptr;
+
+            // the same handshake as with sleeping workers (see Submit)
+            if (m_pendingCount.fetch_sub(1, std::memory_order_seq_cst) == 1 && m_waitingCount.load(std::memory_order_seq_cst) > 0)
+            {
+                std::lock_guard<std::mutex> lock(m_stateMutex);
+                m_allDone.notify_all();
+            }
+            continue;
+        }
+
+        m_sleepingCount.fetch_add(1, std::memory_order_seq_cst);
+        bool stop;
+        {
+            std::unique_lock<std::mutex> lock(m_stateMutex);
+            m_workAvailable.wait(lock, [this]() { return m_stopping || m_queuedCount.load(std::memory_order_seq_cst) > 0; });
+            stop = m_stopping && m_queuedCount.load(std::memory_order_relaxed) == 0;
+        }
+        m_sleepingCount.fetch_sub(1, std::memory_order_relaxed);
+
+        if (stop)
+            break;
+    }
+}
@@ -0,0 +1,93 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstddef>
+#include <functional>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+
+// worker index returned for threads, that are not workers of the pool
+constexpr size_t ThreadPool_NoWorker = static_cast<size_t>(-1);
+
+/*
+ * Pool of worker threads with work stealing
+ *
+ * Every worker has its own task queue; tasks submitted from a worker go to its own queue and are taken in LIFO order
+ * (the data are likely still in cache), tasks submitted from outside are distributed to queues round-robin. A worker
+ * with empty queue steals the oldest task of other workers, so the load is balanced even with uneven tasks
+ */
+class ThreadPool
+{
+    public:
+        using Task = std::function<void()>;
+
+        // creates pool with given number of workers; 0 stands for the number of hardware threads
+        explicit ThreadPool(size_t threadCount = 0);
+        // waits for all submitted tasks and stops the workers
+        ~ThreadPool();
+
+        ThreadPool(ThreadPool const&) = delete;
+        ThreadPool& operator=(ThreadPool const&) = delete;
+
+        // submits task for execution
+        void Submit(Task task);
+        // waits until all submitted tasks (including the tasks they submit) are finished
+        void Wait();
+
+        // retrieves number of workers
+        size_t GetThreadCount() const;
+        // retrieves index of worker calling this method; ThreadPool_NoWorker, if not called from worker of this pool
+        size_t GetCurrentWorkerIndex() const;
+
+    protected:
+        /*
+         * Task queue of single worker
+         */
+        struct WorkerQueue
+        {
+            // guards the tasks; locked by the owner and by thieves
+            std::mutex mutex;
+            // queued tasks; the owner takes from back, thieves from front
+            std::deque<Task> tasks;
+        };
+
+        // worker thread main loop
+        void WorkerLoop(size_t index);
+        // takes task from own queue or steals one from other queues; returns false, if there's no task
+        bool TakeTask(size_t index, Task& task);
+
+        // task queues, one per worker
+        std::vector<std::unique_ptr<WorkerQueue>> m_queues;
+        // worker threads
+        std::vector<std::thread> m_threads;
+
+        // guards sleeping and waking of workers and waiters; the counters are atomic, so the lock is taken only
+        // by those who go to sleep and by those who wake them
+        std::mutex m_stateMutex;
+        // signalled when a task is queued or the pool is stopping
+        std::condition_variable m_workAvailable;
+        // signalled when all tasks are finished
+        std::condition_variable m_allDone;
+        // number of queued tasks, that were not taken yet
+        std::atomic<size_t> m_queuedCount;
+        // number of submitted tasks, that were not finished yet
+        std::atomic<size_t> m_pendingCount;
+        // number of workers sleeping (or going to sleep) on m_workAvailable
+        std::atomic<size_t> m_sleepingCount;
+        // number of threads waiting (or going to wait) on m_allDone
+        std::atomic<size_t> m_waitingCount;
+        // queue for next task submitted from outside
+        std::atomic<size_t> m_nextQueue;
+        // are the workers stopping? (guarded by m_stateMutex)
+        bool m_stopping;
+};
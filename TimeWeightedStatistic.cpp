@@ -0,0 +1,179 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "TimeWeightedStatistic.h"
+#include "Simulation.h"
+#include "CheckpointWriter.h"
+#include "CheckpointReader.h"
+
+#include <cmath>
+#include <algorithm>
+
+TimeWeightedStatistic::TimeWeightedStatistic(Simulation const* simulation)
+    : m_simulation(simulation), m_started(false), m_value(0.0), m_lastTime(0), m_duration(0), m_mean(0.0), m_m2(0.0),
+      m_min(0.0), m_max(0.0)
+{
+    //
+}
+
+void TimeWeightedStatistic::Set(double value)
+{
+    Set(value, m_simulation ? m_simulation->GetSimulationTime() : m_lastTime);
+}
+
+void TimeWeightedStatistic::Set(double value, simtime_t time)
+{
+    // statistics are shared by objects, so they could not be updated during parallel phase
+    assert(!Simulation::IsDeferring());
+
+    if (!m_started)
+    {
+        m_started = true;
+        m_lastTime = time;
+        m_min = value;
+        m_max = value;
+    }
+    else
+    {
+        Accumulate(time);
+        m_min = std::min(m_min, value);
+        m_max = std::max(m_max, value);
+    }
+
+    m_value = value;
+}
+
+void TimeWeightedStatistic::Close()
+{
+    Close(m_simulation ? m_simulation->GetSimulationTime() : m_lastTime);
+}
+
+void TimeWeightedStatistic::Close(simtime_t time)
+{
+    if (m_started)
+        Accumulate(time);
+}
+
+void TimeWeightedStatistic::Merge(TimeWeightedStatistic const& other)
+{
+    if (!other.m_started)
+        return;
+
+    if (!m_started)
+    {
+        Simulation const* simulation = m_simulation;
+        *this = other;
+        m_simulation = simulation;
+        return;
+    }
+
+    m_min = std::min(m_min, other.m_min);
+    m_max = std::max(m_max, other.m_max);
+
+    if (other.m_duration == 0)
+        return;
+
+    // weighted variant of parallel Welford's method
+    const double weight = static_cast<double>(m_duration);
+    const double otherWeight = static_cast<double>(other.m_duration);
+    const double total = weight + otherWeight;
+    const double delta = other.m_mean - m_mean;
+
+    m_mean += delta * otherWeight / total;
+    m_m2 += other.m_m2 + delta * delta * weight * otherWeight / total;
+    m_duration += other.m_duration;
+}
+
+void TimeWeightedStatistic::Reset()
+{
+    Reset(m_simulation ? m_simulation->GetSimulationTime() : m_lastTime);
+}
+
+void TimeWeightedStatistic::Reset(simtime_t time)
+{
+    m_lastTime = time;
+    m_duration = 0;
+    m_mean = 0.0;
+    m_m2 = 0.0;
+    m_min = m_value;
+    m_max = m_value;
+}
+
+void TimeWeightedStatistic::Serialize(CheckpointWriter& writer) const
+{
+    writer.WriteBool(m_started);
+    writer.WriteDouble(m_value);
+    writer.WriteVarUInt(m_lastTime);
+    writer.WriteVarUInt(m_duration);
+    writer.WriteDouble(m_mean);
+    writer.WriteDouble(m_m2);
+    writer.WriteDouble(m_min);
+    writer.WriteDouble(m_max);
+}
+
+bool TimeWeightedStatistic::Deserialize(CheckpointReader& reader)
+{
+    m_started = reader.ReadBool();
+    m_value = reader.ReadDouble();
+    m_lastTime = reader.ReadVarUInt();
+    m_duration = reader.ReadVarUInt();
+    m_mean = reader.ReadDouble();
+    m_m2 = reader.ReadDouble();
+    m_min = reader.ReadDouble();
+    m_max = reader.ReadDouble();
+
+    return reader.IsGood();
+}
+
+double TimeWeightedStatistic::GetValue() const
+{
+    return m_value;
+}
+
+simtime_t TimeWeightedStatistic::GetDuration() const
+{
+    return m_duration;
+}
+
+double TimeWeightedStatistic::GetMean() const
+{
+    return m_mean;
+}
+
+double TimeWeightedStatistic::GetVariance() const
+{
+    return (m_duration > 0) ? m_m2 / static_cast<double>(m_duration) : 0.0;
+}
+
+double TimeWeightedStatistic::GetStdDev() const
+{
+    return std::sqrt(GetVariance());
+}
+
+double TimeWeightedStatistic::GetMin() const
+{
+    return m_min;
+}
+
+double TimeWeightedStatistic::GetMax() const
+{
+    return m_max;
+}
+
+void TimeWeightedStatistic::Accumulate(simtime_t time)
+{
+    if (time <= m_lastTime)
+        return;
+
+    const double weight = static_cast<double>(time - m_lastTime);
+    m_duration += time - m_lastTime;
+    m_lastTime = time;
+
+    // weighted Welford's method (West)
+    const double delta = m_value - m_mean;
+    m_mean += delta * weight / static_cast<double>(m_duration);
+    m_m2 += weight * delta * (m_value - m_mean);
+}
@@ -0,0 +1,83 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include "Types.h"
+
+class CheckpointWriter;
+class CheckpointReader;
+
+/*
+ * Streaming time-weighted statistic of piecewise constant value (e.g. queue length, number of busy servers)
+ *
+ * Every value is weighted by the time it was held; the time is taken from simulation (or passed explicitly).
+ * Mean and variance are updated by weighted Welford's method (West), so the statistic takes constant memory;
+ * statistics of replications could be merged
+ */
+class TimeWeightedStatistic
+{
+    public:
+        TimeWeightedStatistic(Simulation const* simulation = nullptr);
+
+        // sets new value at current simulation time
+        void Set(double value);
+        // sets new value at given time; times must not decrease
+        void Set(double value, simtime_t time);
+        // accounts the current value up to current simulation time (e.g. at the end of run)
+        void Close();
+        // accounts the current value up to given time
+        void Close(simtime_t time);
+        // merges statistic of other run (e.g. other replication); both statistics should be closed
+        void Merge(TimeWeightedStatistic const& other);
+        // forgets accounted history (e.g. after warm-up period), keeps the current value from current simulation time
+        void Reset();
+        // forgets accounted history, keeps the current value from given time
+        void Reset(simtime_t time);
+        // writes state to checkpoint
+        void Serialize(CheckpointWriter& writer) const;
+        // reads state written by Serialize; the statistic keeps its simulation; returns false, if the state is not valid
+        bool Deserialize(CheckpointReader& reader);
+
+        // retrieves current value
+        double GetValue() const;
+        // retrieves total accounted time
+        simtime_t GetDuration() const;
+        // retrieves time-weighted mean over accounted time
+        double GetMean() const;
+        // retrieves time-weighted variance over accounted time
+        double GetVariance() const;
+        // retrieves time-weighted standard deviation over accounted time
+        double GetStdDev() const;
+        // retrieves minimum value held
+        double GetMin() const;
+        // retrieves maximum value held
+        double GetMax() const;
+
+    protected:
+        // accounts the current value from last update to given time
+        void Accumulate(simtime_t time);
+
+    private:
+        // simulation providing current time (nullptr, if the times are passed explicitly)
+        Simulation const* m_simulation;
+        // was any value set?
+        bool m_started;
+        // current value
+        double m_value;
+        // time of last update
+        simtime_t m_lastTime;
+        // total accounted time
+        simtime_t m_duration;
+        // time-weighted mean
+        double m_mean;
+        // time-weighted sum of squared differences from mean
+        double m_m2;
+        // minimum value held
+        double m_min;
+        // maximum value held
+        double m_max;
+};
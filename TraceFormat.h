@@ -0,0 +1,128 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+#include "Types.h"
+
+/*
+ * Binary event trace file layout (all values are stored in native byte order):
+ *
+ *   file header | chunk header, records | chunk header, records | ... | chunk index
+ *
+ * Records are fixed-width, so they could be accessed randomly. Every chunk header describes its records (count,
+ * time range, classes present), so the reader could skip chunks not matching the filter. The chunk index is written
+ * when the trace is closed and the file header points to it; if the writer did not finish properly, the reader
+ * rebuilds the index by walking the chunk headers
+ */
+
+// magic value of trace file header
+constexpr char TraceFile_Magic[8] = { 'S', 'I', 'M', 'T', 'R', 'A', 'C', 'E' };
+// version of trace file format
+constexpr uint32_t TraceFile_Version = 1;
+// magic value of chunk header
+constexpr uint32_t TraceChunk_Magic = 0x4B4E4843;  // "CHNK"
+// default number of records in a single chunk
+constexpr uint32_t TraceChunk_DefaultCapacity = 16384;
+
+/*
+ * Kind of traced event
+ */
+enum class TraceEventKind : uint8_t
+{
+    FIRED,              // object was fired
+    ADDED,              // object was added to simulation
+    REMOVED             // object was removed from simulation
+};
+
+// number of traced event kinds
+constexpr uint32_t TraceEventKindCount = 3;
+
+/*
+ * Single trace record
+ */
+struct TraceRecord
+{
+    // simulation time
+    simtime_t time;
+    // object GUID
+    uint64_t guid;
+    // object class
+    uint32_t objectClass;
+    // object type (numeric value of SimulationObjectType)
+    uint8_t objectType;
+    // event kind (numeric value of TraceEventKind)
+    uint8_t kind;
+    uint16_t reserved;
+};
+
+static_assert(sizeof(TraceRecord) == 24, "TraceRecord is expected to be 24 bytes long");
+
+/*
+ * Trace file header
+ */
+struct TraceFileHeader
+{
+    // magic value (TraceFile_Magic)
+    char magic[8];
+    // format version
+    uint32_t version;
+    // size of a single record
+    uint32_t recordSize;
+    // maximum number of records in a single chunk
+    uint32_t chunkCapacity;
+    // number of chunks (valid only if the index is present)
+    uint32_t chunkCount;
+    // number of records (valid only if the index is present)
+    uint64_t recordCount;
+    // file offset of chunk index; 0 if the trace was not closed properly
+    uint64_t indexOffset;
+};
+
+static_assert(sizeof(TraceFileHeader) == 40, "TraceFileHeader is expected to be 40 bytes long");
+
+/*
+ * Header of trace chunk
+ */
+struct TraceChunkHeader
+{
+    // magic value (TraceChunk_Magic)
+    uint32_t magic;
+    // number of records in chunk
+    uint32_t recordCount;
+    // time of the first record
+    simtime_t firstTime;
+    // time of the last record
+    simtime_t lastTime;
+    // mask of classes present in chunk; bit (class % 64) is set for every record
+    uint64_t classMask;
+};
+
+static_assert(sizeof(TraceChunkHeader) == 32, "TraceChunkHeader is expected to be 32 bytes long");
+
+/*
+ * Entry of chunk index
+ */
+struct TraceIndexEntry
+{
+    // file offset of chunk header
+    uint64_t offset;
+    // index of the first record of chunk within the whole trace
+    uint64_t firstRecord;
+    // copy of chunk header
+    TraceChunkHeader header;
+};
+
+static_assert(sizeof(TraceIndexEntry) == 48, "TraceIndexEntry is expected to be 48 bytes long");
+
+// retrieves bit of class within chunk class mask
+inline uint64_t TraceChunk_ClassBit(uint32_t objectClass)
+{
+    return 1ULL << (objectClass % 64);
+}
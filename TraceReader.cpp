@@ -0,0 +1,283 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "TraceReader.h"
+
+#include <cstring>
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+TraceReader::TraceReader()
+    : m_data(nullptr), m_size(0), m_recordCount(0), m_indexRebuilt(false)
+{
+#ifdef _WIN32
+    m_fileHandle = INVALID_HANDLE_VALUE;
+    m_mappingHandle = nullptr;
+#endif
+}
+
+TraceReader::~TraceReader()
+{
+    Close();
+}
+
+#ifdef _WIN32
+
+bool TraceReader::MapFile(std::string const& path)
+{
+    m_fileHandle = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (m_fileHandle == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(m_fileHandle, &fileSize) || fileSize.QuadPart == 0)
+    {
+        UnmapFile();
+        return false;
+    }
+
+    m_mappingHandle = CreateFileMappingA(m_fileHandle, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (!m_mappingHandle)
+    {
+        UnmapFile();
+        return false;
+    }
+
+    m_data = static_cast<const unsigned char*>(MapViewOfFile(m_mappingHandle, FILE_MAP_READ, 0, 0, 0));
+    if (!m_data)
+    {
+        UnmapFile();
+        return false;
+    }
+
+    m_size = static_cast<size_t>(fileSize.QuadPart);
+    return true;
+}
+
+void TraceReader::UnmapFile()
+{
+    if (m_data)
+        UnmapViewOfFile(m_data);
+    if (m_mappingHandle)
+        CloseHandle(m_mappingHandle);
+    if (m_fileHandle != INVALID_HANDLE_VALUE)
+        CloseHandle(m_fileHandle);
+
+    m_data = nullptr;
+    m_size = 0;
+    m_mappingHandle = nullptr;
+    m_fileHandle = INVALID_HANDLE_VALUE;
+}
+
+#else
+
+bool TraceReader::MapFile(std::string const& path)
+{
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd < 0)
+        return false;
+
+    struct stat fileStat;
+    if (fstat(fd, &fileStat) != 0 || fileStat.st_size == 0)
+    {
+        close(fd);
+        return false;
+    }
+
+    void* data = mmap(nullptr, static_cast<size_t>(fileStat.st_size), PROT_READ, MAP_SHARED, fd, 0);
+    // the mapping stays valid after closing the descriptor
+    close(fd);
+
+    if (data == MAP_FAILED)
+        return false;
+
+    m_data = static_cast<const unsigned char*>(data);
+    m_size = static_cast<size_t>(fileStat.st_size);
+    return true;
+}
+
+void TraceReader::UnmapFile()
+{
+    if (m_data)
+        munmap(const_cast<unsigned char*>(m_data), m_size);
+
+    m_data = nullptr;
+    m_size = 0;
+}
+
+#endif
+
+bool TraceReader::Open(std::string const& path)
+{
+    Close();
+
+    if (!MapFile(path))
+        return false;
+
+    if (m_size < sizeof(TraceFileHeader))
+    {
+        Close();
+        return false;
+    }
+
+    std::memcpy(&m_header, m_data, sizeof(m_header));
+    if (std::memcmp(m_header.magic, TraceFile_Magic, sizeof(m_header.magic)) != 0 || m_header.version != TraceFile_Version
+        || m_header.recordSize != sizeof(TraceRecord))
+    {
+        Close();
+        return false;
+    }
+
+    if (!LoadIndex())
+    {
+        Close();
+        return false;
+    }
+
+    return true;
+}
+
+void TraceReader::Close()
+{
+    UnmapFile();
+
+    m_index.clear();
+    m_recordCount = 0;
+    m_indexRebuilt = false;
+}
+
+bool TraceReader::IsOpen() const
+{
+    return m_data != nullptr;
+}
+
+bool TraceReader::IsIndexRebuilt() const
+{
+    return m_indexRebuilt;
+}
+
+bool TraceReader::LoadIndex()
+{
+    // index written by closed trace
+    if (m_header.indexOffset != 0)
+    {
+        const uint64_t indexSize = static_cast<uint64_t>(m_header.chunkCount) * sizeof(TraceIndexEntry);
+        if (m_header.indexOffset < sizeof(TraceFileHeader) || m_header.indexOffset + indexSize > m_size)
+            return false;
+
+        m_index.resize(m_header.chunkCount);
+        if (indexSize > 0)
+            std::memcpy(m_index.data(), m_data + m_header.indexOffset, static_cast<size_t>(indexSize));
+        m_recordCount = m_header.recordCount;
+        m_indexRebuilt = false;
+    }
+    else
+    {
+        // the trace was not closed - walk the chunk headers; incomplete chunk at the end is ignored
+        uint64_t offset = sizeof(TraceFileHeader);
+        uint64_t recordCount = 0;
+
+        while (offset + sizeof(TraceChunkHeader) <= m_size)
+        {
+            TraceIndexEntry entry;
+            std::memcpy(&entry.header, m_data + offset, sizeof(entry.header));
+            if (entry.header.magic != TraceChunk_Magic || entry.header.recordCount == 0)
+                break;
+
+            const uint64_t chunkSize = sizeof(TraceChunkHeader) + static_cast<uint64_t>(entry.header.recordCount) * sizeof(TraceRecord);
+            if (offset + chunkSize > m_size)
+                break;
+
+            entry.offset = offset;
+            entry.firstRecord = recordCount;
+            m_index.push_back(entry);
+
+            offset += chunkSize;
+            recordCount += entry.header.recordCount;
+        }
+
+        m_recordCount = recordCount;
+        m_indexRebuilt = true;
+    }
+
+    // validate chunks, so the records could be accessed without further checks
+    uint64_t recordCount = 0;
+    for (auto& entry : m_index)
+    {
+        const uint64_t chunkSize = sizeof(TraceChunkHeader) + static_cast<uint64_t>(entry.header.recordCount) * sizeof(TraceRecord);
+        if (entry.header.magic != TraceChunk_Magic || entry.firstRecord != recordCount || entry.offset + chunkSize > m_size)
+            return false;
+
+        recordCount += entry.header.recordCount;
+    }
+
+    return recordCount == m_recordCount;
+}
+
+uint64_t TraceReader::GetRecordCount() const
+{
+    return m_recordCount;
+}
+
+size_t TraceReader::GetChunkCount() const
+{
+    return m_index.size();
+}
+
+TraceIndexEntry const& TraceReader::GetChunk(size_t chunk) const
+{
+    return m_index[chunk];
+}
+
+const TraceRecord* TraceReader::GetChunkRecords(size_t chunk) const
+{
+    return reinterpret_cast<const TraceRecord*>(m_data + m_index[chunk].offset + sizeof(TraceChunkHeader));
+}
+
+size_t TraceReader::FindChunk(uint64_t index) const
+{
+    if (index >= m_recordCount)
+        return m_index.size();
+
+    // the last chunk starting at or before the index
+    auto itr = std::upper_bound(m_index.begin(), m_index.end(), index, [](uint64_t value, TraceIndexEntry const& entry) {
+        return value < entry.firstRecord;
+    });
+
+    return static_cast<size_t>(itr - m_index.begin()) - 1;
+}
+
+TraceRecord const& TraceReader::GetRecord(uint64_t index) const
+{
+    const size_t chunk = FindChunk(index);
+    return GetChunkRecords(chunk)[index - m_index[chunk].firstRecord];
+}
+
+uint64_t TraceReader::LowerBound(simtime_t time) const
+{
+    // the first chunk, that ends at or after given time
+    auto itr = std::lower_bound(m_index.begin(), m_index.end(), time, [](TraceIndexEntry const& entry, simtime_t value) {
+        return entry.header.lastTime < value;
+    });
+
+    if (itr == m_index.end())
+        return m_recordCount;
+
+    const TraceRecord* records = GetChunkRecords(static_cast<size_t>(itr - m_index.begin()));
+    const TraceRecord* found = std::lower_bound(records, records + itr->header.recordCount, time, [](TraceRecord const& record, simtime_t value) {
+        return record.time < value;
+    });
+
+    return itr->firstRecord + static_cast<uint64_t>(found - records);
+}
@@ -0,0 +1,134 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <string>
+#include <vector>
+
+#include "TraceFormat.h"
+
+/*
+ * Filter of trace records
+ */
+struct TraceFilter
+{
+    // lowest time of record (inclusive)
+    simtime_t timeFrom = 0;
+    // highest time of record (inclusive)
+    simtime_t timeTo = std::numeric_limits<simtime_t>::max();
+    // filter by object class?
+    bool filterClass = false;
+    // object class of record (if filterClass is set)
+    uint32_t objectClass = 0;
+    // mask of event kinds; bit (1 << kind) is set for every accepted kind
+    uint32_t kindMask = (1U << TraceEventKindCount) - 1;
+
+    // does the record match filter?
+    bool Matches(TraceRecord const& record) const
+    {
+        return record.time >= timeFrom && record.time <= timeTo && (!filterClass || record.objectClass == objectClass)
+            && ((kindMask >> record.kind) & 1) != 0;
+    }
+
+    // could the chunk contain records matching filter?
+    bool MayMatch(TraceChunkHeader const& chunk) const
+    {
+        return chunk.lastTime >= timeFrom && chunk.firstTime <= timeTo && (!filterClass || (chunk.classMask & TraceChunk_ClassBit(objectClass)) != 0);
+    }
+};
+
+/*
+ * Reader of binary event trace
+ *
+ * The file is memory-mapped, so the records are accessed in place, without reading the whole file. Records are
+ * ordered by time, so the time range lookup is a binary search; chunks not matching the filter are skipped using
+ * their headers
+ */
+class TraceReader
+{
+    public:
+        TraceReader();
+        virtual ~TraceReader();
+
+        TraceReader(TraceReader const&) = delete;
+        TraceReader& operator=(TraceReader const&) = delete;
+
+        // maps trace file; returns false, if the file could not be mapped or is not a valid trace
+        bool Open(std::string const& path);
+        // unmaps trace file
+        void Close();
+        // is the trace file open?
+        bool IsOpen() const;
+        // was the chunk index rebuilt (i.e. the trace was not closed properly)?
+        bool IsIndexRebuilt() const;
+
+        // retrieves number of records
+        uint64_t GetRecordCount() const;
+        // retrieves number of chunks
+        size_t GetChunkCount() const;
+        // retrieves index entry of chunk
+        TraceIndexEntry const& GetChunk(size_t chunk) const;
+        // retrieves records of chunk
+        const TraceRecord* GetChunkRecords(size_t chunk) const;
+
+        // retrieves record by its index within trace
+        TraceRecord const& GetRecord(uint64_t index) const;
+        // retrieves index of the first record with time equal or greater than given time
+        uint64_t LowerBound(simtime_t time) const;
+
+        // calls callback(TraceRecord const&) for every record matching filter, in trace order
+        template<typename F>
+        void ForEach(TraceFilter const& filter, F callback) const
+        {
+            for (size_t chunk = FindChunk(LowerBound(filter.timeFrom)); chunk < m_index.size(); chunk++)
+            {
+                TraceChunkHeader const& header = m_index[chunk].header;
+                if (header.firstTime > filter.timeTo)
+                    break;
+                if (!filter.MayMatch(header))
+                    continue;
+
+                const TraceRecord* records = GetChunkRecords(chunk);
+                for (uint32_t i = 0; i < header.recordCount; i++)
+                {
+                    if (filter.Matches(records[i]))
+                        callback(records[i]);
+                }
+            }
+        }
+
+    protected:
+        // maps file to memory; returns false on failure
+        bool MapFile(std::string const& path);
+        // unmaps file
+        void UnmapFile();
+        // loads chunk index from file, or rebuilds it from chunk headers; returns false, if the file is corrupted
+        bool LoadIndex();
+        // retrieves chunk containing record with given index (chunk count if the index is out of range)
+        size_t FindChunk(uint64_t index) const;
+
+    private:
+        // mapped file data
+        const unsigned char* m_data;
+        // size of mapped file
+        size_t m_size;
+        // file header
+        TraceFileHeader m_header;
+        // chunk index
+        std::vector<TraceIndexEntry> m_index;
+        // number of records
+        uint64_t m_recordCount;
+        // was the index rebuilt?
+        bool m_indexRebuilt;
+
+#ifdef _WIN32
+        // file handle
+        void* m_fileHandle;
+        // file mapping handle
+        void* m_mappingHandle;
+#endif
+};
@@ -0,0 +1,130 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#include "TraceWriter.h"
+
+#include <cstring>
+
+TraceWriter::TraceWriter()
+    : m_chunkCapacity(TraceChunk_DefaultCapacity), m_chunkClassMask(0), m_writtenCount(0), m_offset(0)
+{
+    //
+}
+
+TraceWriter::~TraceWriter()
+{
+    Close();
+}
+
+bool TraceWriter::Open(std::string const& path, uint32_t chunkCapacity)
+{
+    Close();
+
+    m_file.open(path, std::ios::binary | std::ios::trunc);
+    if (!m_file.is_open())
+        return false;
+
+    m_chunkCapacity = (chunkCapacity > 0) ? chunkCapacity : TraceChunk_DefaultCapacity;
+    m_chunk.clear();
+    m_chunk.reserve(m_chunkCapacity);
+    m_chunkClassMask = 0;
+    m_index.clear();
+    m_writtenCount = 0;
+
+    // the header is rewritten with index location when the trace is closed
+    TraceFileHeader header;
+    std::memcpy(header.magic, TraceFile_Magic, sizeof(header.magic));
+    header.version = TraceFile_Version;
+    header.recordSize = sizeof(TraceRecord);
+    header.chunkCapacity = m_chunkCapacity;
+    header.chunkCount = 0;
+    header.recordCount = 0;
+    header.indexOffset = 0;
+
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_offset = sizeof(header);
+
+    return m_file.good();
+}
+
+void TraceWriter::Close()
+{
+    if (!m_file.is_open())
+        return;
+
+    WriteChunk();
+
+    // write chunk index at the end of file, and point to it from header
+    const uint64_t indexOffset = m_offset;
+    if (!m_index.empty())
+        m_file.write(reinterpret_cast<const char*>(m_index.data()), m_index.size() * sizeof(TraceIndexEntry));
+
+    TraceFileHeader header;
+    std::memcpy(header.magic, TraceFile_Magic, sizeof(header.magic));
+    header.version = TraceFile_Version;
+    header.recordSize = sizeof(TraceRecord);
+    header.chunkCapacity = m_chunkCapacity;
+    header.chunkCount = static_cast<uint32_t>(m_index.size());
+    header.recordCount = m_writtenCount;
+    header.indexOffset = indexOffset;
+
+    m_file.seekp(0);
+    m_file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    m_file.close();
+
+    m_index.clear();
+}
+
+bool TraceWriter::IsOpen() const
+{
+    return m_file.is_open();
+}
+
+void TraceWriter::WriteChunk()
+{
+    if (m_chunk.empty())
+        return;
+
+    // nowhere to write
+    if (!m_file.is_open())
+    {
+        m_chunk.clear();
+        m_chunkClassMask = 0;
+        return;
+    }
+
+    TraceIndexEntry entry;
+    entry.offset = m_offset;
+    entry.firstRecord = m_writtenCount;
+    entry.header.magic = TraceChunk_Magic;
+    entry.header.recordCount = static_cast<uint32_t>(m_chunk.size());
+    entry.header.firstTime = m_chunk.front().time;
+    entry.header.lastTime = m_chunk.back().time;
+    entry.header.classMask = m_chunkClassMask;
+
+    m_file.write(reinterpret_cast<const char*>(&entry.header), sizeof(entry.header));
+    m_file.write(reinterpret_cast<const char*>(m_chunk.data()), m_chunk.size() * sizeof(TraceRecord));
+
+    m_offset += sizeof(entry.header) + m_chunk.size() * sizeof(TraceRecord);
+    m_writtenCount += m_chunk.size();
+    m_index.push_back(entry);
+
+    m_chunk.clear();
+    m_chunkClassMask = 0;
+}
+
+void TraceWriter::Flush()
+{
+    WriteChunk();
+
+    if (m_file.is_open())
+        m_file.flush();
+}
+
+uint64_t TraceWriter::GetRecordCount() const
+{
+    return m_writtenCount + m_chunk.size();
+}
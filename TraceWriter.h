@@ -0,0 +1,72 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <fstream>
+#include <string>
+#include <vector>
+#include <memory>
+
+#include "TraceFormat.h"
+
+/*
+ * Writer of binary event trace
+ *
+ * Records are collected in memory and written to file by whole chunks; the chunk index is kept in memory and written
+ * when the trace is closed. See TraceFormat.h for file layout
+ */
+class TraceWriter
+{
+    public:
+        TraceWriter();
+        virtual ~TraceWriter();
+
+        // creates trace file; returns false, if the file could not be created
+        bool Open(std::string const& path, uint32_t chunkCapacity = TraceChunk_DefaultCapacity);
+        // writes pending records and chunk index, and closes the file
+        void Close();
+        // is the trace file open?
+        bool IsOpen() const;
+
+        // appends record to trace
+        void Record(TraceEventKind kind, simtime_t time, uint64_t guid, uint32_t objectType, uint32_t objectClass)
+        {
+            if (m_chunk.size() == m_chunkCapacity)
+                WriteChunk();
+
+            m_chunk.push_back({ time, guid, objectClass, static_cast<uint8_t>(objectType), static_cast<uint8_t>(kind), 0 });
+            m_chunkClassMask |= TraceChunk_ClassBit(objectClass);
+        }
+
+        // writes pending records (as a chunk) and flushes the file
+        void Flush();
+
+        // retrieves number of records written so far
+        uint64_t GetRecordCount() const;
+
+    protected:
+        // writes pending records as a chunk
+        void WriteChunk();
+
+    private:
+        // output file
+        std::ofstream m_file;
+        // maximum number of records in chunk
+        uint32_t m_chunkCapacity;
+        // pending records
+        std::vector<TraceRecord> m_chunk;
+        // class mask of pending records
+        uint64_t m_chunkClassMask;
+        // index of written chunks
+        std::vector<TraceIndexEntry> m_index;
+        // number of records in written chunks
+        uint64_t m_writtenCount;
+        // current file offset
+        uint64_t m_offset;
+};
+
+using TraceWriterPtr = std::shared_ptr<TraceWriter>;
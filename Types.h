@@ -8,6 +8,9 @@
 
 #include <memory>
 #include <list>
+#include <vector>
+#include <cstdint>
+#include <limits>
 
 // general
 
@@ -26,12 +29,55 @@ class Calendar;
 
 using CalendarPtr = std::shared_ptr<Calendar>;
 
+// handle of calendar entry, tracks position of scheduled object within calendar
+using CalendarHandle = uint32_t;
+
+// handle value of objects not present in any calendar
+constexpr CalendarHandle CalendarHandle_Invalid = std::numeric_limits<CalendarHandle>::max();
+
 // SimulationObject class and children
 
 class SimulationObject;
 
 using SimulationObjectPtr = std::shared_ptr<SimulationObject>;
 using SimulationObjectList = std::list<SimulationObjectPtr>;
+// batch of objects scheduled to the same time
+using SimulationBatch = std::vector<SimulationObjectPtr>;
+// selection of objects (e.g. event targets); non-owning, the objects are kept alive by simulation
+using SimulationObjectSelection = std::vector<SimulationObject*>;
+
+/*
+ * Read-only view of contiguous range of objects; does not own nor copy the objects, and it is valid only until
+ * the underlying container changes (i.e. until an object is added to or removed from simulation)
+ */
+class SimulationObjectView
+{
+    public:
+        using const_iterator = const SimulationObjectPtr*;
+
+        SimulationObjectView() : m_begin(nullptr), m_end(nullptr) { };
+        SimulationObjectView(std::vector<SimulationObjectPtr> const& objects) : m_begin(objects.data()), m_end(objects.data() + objects.size()) { };
+        SimulationObjectView(const_iterator first, const_iterator last) : m_begin(first), m_end(last) { };
+
+        const_iterator begin() const { return m_begin; }
+        const_iterator end() const { return m_end; }
+
+        size_t size() const { return static_cast<size_t>(m_end - m_begin); }
+        bool empty() const { return m_begin == m_end; }
+
+        SimulationObjectPtr const& operator[](size_t index) const { return m_begin[index]; }
+
+        // copies the viewed objects to list
+        explicit operator SimulationObjectList() const { return SimulationObjectList(m_begin, m_end); }
+
+    private:
+        const_iterator m_begin;
+        const_iterator m_end;
+};
 
 class SimProcess;
 class SimEvent;
+
+// ObjectRegistry class
+
+class ObjectRegistry;
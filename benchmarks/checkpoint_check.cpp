@@ -0,0 +1,372 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+/*
+ * Equivalence check of checkpoints and forks
+ *
+ * The model consists of cells (processes rescheduling themselves after random gap, changing indexed attribute, sending
+ * messages to their peers and terminating at random), an event affecting random cells selected by class and attribute,
+ * and a ticker with periodic schedule in second calendar; the cells report their gaps to a statistic. The model is run
+ * uninterrupted, and then run to the half of end time, written to checkpoint, restored in new simulation and run to
+ * the end. Then it's run to the half of end time again and forked; the forks and the original simulation are run
+ * to the end. This is done for both calendar engines; the digest of final state (objects, schedule, statistics) must be
+ * identical.
+ *
+ * Build (from this directory; the library sources are all .cpp files of parent directory and random/base_generator.cpp):
+ *   g++ -std=c++14 -O2 -pthread -I.. checkpoint_check.cpp $(find .. -maxdepth 1 -name '*.cpp') ../random/base_generator.cpp -o checkpoint_check
+ *
+ * Usage:
+ *   checkpoint_check [cells] [end time]
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdio>
+#include <cstdlib>
+
+#include "simlib.h"
+#include "random/exponential_generator.h"
+#include "random/uniform_generator.h"
+
+// checkpoint file written by the check (removed when done)
+static const char* _checkpointPath = "checkpoint_check.ckpt";
+
+// checkpoint type identifiers
+static const uint32_t _cellType = 1;
+static const uint32_t _stormType = 2;
+static const uint32_t _tickerType = 3;
+
+// number of forks
+static const size_t _forkCount = 3;
+
+// indexed attribute of cells
+static const uint32_t _phaseAttribute = 7;
+// number of storm events
+static const int _stormCount = 40;
+
+/*
+ * Cell; a process interacting with its peer
+ */
+class CheckCell : public SimProcess
+{
+    public:
+        CheckCell() : m_state(1), m_hits(0), m_runs(0), m_peerGUID(0), m_gap(1, 5)
+        {
+            //
+        };
+
+        void SeedRandomStreams(Simulation const& simulation) override
+        {
+            SimProcess::SeedRandomStreams(simulation);
+            SeedGenerator(m_gap, random_stream_user);
+        }
+
+        void SetPeer(uint64_t peerGUID)
+        {
+            m_peerGUID = peerGUID;
+        }
+
+        // changes state; called by storm event
+        void Disturb()
+        {
+            m_state += 17;
+        }
+
+        void Run() override
+        {
+            SimulationPtr simulation = GetSimulation();
+
+            m_runs++;
+
+            // the peer may be terminated already
+            SimulationObjectPtr peer = simulation->GetObjectByGUID(m_peerGUID);
+            m_state = m_state * 6364136223846793005ULL + 1 + (peer ? static_cast<CheckCell*>(peer.get())->m_state : 0);
+
+            SetAttribute(_phaseAttribute, static_cast<int64_t>(m_state % 3));
+
+            if (m_state % 11 == 0)
+                SendMessage(0, m_peerGUID, 2, 1, SimulationMessageData{ static_cast<int64_t>(m_state), 0, 0, 0 });
+
+            if (m_state % 53 == 0)
+            {
+                Terminate();
+                return;
+            }
+
+            const simtime_t gap = m_gap();
+            simulation->GetStatistics().GetTally("gap").Add(static_cast<double>(gap));
+            Schedule(simulation->GetMainCalendar(), gap, true);
+        }
+
+        void ReceiveMessage(SimulationMessage const& message) override
+        {
+            m_state ^= static_cast<uint64_t>(message.data[0]);
+        }
+
+        void ReceiveEvent(SimEvent&) override
+        {
+            m_hits++;
+        }
+
+        void Serialize(CheckpointWriter& writer) const override
+        {
+            writer.WriteVarUInt(m_state);
+            writer.WriteVarUInt(m_hits);
+            writer.WriteVarUInt(m_runs);
+            writer.WriteVarUInt(m_peerGUID);
+            writer.WriteGenerator(m_gap);
+        }
+
+        bool Deserialize(CheckpointReader& reader) override
+        {
+            m_state = reader.ReadVarUInt();
+            m_hits = reader.ReadVarUInt();
+            m_runs = reader.ReadVarUInt();
+            m_peerGUID = reader.ReadVarUInt();
+
+            return reader.ReadGenerator(m_gap);
+        }
+
+        uint64_t GetDigest() const
+        {
+            return m_state + m_hits * 3 + m_runs;
+        }
+
+    private:
+        // state mixed with state of peer
+        uint64_t m_state;
+        // number of storm events received
+        uint64_t m_hits;
+        // number of runs
+        uint64_t m_runs;
+        // GUID of peer
+        uint64_t m_peerGUID;
+        // gap between runs
+        uniform_int_generator<simtime_t> m_gap;
+};
+
+/*
+ * Storm; an event changing state of selected cells
+ */
+class CheckStorm : public SimEvent
+{
+    public:
+        CheckStorm() : m_fired(0)
+        {
+            //
+        };
+
+        void ExecuteOn(SimulationObject& object) override
+        {
+            static_cast<CheckCell&>(object).Disturb();
+        }
+
+        void AfterExecute() override
+        {
+            if (++m_fired < _stormCount)
+                Schedule(GetSimulation()->GetMainCalendar(), 7, true);
+        }
+
+        void Serialize(CheckpointWriter& writer) const override
+        {
+            SimEvent::Serialize(writer);
+            writer.WriteVarInt(m_fired);
+        }
+
+        bool Deserialize(CheckpointReader& reader) override
+        {
+            if (!SimEvent::Deserialize(reader))
+                return false;
+
+            m_fired = static_cast<int>(reader.ReadVarInt());
+            return reader.IsGood();
+        }
+
+    private:
+        // number of executions
+        int m_fired;
+};
+
+/*
+ * Ticker; counts its periodic runs
+ */
+class CheckTicker : public SimProcess
+{
+    public:
+        CheckTicker() : m_ticks(0)
+        {
+            //
+        };
+
+        void Run() override
+        {
+            m_ticks++;
+        }
+
+        void Serialize(CheckpointWriter& writer) const override
+        {
+            writer.WriteVarUInt(m_ticks);
+        }
+
+        bool Deserialize(CheckpointReader& reader) override
+        {
+            m_ticks = reader.ReadVarUInt();
+            return reader.IsGood();
+        }
+
+        uint64_t GetDigest() const
+        {
+            return m_ticks;
+        }
+
+    private:
+        // number of runs
+        uint64_t m_ticks;
+};
+
+// creates simulation with calendars of given engine and registered types (without objects); the second calendar
+// is returned in tickerCalendar
+static SimulationPtr CreateSimulation(CalendarEngine engine, CalendarPtr& tickerCalendar)
+{
+    SimulationPtr simulation = Simulation::Create(std::cout);
+    simulation->GetLogger().SetLevel(LogLevel::NONE);
+    simulation->SetMasterSeed(20170301);
+
+    simulation->Setup(Calendar::Create(engine));
+    tickerCalendar = Calendar::Create(engine);
+    simulation->AddCalendar(tickerCalendar);
+    simulation->RegisterAttributeIndex(_phaseAttribute);
+
+    simulation->RegisterCheckpointType<CheckCell>(_cellType);
+    simulation->RegisterCheckpointType<CheckStorm>(_stormType);
+    simulation->RegisterCheckpointType<CheckTicker>(_tickerType);
+
+    return simulation;
+}
+
+// creates objects of model
+static void BuildModel(SimulationPtr const& simulation, CalendarPtr const& tickerCalendar, size_t cellCount)
+{
+    std::vector<std::shared_ptr<CheckCell>> cells;
+    for (size_t i = 0; i < cellCount; i++)
+        cells.push_back(simulation->CreateObject<CheckCell>(static_cast<uint32_t>(1 + i % 3)));
+
+    for (size_t i = 0; i < cellCount; i++)
+    {
+        cells[i]->SetPeer(cells[(i * 7 + 1) % cellCount]->GetGUID());
+        cells[i]->Schedule(simulation->GetMainCalendar(), i % 4);
+    }
+
+    auto storm = simulation->CreateObject<CheckStorm>();
+    storm->AddSelectionCriteria(ObjectSelectionCriteria::CLASS, 2, ObjectSelectionMode::ALL);
+    storm->AddAttributeSelectionCriteria(_phaseAttribute, 1, ObjectSelectionMode::K_OF_N, 50);
+    storm->Schedule(simulation->GetMainCalendar(), 3);
+
+    auto ticker = simulation->CreateObject<CheckTicker>();
+    ticker->SchedulePeriodic<exponential_generator<simtime_t>>(tickerCalendar, false, 0.2);
+}
+
+// computes digest of simulation state
+static uint64_t GetDigest(SimulationPtr const& simulation)
+{
+    uint64_t digest = simulation->GetSimulationTime();
+
+    for (auto& obj : simulation->GetAllObjects())
+    {
+        digest = digest * 1000003 + obj->GetGUID();
+        if (auto cell = dynamic_cast<CheckCell*>(obj.get()))
+            digest = digest * 31 + cell->GetDigest();
+        else if (auto ticker = dynamic_cast<CheckTicker*>(obj.get()))
+            digest = digest * 31 + ticker->GetDigest();
+        digest = digest * 7 + obj->GetNextSimTime();
+    }
+
+    TallyStatistic const& gaps = simulation->GetStatistics().GetTally("gap");
+    digest = digest * 1000003 + gaps.GetCount();
+    digest = digest * 1000003 + static_cast<uint64_t>(gaps.GetMean() * 1e6);
+
+    return digest;
+}
+
+// prints digest of run and compares it with reference digest; returns false, if they differ
+static bool Compare(std::string const& name, uint64_t digest, uint64_t reference)
+{
+    const bool same = (digest == reference);
+
+    std::cout << name << "digest " << std::hex << digest << std::dec << (same ? "" : " - DIFFERENT") << std::endl;
+
+    return same;
+}
+
+// runs checks with calendars of given engine; returns false, if some of them failed
+static bool CheckEngine(std::string const& name, CalendarEngine engine, size_t cellCount, simtime_t endTime)
+{
+    std::cout << name << ":" << std::endl;
+
+    CalendarPtr tickerCalendar;
+
+    SimulationPtr uninterrupted = CreateSimulation(engine, tickerCalendar);
+    BuildModel(uninterrupted, tickerCalendar, cellCount);
+    uninterrupted->RunUntil(endTime);
+    const uint64_t reference = GetDigest(uninterrupted);
+
+    bool identical = Compare("  uninterrupted:        ", reference, reference);
+
+    SimulationPtr original = CreateSimulation(engine, tickerCalendar);
+    BuildModel(original, tickerCalendar, cellCount);
+    original->RunUntil(endTime / 2);
+
+    SimulationPtr restored = CreateSimulation(engine, tickerCalendar);
+    if (!original->Checkpoint(_checkpointPath) || !restored->Restore(_checkpointPath))
+    {
+        std::cout << "  checkpoint could not be written or restored" << std::endl;
+        return false;
+    }
+
+    restored->RunUntil(endTime);
+    identical &= Compare("  restored:             ", GetDigest(restored), reference);
+
+    // forks continue independently of the original
+    SimulationPtr forked = CreateSimulation(engine, tickerCalendar);
+    BuildModel(forked, tickerCalendar, cellCount);
+    forked->RunUntil(endTime / 2);
+
+    std::vector<SimulationPtr> forks = forked->Fork(_forkCount);
+    if (forks.size() != _forkCount)
+    {
+        std::cout << "  simulation could not be forked" << std::endl;
+        return false;
+    }
+
+    forked->RunUntil(endTime);
+    identical &= Compare("  forked original:      ", GetDigest(forked), reference);
+
+    for (auto& fork : forks)
+    {
+        fork->RunUntil(endTime);
+        identical &= Compare("  fork:                 ", GetDigest(fork), reference);
+    }
+
+    return identical;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t cellCount = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 2000;
+    const simtime_t endTime = (argc > 2) ? std::strtoull(argv[2], nullptr, 10) : 400;
+
+    std::cout << "Checkpoint check: " << cellCount << " cells, end time " << endTime << std::endl;
+
+    bool identical = CheckEngine("binary heap", CalendarEngine::BINARY_HEAP, cellCount, endTime);
+    identical &= CheckEngine("calendar queue", CalendarEngine::CALENDAR_QUEUE, cellCount, endTime);
+
+    std::remove(_checkpointPath);
+
+    std::cout << "results:                " << (identical ? "identical" : "DIFFERENT") << std::endl;
+
+    return identical ? 0 : 1;
+}
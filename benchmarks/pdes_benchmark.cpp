@@ -0,0 +1,203 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+/*
+ * Benchmark of parallel simulation - PHOLD network model
+ *
+ * Nodes of network are distributed to logical processes round-robin. Every node holds a few packets; when a packet
+ * arrives, the node processes it (synthetic work) and forwards it to a random node with a random delay, at least
+ * the link latency (which is the lookahead). The model is run sequentially (single thread), in parallel with conservative
+ * synchronization and in parallel with optimistic synchronization (the nodes save their state by copy), and the results
+ * of all runs are compared.
+ *
+ * Build (from this directory; the library sources are all .cpp files of parent directory and random/base_generator.cpp):
+ *   g++ -std=c++14 -O2 -pthread -I.. pdes_benchmark.cpp $(find .. -maxdepth 1 -name '*.cpp') ../random/base_generator.cpp -o pdes_benchmark
+ *
+ * Usage:
+ *   pdes_benchmark [logical processes] [threads] [nodes] [end time] [work per packet] [optimism window]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <cstdlib>
+
+#include "simlib.h"
+#include "random/exponential_generator.h"
+#include "random/uniform_generator.h"
+
+// link latency; lookahead of the model
+static const simtime_t _linkLatency = 10;
+// packets held by every node at start
+static const int _packetsPerNode = 4;
+
+/*
+ * Node of network
+ */
+class NetworkNode : public SimProcess
+{
+    public:
+        NetworkNode() : m_lpCount(1), m_work(0)
+        {
+            SetStateSavingMode(StateSavingMode::COPY);
+        };
+
+        // sets up node; must be called after the node is added to simulation
+        void Init(std::vector<uint64_t> const* nodeGUIDs, size_t lpCount, uint64_t work)
+        {
+            m_nodeGUIDs = nodeGUIDs;
+            m_lpCount = lpCount;
+            m_work = work;
+            m_state.target.reinit(0, nodeGUIDs->size() - 1);
+
+            SeedGenerator(m_state.delay, random_stream_user);
+            SeedGenerator(m_state.target, random_stream_user + 1);
+        }
+
+        void ReceiveMessage(SimulationMessage const& message) override
+        {
+            m_state.received++;
+
+            // synthetic processing of packet
+            uint64_t state = static_cast<uint64_t>(message.data[0]) ^ message.time;
+            for (uint64_t i = 0; i < m_work; i++)
+                state = state * 6364136223846793005ULL + 1442695040888963407ULL;
+            m_state.checksum = m_state.checksum * 31 + (state >> 32);
+
+            // forward packet to random node
+            const uint64_t target = m_state.target();
+            SendMessage(static_cast<uint32_t>(target % m_lpCount), (*m_nodeGUIDs)[target], _linkLatency + static_cast<simtime_t>(m_state.delay()),
+                0, SimulationMessageData{ message.data[0], 0, 0, 0 });
+        }
+
+        uint64_t GetReceived() const { return m_state.received; }
+        uint64_t GetChecksum() const { return m_state.checksum; }
+
+    protected:
+        void SaveState(ProcessSnapshot& snapshot) const override
+        {
+            snapshot.Store(m_state);
+        }
+
+        void RestoreState(ProcessSnapshot const& snapshot) override
+        {
+            m_state = snapshot.Get<NodeState>();
+        }
+
+    private:
+        /*
+         * Mutable state of node
+         */
+        struct NodeState
+        {
+            // extra delay of packet
+            exponential_generator<double> delay{ 0.05 };
+            // selection of next node
+            uniform_int_generator<uint64_t> target{ 0, 1 };
+            // number of received packets
+            uint64_t received = 0;
+            // checksum of processed packets
+            uint64_t checksum = 0;
+        };
+
+        // state of node
+        NodeState m_state;
+        // GUIDs of all nodes (within their logical processes)
+        std::vector<uint64_t> const* m_nodeGUIDs;
+        // number of logical processes
+        size_t m_lpCount;
+        // synthetic work per packet
+        uint64_t m_work;
+};
+
+/*
+ * Result of single run
+ */
+struct RunResult
+{
+    double seconds;
+    uint64_t packets;
+    uint64_t checksum;
+    uint64_t windows;
+    uint64_t rolledBack;
+};
+
+static RunResult RunModel(ParallelSimulationMode mode, size_t lpCount, size_t threadCount, size_t nodeCount, simtime_t endTime, uint64_t work, simtime_t window)
+{
+    ParallelSimulation simulation(lpCount, threadCount, mode);
+    simulation.SetLookahead(_linkLatency);
+    simulation.SetOptimismWindow(window);
+    simulation.SetMasterSeed(20170301);
+
+    for (size_t i = 0; i < lpCount; i++)
+        simulation.GetLogicalProcess(i)->Setup(Calendar::Create());
+
+    std::vector<uint64_t> nodeGUIDs(nodeCount);
+    std::vector<std::shared_ptr<NetworkNode>> nodes;
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        auto node = simulation.GetLogicalProcess(i % lpCount)->CreateObject<NetworkNode>();
+        nodeGUIDs[i] = node->GetGUID();
+        nodes.push_back(node);
+    }
+
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        nodes[i]->Init(&nodeGUIDs, lpCount, work);
+
+        for (int p = 0; p < _packetsPerNode; p++)
+            nodes[i]->SendMessage(static_cast<uint32_t>(i % lpCount), nodeGUIDs[i], _linkLatency + p, 0, SimulationMessageData{ static_cast<int64_t>(i * _packetsPerNode + p), 0, 0, 0 });
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    simulation.RunUntil(endTime);
+    auto end = std::chrono::steady_clock::now();
+
+    RunResult result;
+    result.seconds = std::chrono::duration<double>(end - start).count();
+    result.packets = 0;
+    result.checksum = 0;
+    result.windows = simulation.GetWindowCount();
+    result.rolledBack = simulation.GetRolledBackMessageCount();
+
+    for (auto& node : nodes)
+    {
+        result.packets += node->GetReceived();
+        result.checksum = result.checksum * 1000003 + node->GetChecksum();
+    }
+
+    return result;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t lpCount = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 8;
+    const size_t threadCount = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 0;
+    const size_t nodeCount = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 4096;
+    const simtime_t endTime = (argc > 4) ? std::strtoull(argv[4], nullptr, 10) : 2000;
+    const uint64_t work = (argc > 5) ? std::strtoull(argv[5], nullptr, 10) : 2000;
+    const simtime_t window = (argc > 6) ? std::strtoull(argv[6], nullptr, 10) : 0;
+
+    std::cout << "PHOLD: " << nodeCount << " nodes, " << lpCount << " logical processes, end time " << endTime << ", work " << work << std::endl;
+
+    RunResult sequential = RunModel(ParallelSimulationMode::CONSERVATIVE, lpCount, 1, nodeCount, endTime, work, window);
+    RunResult conservative = RunModel(ParallelSimulationMode::CONSERVATIVE, lpCount, threadCount, nodeCount, endTime, work, window);
+    RunResult optimistic = RunModel(ParallelSimulationMode::OPTIMISTIC, lpCount, threadCount, nodeCount, endTime, work, window);
+
+    const bool identical = (sequential.checksum == conservative.checksum && sequential.packets == conservative.packets
+        && sequential.checksum == optimistic.checksum && sequential.packets == optimistic.packets);
+
+    std::cout << std::fixed << std::setprecision(3);
+    std::cout << "sequential:   " << sequential.seconds << " s, " << sequential.packets << " packets, " << sequential.windows << " windows" << std::endl;
+    std::cout << "conservative: " << conservative.seconds << " s, " << conservative.packets << " packets, " << conservative.windows << " windows" << std::endl;
+    std::cout << "optimistic:   " << optimistic.seconds << " s, " << optimistic.packets << " packets, " << optimistic.windows << " epochs, "
+        << optimistic.rolledBack << " rolled back" << std::endl;
+    std::cout << "speedup:      " << sequential.seconds / conservative.seconds << " (conservative), " << sequential.seconds / optimistic.seconds << " (optimistic)" << std::endl;
+    std::cout << "results:      " << (identical ? "identical" : "DIFFERENT") << std::endl;
+
+    return identical ? 0 : 1;
+}
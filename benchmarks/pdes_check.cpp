@@ -0,0 +1,278 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+/*
+ * Equivalence check of parallel simulation - PHOLD network model with calendar-driven sources
+ *
+ * Nodes of network forward packets to random nodes (see pdes_benchmark); in addition, every logical process runs
+ * a source process scheduled in calendar, which injects new packets periodically. The model is run in single
+ * simulation without parallel engine and in one logical process of parallel simulation, then partitioned
+ * to logical processes and run with conservative synchronization on one and more threads, and with optimistic
+ * synchronization using adaptive and fixed optimism windows (the nodes save their state by copy, the sources are
+ * never rolled back). The checksums of all runs with the same partitioning must be identical.
+ *
+ * Build (from this directory; the library sources are all .cpp files of parent directory and random/base_generator.cpp):
+ *   g++ -std=c++14 -O2 -pthread -I.. pdes_check.cpp $(find .. -maxdepth 1 -name '*.cpp') ../random/base_generator.cpp -o pdes_check
+ *
+ * Usage:
+ *   pdes_check [logical processes] [threads] [nodes] [end time]
+ */
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <cstdlib>
+
+#include "simlib.h"
+#include "random/exponential_generator.h"
+#include "random/uniform_generator.h"
+
+// link latency; lookahead of the model
+static const simtime_t _linkLatency = 5;
+// packets held by every node at start
+static const int _packetsPerNode = 4;
+// period of packet sources
+static const simtime_t _sourcePeriod = 37;
+
+/*
+ * Node of network
+ */
+class CheckNode : public SimProcess
+{
+    public:
+        CheckNode() : m_lpCount(1)
+        {
+            SetStateSavingMode(StateSavingMode::COPY);
+        };
+
+        // sets up node; must be called after the node is added to simulation
+        void Init(std::vector<uint64_t> const* nodeGUIDs, size_t lpCount)
+        {
+            m_nodeGUIDs = nodeGUIDs;
+            m_lpCount = lpCount;
+            m_state.target.reinit(0, nodeGUIDs->size() - 1);
+
+            SeedGenerator(m_state.delay, random_stream_user);
+            SeedGenerator(m_state.target, random_stream_user + 1);
+        }
+
+        void ReceiveMessage(SimulationMessage const& message) override
+        {
+            m_state.received++;
+            m_state.checksum = m_state.checksum * 31 + (message.time * 2654435761ULL ^ static_cast<uint64_t>(message.data[0]));
+
+            // forward packet to random node
+            const uint64_t target = m_state.target();
+            SendMessage(static_cast<uint32_t>(target % m_lpCount), (*m_nodeGUIDs)[target], _linkLatency + static_cast<simtime_t>(m_state.delay()),
+                0, SimulationMessageData{ message.data[0] + 1, 0, 0, 0 });
+        }
+
+        uint64_t GetReceived() const { return m_state.received; }
+        uint64_t GetChecksum() const { return m_state.checksum; }
+
+    protected:
+        void SaveState(ProcessSnapshot& snapshot) const override
+        {
+            snapshot.Store(m_state);
+        }
+
+        void RestoreState(ProcessSnapshot const& snapshot) override
+        {
+            m_state = snapshot.Get<NodeState>();
+        }
+
+    private:
+        /*
+         * Mutable state of node
+         */
+        struct NodeState
+        {
+            // extra delay of packet
+            exponential_generator<double> delay{ 0.1 };
+            // selection of next node
+            uniform_int_generator<uint64_t> target{ 0, 1 };
+            // number of received packets
+            uint64_t received = 0;
+            // checksum of received packets
+            uint64_t checksum = 0;
+        };
+
+        // state of node
+        NodeState m_state;
+        // GUIDs of all nodes (within their logical processes)
+        std::vector<uint64_t> const* m_nodeGUIDs;
+        // number of logical processes
+        size_t m_lpCount;
+};
+
+/*
+ * Source of packets; injects a packet to its node periodically
+ */
+class CheckSource : public SimProcess
+{
+    public:
+        CheckSource() : m_node(nullptr), m_injected(0)
+        {
+            //
+        };
+
+        void Init(CheckNode* node)
+        {
+            m_node = node;
+        }
+
+        void Run() override
+        {
+            SimulationPtr simulation = GetSimulation();
+
+            SendMessage(simulation->GetLogicalProcessIndex(), m_node->GetGUID(), 0, 1, SimulationMessageData{ 1000000 + m_injected++, 0, 0, 0 });
+            Schedule(simulation->GetMainCalendar(), _sourcePeriod, true);
+        }
+
+    private:
+        // node receiving injected packets
+        CheckNode* m_node;
+        // number of injected packets
+        int64_t m_injected;
+};
+
+/*
+ * Result of single run
+ */
+struct CheckResult
+{
+    uint64_t packets;
+    uint64_t checksum;
+};
+
+// creates nodes in given simulations (node i in simulation i % count) and sources in all of them, and sends initial packets
+static void BuildModel(std::vector<SimulationPtr> const& simulations, size_t nodeCount, std::vector<uint64_t>& nodeGUIDs,
+                       std::vector<std::shared_ptr<CheckNode>>& nodes)
+{
+    const size_t lpCount = simulations.size();
+
+    nodeGUIDs.resize(nodeCount);
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        auto node = simulations[i % lpCount]->CreateObject<CheckNode>();
+        nodeGUIDs[i] = node->GetGUID();
+        nodes.push_back(node);
+    }
+
+    for (size_t i = 0; i < nodeCount; i++)
+    {
+        nodes[i]->Init(&nodeGUIDs, lpCount);
+
+        for (int p = 0; p < _packetsPerNode; p++)
+            nodes[i]->SendMessage(static_cast<uint32_t>(i % lpCount), nodeGUIDs[i], _linkLatency + p, 0, SimulationMessageData{ static_cast<int64_t>(i * _packetsPerNode + p), 0, 0, 0 });
+    }
+
+    for (size_t i = 0; i < lpCount; i++)
+    {
+        auto source = simulations[i]->CreateObject<CheckSource>();
+        source->Init(nodes[i].get());
+        source->Schedule(simulations[i]->GetMainCalendar(), 3 + i);
+    }
+}
+
+static CheckResult CollectResult(std::vector<std::shared_ptr<CheckNode>> const& nodes)
+{
+    CheckResult result;
+    result.packets = 0;
+    result.checksum = 0;
+
+    for (auto& node : nodes)
+    {
+        result.packets += node->GetReceived();
+        result.checksum = result.checksum * 1000003 + node->GetChecksum();
+    }
+
+    return result;
+}
+
+// runs model in single simulation, without parallel engine
+static CheckResult RunSequential(size_t nodeCount, simtime_t endTime)
+{
+    SimulationPtr simulation = Simulation::Create(std::cout);
+    simulation->GetLogger().SetLevel(LogLevel::NONE);
+    simulation->SetMasterSeed(20170301);
+    simulation->Setup(Calendar::Create());
+
+    std::vector<uint64_t> nodeGUIDs;
+    std::vector<std::shared_ptr<CheckNode>> nodes;
+    BuildModel({ simulation }, nodeCount, nodeGUIDs, nodes);
+
+    simulation->RunUntil(endTime);
+
+    return CollectResult(nodes);
+}
+
+// runs model partitioned to given number of logical processes; the optimism window 0 stands for adaptive window
+static CheckResult RunParallel(ParallelSimulationMode mode, size_t lpCount, size_t threadCount, size_t nodeCount, simtime_t endTime,
+                               simtime_t window = 0)
+{
+    ParallelSimulation simulation(lpCount, threadCount, mode);
+    simulation.SetLookahead(_linkLatency);
+    simulation.SetOptimismWindow(window);
+    simulation.SetMasterSeed(20170301);
+
+    std::vector<SimulationPtr> lps;
+    for (size_t i = 0; i < lpCount; i++)
+    {
+        lps.push_back(simulation.GetLogicalProcess(i));
+        lps.back()->Setup(Calendar::Create());
+    }
+
+    std::vector<uint64_t> nodeGUIDs;
+    std::vector<std::shared_ptr<CheckNode>> nodes;
+    BuildModel(lps, nodeCount, nodeGUIDs, nodes);
+
+    simulation.RunUntil(endTime);
+
+    return CollectResult(nodes);
+}
+
+// compares result of run with reference result and prints it; returns false, if they differ
+static bool Compare(std::string const& name, CheckResult const& result, CheckResult const& reference)
+{
+    const bool same = (result.packets == reference.packets && result.checksum == reference.checksum);
+
+    std::cout << name << result.packets << " packets, checksum " << std::hex << result.checksum << std::dec
+        << (same ? "" : " - DIFFERENT") << std::endl;
+
+    return same;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t lpCount = (argc > 1) ? std::strtoul(argv[1], nullptr, 10) : 4;
+    const size_t threadCount = (argc > 2) ? std::strtoul(argv[2], nullptr, 10) : 0;
+    const size_t nodeCount = (argc > 3) ? std::strtoul(argv[3], nullptr, 10) : 256;
+    const simtime_t endTime = (argc > 4) ? std::strtoull(argv[4], nullptr, 10) : 3000;
+
+    std::cout << "PHOLD check: " << nodeCount << " nodes, " << lpCount << " logical processes, end time " << endTime << std::endl;
+
+    bool identical = true;
+
+    // the same model in single logical process
+    CheckResult sequential = RunSequential(nodeCount, endTime);
+    identical &= Compare("sequential:               ", sequential, sequential);
+    identical &= Compare("conservative, 1 LP:       ", RunParallel(ParallelSimulationMode::CONSERVATIVE, 1, threadCount, nodeCount, endTime), sequential);
+    identical &= Compare("optimistic, 1 LP:         ", RunParallel(ParallelSimulationMode::OPTIMISTIC, 1, threadCount, nodeCount, endTime), sequential);
+
+    // partitioned model; the results do not depend on number of threads
+    CheckResult reference = RunParallel(ParallelSimulationMode::CONSERVATIVE, lpCount, 1, nodeCount, endTime);
+    identical &= Compare("conservative, 1 thread:   ", reference, reference);
+    identical &= Compare("conservative:             ", RunParallel(ParallelSimulationMode::CONSERVATIVE, lpCount, threadCount, nodeCount, endTime), reference);
+    identical &= Compare("optimistic, 1 thread:     ", RunParallel(ParallelSimulationMode::OPTIMISTIC, lpCount, 1, nodeCount, endTime), reference);
+    identical &= Compare("optimistic, adaptive:     ", RunParallel(ParallelSimulationMode::OPTIMISTIC, lpCount, threadCount, nodeCount, endTime), reference);
+    identical &= Compare("optimistic, window 1x:    ", RunParallel(ParallelSimulationMode::OPTIMISTIC, lpCount, threadCount, nodeCount, endTime, _linkLatency), reference);
+    identical &= Compare("optimistic, window 20x:   ", RunParallel(ParallelSimulationMode::OPTIMISTIC, lpCount, threadCount, nodeCount, endTime, 20 * _linkLatency), reference);
+
+    std::cout << "results:                  " << (identical ? "identical" : "DIFFERENT") << std::endl;
+
+    return identical ? 0 : 1;
+}
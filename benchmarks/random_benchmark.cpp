@@ -0,0 +1,96 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+/*
+ * Benchmark of random generators - compares standard library engine with standard distributions against
+ * the block generators used by the library. The large blocks of uniform real generator are vectorized only with AVX2
+ * or newer, so the speedup of uniform real samples is expected only with -march supporting it; no speedup is claimed
+ * for uniform integer samples
+ *
+ * Build (from this directory):
+ *   g++ -std=c++14 -O3 -march=native -I.. random_benchmark.cpp ../random/base_generator.cpp -o random_benchmark
+ *
+ * Usage:
+ *   random_benchmark [sample count]
+ */
+
+#include <iostream>
+#include <iomanip>
+#include <random>
+#include <chrono>
+#include <string>
+#include <cstdlib>
+
+#include "random/uniform_generator.h"
+#include "random/exponential_generator.h"
+#include "random/gaussian_generator.h"
+
+// default number of samples per measurement
+static const size_t _defaultSampleCount = 50000000;
+// number of repetitions of every measurement; the best one is reported, so the results are not skewed by other load
+static const size_t _repeatCount = 5;
+
+// measures time of drawing given number of samples from generator; prints nanoseconds per sample
+template<typename G>
+static void Measure(const std::string& name, G& generator, size_t count)
+{
+    double sum = 0.0;
+    double ns = 0.0;
+
+    for (size_t r = 0; r < _repeatCount; r++)
+    {
+        sum = 0.0;
+
+        auto start = std::chrono::steady_clock::now();
+        for (size_t i = 0; i < count; i++)
+            sum += generator();
+        auto end = std::chrono::steady_clock::now();
+
+        const double elapsed = std::chrono::duration<double, std::nano>(end - start).count() / static_cast<double>(count);
+        if (r == 0 || elapsed < ns)
+            ns = elapsed;
+    }
+
+    // the sum is printed, so the compiler could not remove the loop
+    std::cout << std::left << std::setw(36) << name << std::right << std::setw(8) << std::fixed << std::setprecision(2)
+        << ns << " ns/sample   (mean " << std::setprecision(4) << sum / static_cast<double>(count) << ")" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    const size_t count = (argc > 1) ? static_cast<size_t>(std::strtoull(argv[1], nullptr, 10)) : _defaultSampleCount;
+
+    std::default_random_engine stdEngine(_global_true_random_device());
+
+    std::uniform_int_distribution<int64_t> stdUniformInt(0, 999);
+    auto stdUniformIntGen = [&]() { return stdUniformInt(stdEngine); };
+    uniform_int_generator<int64_t> uniformInt(0, 999);
+
+    std::uniform_real_distribution<double> stdUniformReal(0.0, 1.0);
+    auto stdUniformRealGen = [&]() { return stdUniformReal(stdEngine); };
+    uniform_real_generator<double> uniformReal(0.0, 1.0);
+
+    std::exponential_distribution<double> stdExponential(0.5);
+    auto stdExponentialGen = [&]() { return stdExponential(stdEngine); };
+    exponential_generator<double> exponential(0.5);
+
+    std::normal_distribution<double> stdGaussian(10.0, 2.0);
+    auto stdGaussianGen = [&]() { return stdGaussian(stdEngine); };
+    gaussian_generator<double> gaussian(10.0, 2.0);
+
+    std::cout << "Samples per measurement: " << count << " (best of " << _repeatCount << ")" << std::endl;
+
+    Measure("std uniform_int", stdUniformIntGen, count);
+    Measure("uniform_int_generator", uniformInt, count);
+    Measure("std uniform_real", stdUniformRealGen, count);
+    Measure("uniform_real_generator", uniformReal, count);
+    Measure("std exponential", stdExponentialGen, count);
+    Measure("exponential_generator", exponential, count);
+    Measure("std normal", stdGaussianGen, count);
+    Measure("gaussian_generator", gaussian, count);
+
+    return 0;
+}
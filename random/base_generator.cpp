@@ -6,4 +6,18 @@
 
 #include "base_generator.h"
 
+#include <atomic>
+
 std::random_device _global_true_random_device;
+
+uint64_t random_default_key()
+{
+    static const uint64_t key = (static_cast<uint64_t>(_global_true_random_device()) << 32) | static_cast<uint32_t>(_global_true_random_device());
+    return key;
+}
+
+uint64_t random_next_default_stream()
+{
+    static std::atomic<uint64_t> stream(0);
+    return stream.fetch_add(1, std::memory_order_relaxed);
+}
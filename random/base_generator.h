@@ -8,9 +8,17 @@
 
 #include <random>
 
-// global instance of true random device used across multiple generators
+#include "philox_engine.h"
+
+// global instance of true random device used across multiple generators; not guarded, the generators use it only
+// through random_default_key, which reads it once
 extern std::random_device _global_true_random_device;
 
+// retrieves key of generators not seeded explicitly; drawn from the true random device once per process
+uint64_t random_default_key();
+// retrieves next stream of generators not seeded explicitly
+uint64_t random_next_default_stream();
+
 /*
  * Base class for all random generators
  */
@@ -18,12 +26,31 @@ template<typename T>
 class base_generator
 {
     public:
-        base_generator() : m_engine(_global_true_random_device()) { };
+        base_generator() : m_engine(random_default_key(), random_next_default_stream()) { };
+        virtual ~base_generator() { };
 
         // operator() is used for retrieving (pseudo)random numbers
         virtual T operator()() = 0;
 
+        // seeds the engine with given key and stream; numbers generated in advance are discarded
+        virtual void seed(uint64_t key, uint64_t stream)
+        {
+            m_engine.seed(key, stream);
+        }
+
+        // writes state of generator (engine, parameters and numbers generated in advance) to sink
+        virtual void save(random_state_sink& sink) const
+        {
+            m_engine.save(sink);
+        }
+
+        // restores state written by save; returns false, if the state could not be read
+        virtual bool load(random_state_source& source)
+        {
+            return m_engine.load(source);
+        }
+
     protected:
-        // random engine instance; we go with platform/compiler defaults here (mt19937)
-        std::default_random_engine m_engine;
+        // random engine instance; counter-based, so the generators could draw whole blocks of numbers at once
+        philox4x32_engine m_engine;
 };
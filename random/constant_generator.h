@@ -15,7 +15,7 @@ template<typename T>
 class constant_generator : public base_generator<T>
 {
     public:
-        constant_generator(T val) : base_generator(), m_value(val) { };
+        constant_generator(T val) : base_generator<T>(), m_value(val) { };
 
         virtual T operator()() override
         {
@@ -28,6 +28,17 @@ class constant_generator : public base_generator<T>
             m_value = val;
         }
 
+        virtual void save(random_state_sink& sink) const override
+        {
+            base_generator<T>::save(sink);
+            random_write_state(sink, m_value);
+        }
+
+        virtual bool load(random_state_source& source) override
+        {
+            return base_generator<T>::load(source) && random_read_state(source, m_value);
+        }
+
     protected:
         T m_value;
 };
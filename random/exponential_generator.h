@@ -7,44 +7,78 @@
 #pragma once
 
 #include "base_generator.h"
+#include "random_block.h"
 #include <cmath>
 
 /*
- * Generator of exponential distribution with specified parameters
+ * Generator of exponential distribution with specified parameters; standard exponential samples are generated
+ * in blocks and scaled by the rate
  */
 template<typename T>
 class exponential_generator : public base_generator<T>
 {
     public:
-        exponential_generator(double lambda) : base_generator(), m_dist(lambda) { };
+        exponential_generator(double lambda) : base_generator<T>(), m_invLambda(1.0 / lambda) { };
 
         virtual T operator()() override
         {
-            return static_cast<T>(round(m_dist(m_engine)));
+            return static_cast<T>(round(next()));
         }
 
         // reinitializes generator with a new lambda
         virtual void reinit(double lambda)
         {
-            m_dist = std::exponential_distribution<double>(lambda);
+            m_invLambda = 1.0 / lambda;
+        }
+
+        virtual void seed(uint64_t key, uint64_t stream) override
+        {
+            base_generator<T>::seed(key, stream);
+            m_block.clear();
+        }
+
+        virtual void save(random_state_sink& sink) const override
+        {
+            base_generator<T>::save(sink);
+            random_write_state(sink, m_invLambda);
+            m_block.save(sink);
+        }
+
+        virtual bool load(random_state_source& source) override
+        {
+            if (!base_generator<T>::load(source) || !random_read_state(source, m_invLambda))
+                return false;
+
+            return m_block.load(source);
         }
 
     protected:
-        // encapsulated standard library distribution generator
-        std::exponential_distribution<double> m_dist;
+        // retrieves next sample, refills the block if needed
+        double next()
+        {
+            if (m_block.empty())
+                random_fill_exponential(this->m_engine, m_block);
+
+            return m_block.next() * m_invLambda;
+        }
+
+        // inverse of rate parameter (mean)
+        double m_invLambda;
+        // pre-generated standard exponential samples
+        random_block<double> m_block;
 };
 
 
 // explicitly specializate generators for double and float, to not round the result
 
 template <>
-double exponential_generator<double>::operator()()
+inline double exponential_generator<double>::operator()()
 {
-    return static_cast<double>(m_dist(m_engine));
+    return next();
 }
 
 template <>
-float exponential_generator<float>::operator()()
+inline float exponential_generator<float>::operator()()
 {
-    return static_cast<float>(m_dist(m_engine));
+    return static_cast<float>(next());
 }
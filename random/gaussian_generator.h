@@ -7,43 +7,81 @@
 #pragma once
 
 #include "base_generator.h"
+#include "random_block.h"
 #include <cmath>
 
 /*
- * Normal (gaussian) distribution generator using specified parameters
+ * Normal (gaussian) distribution generator using specified parameters; standard normal samples are generated
+ * in blocks using the ziggurat method, and then scaled and shifted
  */
 template<typename T>
 class gaussian_generator : public base_generator<T>
 {
     public:
-        gaussian_generator(double mean, double deviation) : base_generator(), m_dist(mean, deviation) { };
+        gaussian_generator(double mean, double deviation) : base_generator<T>(), m_mean(mean), m_deviation(deviation) { };
 
         virtual T operator()() override
         {
-            return static_cast<T>(round(m_dist(m_engine)));
+            return static_cast<T>(round(next()));
         }
 
         // reinitializes distribution with new parameters
         virtual void reinit(double mean, double deviation)
         {
-            m_dist = std::normal_distribution<double>(mean, deviation);
+            m_mean = mean;
+            m_deviation = deviation;
+        }
+
+        virtual void seed(uint64_t key, uint64_t stream) override
+        {
+            base_generator<T>::seed(key, stream);
+            m_block.clear();
+        }
+
+        virtual void save(random_state_sink& sink) const override
+        {
+            base_generator<T>::save(sink);
+            random_write_state(sink, m_mean);
+            random_write_state(sink, m_deviation);
+            m_block.save(sink);
+        }
+
+        virtual bool load(random_state_source& source) override
+        {
+            if (!base_generator<T>::load(source) || !random_read_state(source, m_mean) || !random_read_state(source, m_deviation))
+                return false;
+
+            return m_block.load(source);
         }
 
     protected:
-        // encapsulated standard library distribution generator
-        std::normal_distribution<double> m_dist;
+        // retrieves next sample, refills the block if needed
+        double next()
+        {
+            if (m_block.empty())
+                random_fill_normal(this->m_engine, m_block);
+
+            return m_mean + m_deviation * m_block.next();
+        }
+
+        // mean value
+        double m_mean;
+        // standard deviation
+        double m_deviation;
+        // pre-generated standard normal samples
+        random_block<double> m_block;
 };
 
 // explicitly specializate generators for double and float, to not round the result
 
 template <>
-double gaussian_generator<double>::operator()()
+inline double gaussian_generator<double>::operator()()
 {
-    return static_cast<double>(m_dist(m_engine));
+    return next();
 }
 
 template <>
-float gaussian_generator<float>::operator()()
+inline float gaussian_generator<float>::operator()()
 {
-    return static_cast<float>(m_dist(m_engine));
+    return static_cast<float>(next());
 }
@@ -0,0 +1,257 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+#include "random_state.h"
+
+/*
+ * Philox4x32-10 counter-based random engine (Salmon et al., "Parallel random numbers: as easy as 1, 2, 3")
+ *
+ * Every 128-bit output block is a bijection of 128-bit counter under the 64-bit key, so the blocks do not depend
+ * on each other - the block generation loop has no carried dependency and could be vectorized. The lower half of
+ * counter is incremented with every block, the upper half selects a stream. The engine satisfies the uniform
+ * random bit generator requirements, so it could be used with standard library distributions
+ */
+class philox4x32_engine
+{
+    public:
+        using result_type = uint64_t;
+
+        static constexpr result_type min() { return 0; }
+        static constexpr result_type max() { return ~static_cast<result_type>(0); }
+
+        philox4x32_engine(uint64_t key = 0, uint64_t stream = 0)
+        {
+            seed(key, stream);
+        }
+
+        // sets key and stream, and resets counter
+        void seed(uint64_t key, uint64_t stream = 0)
+        {
+            m_key[0] = static_cast<uint32_t>(key);
+            m_key[1] = static_cast<uint32_t>(key >> 32);
+            m_stream = stream;
+            m_counter = 0;
+            m_spare = 0;
+            m_hasSpare = false;
+        }
+
+        // retrieves next 64-bit random number
+        result_type operator()()
+        {
+            if (m_hasSpare)
+            {
+                m_hasSpare = false;
+                return m_spare;
+            }
+
+            uint64_t out[2];
+            generate(out, 2);
+            m_spare = out[1];
+            m_hasSpare = true;
+            return out[0];
+        }
+
+        // fills given array with 64-bit random numbers; every two numbers consume one counter value
+        void generate(uint64_t* out, size_t count)
+        {
+            // the output may alias the members, so work with local copies
+            const uint64_t stream = m_stream;
+            const uint32_t key0 = m_key[0], key1 = m_key[1];
+            uint64_t counter = m_counter;
+            size_t pos = 0;
+
+#if defined(__AVX2__)
+            // wide groups of lanes (e.g. large blocks of uniform real generator); the words are held in 64-bit lanes,
+            // so the compiler could use vector 32x32->64 bit multiplication - the results are the same as below
+            for (; pos + 2 * wide_lanes <= count; pos += 2 * wide_lanes)
+            {
+                uint64_t c0[wide_lanes], c1[wide_lanes], c2[wide_lanes], c3[wide_lanes];
+                for (size_t l = 0; l < wide_lanes; l++)
+                {
+                    const uint64_t ctr = counter + l;
+                    c0[l] = ctr & 0xFFFFFFFFULL;
+                    c1[l] = ctr >> 32;
+                    c2[l] = stream & 0xFFFFFFFFULL;
+                    c3[l] = stream >> 32;
+                }
+
+                uint32_t k0 = key0, k1 = key1;
+                for (int r = 0; r < rounds; r++)
+                {
+                    for (size_t l = 0; l < wide_lanes; l++)
+                    {
+                        const uint64_t p0 = mul0 * (c0[l] & 0xFFFFFFFFULL);
+                        const uint64_t p1 = mul1 * (c2[l] & 0xFFFFFFFFULL);
+
+                        c0[l] = (p1 >> 32) ^ c1[l] ^ k0;
+                        c2[l] = (p0 >> 32) ^ c3[l] ^ k1;
+                        c1[l] = p1 & 0xFFFFFFFFULL;
+                        c3[l] = p0 & 0xFFFFFFFFULL;
+                    }
+
+                    k0 += weyl0;
+                    k1 += weyl1;
+                }
+
+                for (size_t l = 0; l < wide_lanes; l++)
+                {
+                    out[pos + 2 * l] = (c1[l] << 32) | c0[l];
+                    out[pos + 2 * l + 1] = (c3[l] << 32) | c2[l];
+                }
+
+                counter += wide_lanes;
+            }
+#endif
+
+            // whole groups of lanes; the lanes are independent, so the compiler could vectorize the rounds
+            for (; pos + 2 * lanes <= count; pos += 2 * lanes)
+            {
+                uint32_t c0[lanes], c1[lanes], c2[lanes], c3[lanes];
+                for (size_t l = 0; l < lanes; l++)
+                {
+                    const uint64_t ctr = counter + l;
+                    c0[l] = static_cast<uint32_t>(ctr);
+                    c1[l] = static_cast<uint32_t>(ctr >> 32);
+                    c2[l] = static_cast<uint32_t>(stream);
+                    c3[l] = static_cast<uint32_t>(stream >> 32);
+                }
+
+                uint32_t k0 = key0, k1 = key1;
+                for (int r = 0; r < rounds; r++)
+                {
+                    for (size_t l = 0; l < lanes; l++)
+                        round(c0[l], c1[l], c2[l], c3[l], k0, k1);
+
+                    k0 += weyl0;
+                    k1 += weyl1;
+                }
+
+                for (size_t l = 0; l < lanes; l++)
+                {
+                    out[pos + 2 * l] = (static_cast<uint64_t>(c1[l]) << 32) | c0[l];
+                    out[pos + 2 * l + 1] = (static_cast<uint64_t>(c3[l]) << 32) | c2[l];
+                }
+
+                counter += lanes;
+            }
+
+            m_counter = counter;
+
+            // the rest, block by block
+            for (; pos + 2 <= count; pos += 2)
+                block(m_counter++, out[pos], out[pos + 1]);
+
+            if (pos < count)
+            {
+                uint64_t unused;
+                block(m_counter++, out[pos], unused);
+            }
+        }
+
+        // skips given number of 128-bit blocks
+        void discard_blocks(uint64_t blocks)
+        {
+            m_counter += blocks;
+            m_hasSpare = false;
+        }
+
+        // retrieves current counter value
+        uint64_t counter() const
+        {
+            return m_counter;
+        }
+
+        // writes complete engine state to sink
+        void save(random_state_sink& sink) const
+        {
+            sink.write_state((static_cast<uint64_t>(m_key[1]) << 32) | m_key[0]);
+            sink.write_state(m_stream);
+            sink.write_state(m_counter);
+            sink.write_state(static_cast<uint64_t>(m_hasSpare));
+            if (m_hasSpare)
+                sink.write_state(m_spare);
+        }
+
+        // restores engine state written by save; returns false, if the state could not be read
+        bool load(random_state_source& source)
+        {
+            uint64_t key, hasSpare;
+            if (!source.read_state(key) || !source.read_state(m_stream) || !source.read_state(m_counter) || !source.read_state(hasSpare))
+                return false;
+
+            m_key[0] = static_cast<uint32_t>(key);
+            m_key[1] = static_cast<uint32_t>(key >> 32);
+            m_hasSpare = (hasSpare != 0);
+            m_spare = 0;
+
+            return !m_hasSpare || source.read_state(m_spare);
+        }
+
+    protected:
+        // number of blocks computed at once in generate()
+        static constexpr size_t lanes = 4;
+        // number of blocks computed at once in generate(), when the compiler targets vector instructions with
+        // 32x32->64 bit multiplication of all lanes
+        static constexpr size_t wide_lanes = 16;
+        // number of rounds
+        static constexpr int rounds = 10;
+        // round multipliers
+        static constexpr uint32_t mul0 = 0xD2511F53U;
+        static constexpr uint32_t mul1 = 0xCD9E8D57U;
+        // key schedule increments (Weyl sequence)
+        static constexpr uint32_t weyl0 = 0x9E3779B9U;
+        static constexpr uint32_t weyl1 = 0xBB67AE85U;
+
+        // performs single round on counter words
+        static void round(uint32_t& c0, uint32_t& c1, uint32_t& c2, uint32_t& c3, uint32_t k0, uint32_t k1)
+        {
+            const uint64_t p0 = static_cast<uint64_t>(mul0) * c0;
+            const uint64_t p1 = static_cast<uint64_t>(mul1) * c2;
+
+            const uint32_t n0 = static_cast<uint32_t>(p1 >> 32) ^ c1 ^ k0;
+            const uint32_t n2 = static_cast<uint32_t>(p0 >> 32) ^ c3 ^ k1;
+
+            c1 = static_cast<uint32_t>(p1);
+            c3 = static_cast<uint32_t>(p0);
+            c0 = n0;
+            c2 = n2;
+        }
+
+        // computes output block for given counter value
+        void block(uint64_t ctr, uint64_t& lo, uint64_t& hi) const
+        {
+            uint32_t c0 = static_cast<uint32_t>(ctr), c1 = static_cast<uint32_t>(ctr >> 32);
+            uint32_t c2 = static_cast<uint32_t>(m_stream), c3 = static_cast<uint32_t>(m_stream >> 32);
+            uint32_t k0 = m_key[0], k1 = m_key[1];
+
+            for (int r = 0; r < rounds; r++)
+            {
+                round(c0, c1, c2, c3, k0, k1);
+                k0 += weyl0;
+                k1 += weyl1;
+            }
+
+            lo = (static_cast<uint64_t>(c1) << 32) | c0;
+            hi = (static_cast<uint64_t>(c3) << 32) | c2;
+        }
+
+    private:
+        // key
+        uint32_t m_key[2];
+        // stream (upper half of counter)
+        uint64_t m_stream;
+        // lower half of counter
+        uint64_t m_counter;
+        // second half of the last block, not returned yet
+        uint64_t m_spare;
+        // is the spare value valid?
+        bool m_hasSpare;
+};
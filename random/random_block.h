@@ -0,0 +1,328 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <cmath>
+
+#include "philox_engine.h"
+#include "random_state.h"
+
+// number of samples generated at once; kept small, so the standard generators fit inline schedule generator storage
+constexpr size_t random_block_size = 8;
+// number of samples generated at once by generators, which are not used as schedule generators (e.g. uniform real
+// generator); the larger block amortizes the block generation and is generated by wide lane groups of the engine
+constexpr size_t random_wide_block_size = 64;
+
+/*
+ * Block of pre-generated samples
+ */
+template<typename V, size_t N = random_block_size>
+struct random_block
+{
+    // generated samples
+    V values[N];
+    // position of the next sample to be returned
+    size_t position = N;
+
+    // are all samples consumed?
+    bool empty() const { return position == N; }
+    // retrieves next sample
+    V next() { return values[position++]; }
+    // discards remaining samples
+    void clear() { position = N; }
+
+    // writes samples not consumed yet to state sink
+    void save(random_state_sink& sink) const
+    {
+        sink.write_state(static_cast<uint64_t>(N - position));
+        for (size_t i = position; i < N; i++)
+            random_write_state(sink, values[i]);
+    }
+
+    // restores samples written by save; returns false, if the state could not be read
+    bool load(random_state_source& source)
+    {
+        uint64_t remaining;
+        if (!source.read_state(remaining) || remaining > N)
+            return false;
+
+        position = N - static_cast<size_t>(remaining);
+        for (size_t i = position; i < N; i++)
+        {
+            if (!random_read_state(source, values[i]))
+                return false;
+        }
+
+        return true;
+    }
+};
+
+// converts random bits to double in range [0; 1)
+inline double random_bits_to_unit(uint64_t bits)
+{
+    return static_cast<double>(bits >> 11) * (1.0 / 9007199254740992.0);
+}
+
+// converts random bits to double in range (0; 1]
+inline double random_bits_to_unit_open(uint64_t bits)
+{
+    return static_cast<double>((bits >> 11) + 1) * (1.0 / 9007199254740992.0);
+}
+
+/*
+ * Tables of ziggurat method for standard normal distribution (Marsaglia and Tsang, with Doornik's improvements)
+ */
+struct random_ziggurat_tables
+{
+    // number of layers
+    static constexpr int layers = 128;
+    // start of the right tail
+    static constexpr double tail = 3.442619855899;
+    // area of every layer
+    static constexpr double area = 9.91256303526217e-3;
+
+    // right edges of layers
+    double x[layers + 1];
+    // ratio of edges of neighbouring layers
+    double ratio[layers];
+
+    random_ziggurat_tables()
+    {
+        double f = std::exp(-0.5 * tail * tail);
+        x[0] = area / f;
+        x[1] = tail;
+        x[layers] = 0;
+
+        for (int i = 2; i < layers; i++)
+        {
+            x[i] = std::sqrt(-2 * std::log(area / x[i - 1] + f));
+            f = std::exp(-0.5 * x[i] * x[i]);
+        }
+
+        for (int i = 0; i < layers; i++)
+            ratio[i] = x[i + 1] / x[i];
+    }
+
+    // retrieves shared instance
+    static random_ziggurat_tables const& get()
+    {
+        static const random_ziggurat_tables tables;
+        return tables;
+    }
+};
+
+// draws sample of standard normal distribution from given random bits; uses the engine in rare cases, when
+// the sample falls out of the ziggurat layers
+inline double random_ziggurat_normal(philox4x32_engine& engine, random_ziggurat_tables const& zig, uint64_t bits)
+{
+    while (true)
+    {
+        // the lowest bits select the layer, the highest bits make the uniform number
+        const int i = static_cast<int>(bits & 0x7F);
+        const double u = 2.0 * random_bits_to_unit(bits) - 1.0;
+
+        // the sample is inside the layer rectangle (~99% of cases)
+        if (std::fabs(u) < zig.ratio[i])
+            return u * zig.x[i];
+
+        // the base layer - sample from the tail
+        if (i == 0)
+        {
+            double tx, ty;
+            do
+            {
+                tx = std::log(random_bits_to_unit_open(engine())) / random_ziggurat_tables::tail;
+                ty = std::log(random_bits_to_unit_open(engine()));
+            } while (-2 * ty < tx * tx);
+
+            return (u < 0) ? tx - random_ziggurat_tables::tail : random_ziggurat_tables::tail - tx;
+        }
+
+        // the sample is in the wedge; accept it, if it's under the density curve
+        const double sx = u * zig.x[i];
+        const double f0 = std::exp(-0.5 * (zig.x[i] * zig.x[i] - sx * sx));
+        const double f1 = std::exp(-0.5 * (zig.x[i + 1] * zig.x[i + 1] - sx * sx));
+        if (f1 + random_bits_to_unit(engine()) * (f0 - f1) < 1.0)
+            return sx;
+
+        bits = engine();
+    }
+}
+
+// fills block with samples of standard normal distribution
+inline void random_fill_normal(philox4x32_engine& engine, random_block<double>& block)
+{
+    random_ziggurat_tables const& zig = random_ziggurat_tables::get();
+
+    uint64_t bits[random_block_size];
+    engine.generate(bits, random_block_size);
+
+    for (size_t i = 0; i < random_block_size; i++)
+        block.values[i] = random_ziggurat_normal(engine, zig, bits[i]);
+
+    block.position = 0;
+}
+
+/*
+ * Tables of ziggurat method for standard exponential distribution (Marsaglia and Tsang)
+ */
+struct random_ziggurat_exponential_tables
+{
+    // number of layers
+    static constexpr int layers = 256;
+    // start of the tail
+    static constexpr double tail = 7.69711747013104972;
+    // area of every layer
+    static constexpr double area = 3.949659822581572e-3;
+
+    // right edges of layers
+    double x[layers + 1];
+    // ratio of edges of neighbouring layers
+    double ratio[layers];
+    // density at the right edges of layers
+    double f[layers + 1];
+
+    random_ziggurat_exponential_tables()
+    {
+        f[1] = std::exp(-tail);
+        x[0] = area / f[1];
+        x[1] = tail;
+        x[layers] = 0;
+
+        for (int i = 2; i < layers; i++)
+        {
+            x[i] = -std::log(area / x[i - 1] + f[i - 1]);
+            f[i] = std::exp(-x[i]);
+        }
+
+        f[0] = std::exp(-x[0]);
+        f[layers] = 1.0;
+
+        for (int i = 0; i < layers; i++)
+            ratio[i] = x[i + 1] / x[i];
+    }
+
+    // retrieves shared instance
+    static random_ziggurat_exponential_tables const& get()
+    {
+        static const random_ziggurat_exponential_tables tables;
+        return tables;
+    }
+};
+
+// draws sample of standard exponential distribution from given random bits; uses the engine in rare cases, when
+// the sample falls out of the ziggurat layers
+inline double random_ziggurat_exponential(philox4x32_engine& engine, random_ziggurat_exponential_tables const& zig, uint64_t bits)
+{
+    while (true)
+    {
+        // the lowest bits select the layer, the highest bits make the uniform number
+        const int i = static_cast<int>(bits & 0xFF);
+        const double u = random_bits_to_unit(bits);
+
+        // the sample is inside the layer rectangle (~99% of cases)
+        if (u < zig.ratio[i])
+            return u * zig.x[i];
+
+        // the base layer - the tail is exponential again, just shifted
+        if (i == 0)
+            return random_ziggurat_exponential_tables::tail - std::log(random_bits_to_unit_open(engine()));
+
+        // the sample is in the wedge; accept it, if it's under the density curve
+        const double x = u * zig.x[i];
+        if (zig.f[i + 1] + random_bits_to_unit(engine()) * (zig.f[i] - zig.f[i + 1]) < std::exp(-x))
+            return x;
+
+        bits = engine();
+    }
+}
+
+// fills block with samples of standard exponential distribution (rate 1)
+inline void random_fill_exponential(philox4x32_engine& engine, random_block<double>& block)
+{
+    random_ziggurat_exponential_tables const& zig = random_ziggurat_exponential_tables::get();
+
+    uint64_t bits[random_block_size];
+    engine.generate(bits, random_block_size);
+
+    for (size_t i = 0; i < random_block_size; i++)
+        block.values[i] = random_ziggurat_exponential(engine, zig, bits[i]);
+
+    block.position = 0;
+}
+
+// fills block with uniform samples in range [0; 1)
+template<size_t N>
+inline void random_fill_unit(philox4x32_engine& engine, random_block<double, N>& block)
+{
+    uint64_t bits[N];
+    engine.generate(bits, N);
+
+    for (size_t i = 0; i < N; i++)
+        block.values[i] = random_bits_to_unit(bits[i]);
+
+    block.position = 0;
+}
+
+// retrieves upper half of 128-bit product of two 64-bit numbers
+inline uint64_t random_mul_hi(uint64_t a, uint64_t b)
+{
+#if defined(__SIZEOF_INT128__)
+    return static_cast<uint64_t>((static_cast<unsigned __int128>(a) * b) >> 64);
+#elif defined(_MSC_VER) && defined(_M_X64)
+    return __umulh(a, b);
+#else
+    const uint64_t aLo = a & 0xFFFFFFFFULL, aHi = a >> 32;
+    const uint64_t bLo = b & 0xFFFFFFFFULL, bHi = b >> 32;
+
+    const uint64_t lolo = aLo * bLo;
+    const uint64_t hilo = aHi * bLo;
+    const uint64_t lohi = aLo * bHi;
+    const uint64_t hihi = aHi * bHi;
+
+    const uint64_t cross = (lolo >> 32) + (hilo & 0xFFFFFFFFULL) + lohi;
+    return hihi + (hilo >> 32) + (cross >> 32);
+#endif
+}
+
+// maps 32 random bits to range [0; range) without modulo bias (Lemire's method); range must be in [1; 2^32]
+inline uint64_t random_bounded_narrow(philox4x32_engine& engine, uint32_t bits, uint64_t range)
+{
+    // the product low half is below threshold only for (2^32 mod range) values of bits, which are rejected
+    uint64_t product = bits * range;
+    if (static_cast<uint32_t>(product) < range)
+    {
+        const uint32_t threshold = static_cast<uint32_t>((0x100000000ULL - range) % range);
+        while (static_cast<uint32_t>(product) < threshold)
+            product = static_cast<uint32_t>(engine()) * range;
+    }
+
+    return product >> 32;
+}
+
+// maps random bits to range [0; range) without modulo bias (Lemire's method); range 0 stands for the full 2^64 range
+inline uint64_t random_bounded(philox4x32_engine& engine, uint64_t bits, uint64_t range)
+{
+    if (range == 0)
+        return bits;
+
+    // the product low half is below threshold only for (2^64 mod range) values of bits, which are rejected
+    uint64_t low = bits * range;
+    if (low < range)
+    {
+        const uint64_t threshold = (0 - range) % range;
+        while (low < threshold)
+        {
+            bits = engine();
+            low = bits * range;
+        }
+    }
+
+    return random_mul_hi(bits, range);
+}
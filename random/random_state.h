@@ -0,0 +1,74 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstdint>
+#include <type_traits>
+
+/*
+ * Sink of generator state (e.g. simulation checkpoint); the state consists of integral and floating-point values
+ */
+class random_state_sink
+{
+    public:
+        virtual ~random_state_sink() { };
+
+        // writes integral value of state
+        virtual void write_state(uint64_t value) = 0;
+        // writes floating-point value of state
+        virtual void write_state(double value) = 0;
+};
+
+/*
+ * Source of generator state written by random_state_sink
+ */
+class random_state_source
+{
+    public:
+        virtual ~random_state_source() { };
+
+        // reads integral value of state; returns false, if there's nothing to read
+        virtual bool read_state(uint64_t& value) = 0;
+        // reads floating-point value of state; returns false, if there's nothing to read
+        virtual bool read_state(double& value) = 0;
+};
+
+// writes value of arbitrary arithmetic type to state sink
+template<typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value>::type random_write_state(random_state_sink& sink, T value)
+{
+    sink.write_state(static_cast<double>(value));
+}
+
+template<typename T>
+inline typename std::enable_if<!std::is_floating_point<T>::value>::type random_write_state(random_state_sink& sink, T value)
+{
+    sink.write_state(static_cast<uint64_t>(value));
+}
+
+// reads value of arbitrary arithmetic type from state source
+template<typename T>
+inline typename std::enable_if<std::is_floating_point<T>::value, bool>::type random_read_state(random_state_source& source, T& value)
+{
+    double stored;
+    if (!source.read_state(stored))
+        return false;
+
+    value = static_cast<T>(stored);
+    return true;
+}
+
+template<typename T>
+inline typename std::enable_if<!std::is_floating_point<T>::value, bool>::type random_read_state(random_state_source& source, T& value)
+{
+    uint64_t stored;
+    if (!source.read_state(stored))
+        return false;
+
+    value = static_cast<T>(stored);
+    return true;
+}
@@ -0,0 +1,45 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+#pragma once
+
+#include <cstdint>
+
+/*
+ * Random streams of simulation objects
+ *
+ * Every stream is a counter-based engine keyed by (master seed, replication, logical process, stream id); the upper
+ * half of engine counter is the object GUID. Streams of distinct objects therefore never overlap, and the streams
+ * of distinct stream ids, logical processes or replications are independent
+ */
+
+// stream used by periodic schedule generator
+constexpr uint32_t random_stream_schedule = 0;
+// stream used by event target selection
+constexpr uint32_t random_stream_selection = 1;
+// first stream id available for user generators
+constexpr uint32_t random_stream_user = 16;
+
+// mixes bits of given number (finalizer of SplitMix64)
+inline uint64_t random_mix64(uint64_t x)
+{
+    x ^= x >> 30;
+    x *= 0xBF58476D1CE4E5B9ULL;
+    x ^= x >> 27;
+    x *= 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return x;
+}
+
+// derives engine key of stream; the partition (logical process) is included, since the GUIDs are unique only within
+// a single partition
+inline uint64_t random_stream_key(uint64_t masterSeed, uint64_t replication, uint32_t streamId, uint32_t partition = 0)
+{
+    uint64_t key = random_mix64(masterSeed + 0x9E3779B97F4A7C15ULL);
+    key = random_mix64(key ^ (replication + 0x632BE59BD9B4E019ULL));
+    key = random_mix64(key ^ (static_cast<uint64_t>(partition) + 0xD6E8FEB86659FD93ULL));
+    return random_mix64(key ^ (static_cast<uint64_t>(streamId) + 0x8CB92BA72F3D8DD7ULL));
+}
@@ -7,30 +7,100 @@
 #pragma once
 
 #include "base_generator.h"
+#include "random_block.h"
 
 /*
- * Uniform distribution generator (integers) with specified parameters
+ * Uniform distribution generator (integers) with specified parameters; raw random numbers are generated in blocks
+ * and mapped to the range without division. Ranges of at most 2^32 values need just 32 random bits per sample, so
+ * every raw number is split to two samples
  */
 template<typename T>
 class uniform_int_generator : public base_generator<T>
 {
     public:
-        uniform_int_generator(T minval, T maxval) : base_generator(), m_dist(minval, maxval) { };
+        uniform_int_generator(T minval, T maxval) : base_generator<T>(), m_half(0), m_hasHalf(false)
+        {
+            reinit(minval, maxval);
+        };
 
         virtual T operator()() override
         {
-            return static_cast<T>(m_dist(m_engine));
+            // the upper half of the last raw number is still unused
+            if (m_hasHalf)
+            {
+                m_hasHalf = false;
+                return static_cast<T>(static_cast<uint64_t>(m_min) + random_bounded_narrow(this->m_engine, m_half, m_range));
+            }
+
+            if (m_block.empty())
+            {
+                this->m_engine.generate(m_block.values, random_block_size);
+                m_block.position = 0;
+            }
+
+            const uint64_t bits = m_block.next();
+
+            if (m_range - 1 <= 0xFFFFFFFFULL)
+            {
+                m_half = static_cast<uint32_t>(bits >> 32);
+                m_hasHalf = true;
+                return static_cast<T>(static_cast<uint64_t>(m_min) + random_bounded_narrow(this->m_engine, static_cast<uint32_t>(bits), m_range));
+            }
+
+            return static_cast<T>(static_cast<uint64_t>(m_min) + random_bounded(this->m_engine, bits, m_range));
         }
 
         // reinitializes the distribution with new parameters
         virtual void reinit(T minval, T maxval)
         {
-            m_dist = std::uniform_int_distribution<T>(minval, maxval);
+            m_min = minval;
+            // the full 64-bit range overflows to zero, which is handled by the mapping
+            m_range = static_cast<uint64_t>(maxval) - static_cast<uint64_t>(minval) + 1;
+            // the unused half may be used only by narrow range
+            m_hasHalf = m_hasHalf && (m_range - 1 <= 0xFFFFFFFFULL);
+        }
+
+        virtual void seed(uint64_t key, uint64_t stream) override
+        {
+            base_generator<T>::seed(key, stream);
+            m_block.clear();
+            m_hasHalf = false;
+        }
+
+        virtual void save(random_state_sink& sink) const override
+        {
+            base_generator<T>::save(sink);
+            random_write_state(sink, m_min);
+            random_write_state(sink, m_range);
+            m_block.save(sink);
+            sink.write_state(m_hasHalf ? (static_cast<uint64_t>(1) << 32) | m_half : 0);
+        }
+
+        virtual bool load(random_state_source& source) override
+        {
+            if (!base_generator<T>::load(source) || !random_read_state(source, m_min) || !random_read_state(source, m_range))
+                return false;
+
+            uint64_t half;
+            if (!m_block.load(source) || !source.read_state(half))
+                return false;
+
+            m_hasHalf = (half >> 32) != 0;
+            m_half = static_cast<uint32_t>(half);
+            return true;
         }
 
     protected:
-        // encapsulated standard library distribution generator
-        std::uniform_int_distribution<T> m_dist;
+        // lower bound
+        T m_min;
+        // number of values in range
+        uint64_t m_range;
+        // pre-generated raw random numbers
+        random_block<uint64_t> m_block;
+        // unused upper half of the last raw number (narrow ranges only)
+        uint32_t m_half;
+        // is the upper half valid?
+        bool m_hasHalf;
 };
 
 /*
@@ -40,20 +110,50 @@ template<typename T>
 class uniform_real_generator : public base_generator<T>
 {
     public:
-        uniform_real_generator(T minval, T maxval) : base_generator(), m_dist(minval, maxval) { };
+        uniform_real_generator(T minval, T maxval) : base_generator<T>(), m_min(minval), m_width(maxval - minval) { };
 
         virtual T operator()() override
         {
-            return static_cast<T>(m_dist(m_engine));
+            if (m_block.empty())
+                random_fill_unit(this->m_engine, m_block);
+
+            return static_cast<T>(m_min + m_width * m_block.next());
         }
 
         // reinitializes the distribution with new parameters
         virtual void reinit(T minval, T maxval)
         {
-            m_dist = std::uniform_real_distribution<T>(minval, maxval);
+            m_min = minval;
+            m_width = maxval - minval;
+        }
+
+        virtual void seed(uint64_t key, uint64_t stream) override
+        {
+            base_generator<T>::seed(key, stream);
+            m_block.clear();
+        }
+
+        virtual void save(random_state_sink& sink) const override
+        {
+            base_generator<T>::save(sink);
+            random_write_state(sink, m_min);
+            random_write_state(sink, m_width);
+            m_block.save(sink);
+        }
+
+        virtual bool load(random_state_source& source) override
+        {
+            if (!base_generator<T>::load(source) || !random_read_state(source, m_min) || !random_read_state(source, m_width))
+                return false;
+
+            return m_block.load(source);
         }
 
     protected:
-        // encapsulated standard library distribution generator
-        std::uniform_real_distribution<T> m_dist;
+        // lower bound
+        T m_min;
+        // width of range
+        T m_width;
+        // pre-generated uniform samples in range [0; 1)
+        random_block<double, random_wide_block_size> m_block;
 };
@@ -8,5 +8,12 @@
 
 #include "Event.h"
 #include "Process.h"
+#include "CoroutineProcess.h"
 #include "Simulation.h"
+#include "StatisticRegistry.h"
 #include "Calendar.h"
+#include "HeapCalendar.h"
+#include "CalendarQueue.h"
+#include "TraceReader.h"
+#include "ReplicationRunner.h"
+#include "ParallelSimulation.h"
@@ -0,0 +1,162 @@
+/************************************************************
+ * SimLib simulation library for event-based simulations    *
+ * Author: Martin Ubl (A16N0026P)                           *
+ *         ublm@students.zcu.cz                             *
+ ************************************************************/
+
+/*
+ * Command line tool for binary event traces
+ *
+ * Build (from this directory):
+ *   g++ -std=c++14 -O2 -I.. simtrace.cpp ../TraceReader.cpp -o simtrace
+ *
+ * Usage:
+ *   simtrace <trace file> [--info] [--csv] [--from <time>] [--to <time>] [--class <class>] [--kind fired|added|removed]
+ *
+ * Without --csv, the trace summary is printed; with --csv, the records matching filters are printed as CSV.
+ * The --kind option may be used more times
+ */
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <cstdlib>
+
+#include "TraceReader.h"
+
+// names of event kinds
+static const char* const _kindNames[TraceEventKindCount] = { "fired", "added", "removed" };
+
+static void PrintUsage()
+{
+    std::cerr << "Usage: simtrace <trace file> [--info] [--csv] [--from <time>] [--to <time>] [--class <class>] [--kind fired|added|removed]" << std::endl;
+}
+
+static bool ParseNumber(const char* str, uint64_t& value)
+{
+    char* end = nullptr;
+    value = std::strtoull(str, &end, 10);
+    return end != str && *end == '\0';
+}
+
+static void PrintInfo(TraceReader const& reader, TraceFilter const& filter)
+{
+    std::cout << "Records: " << reader.GetRecordCount() << std::endl;
+    std::cout << "Chunks: " << reader.GetChunkCount() << std::endl;
+    if (reader.IsIndexRebuilt())
+        std::cout << "Index: rebuilt (trace was not closed properly)" << std::endl;
+
+    if (reader.GetChunkCount() > 0)
+    {
+        std::cout << "Time range: " << reader.GetChunk(0).header.firstTime << " - " << reader.GetChunk(reader.GetChunkCount() - 1).header.lastTime << std::endl;
+    }
+
+    uint64_t counts[TraceEventKindCount] = { 0 };
+    uint64_t matched = 0;
+    reader.ForEach(filter, [&](TraceRecord const& record) {
+        if (record.kind < TraceEventKindCount)
+            counts[record.kind]++;
+        matched++;
+    });
+
+    std::cout << "Matching records: " << matched << std::endl;
+    for (uint32_t i = 0; i < TraceEventKindCount; i++)
+        std::cout << "  " << _kindNames[i] << ": " << counts[i] << std::endl;
+}
+
+static void PrintCSV(TraceReader const& reader, TraceFilter const& filter)
+{
+    std::string line;
+
+    std::cout << "time,guid,type,class,kind\n";
+    reader.ForEach(filter, [&](TraceRecord const& record) {
+        line = std::to_string(record.time);
+        line += ',';
+        line += std::to_string(record.guid);
+        line += ',';
+        line += std::to_string(record.objectType);
+        line += ',';
+        line += std::to_string(record.objectClass);
+        line += ',';
+        line += (record.kind < TraceEventKindCount) ? _kindNames[record.kind] : "unknown";
+        line += '\n';
+        std::cout.write(line.data(), line.size());
+    });
+    std::cout.flush();
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 2)
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    TraceFilter filter;
+    bool csv = false;
+    uint32_t kindMask = 0;
+
+    for (int i = 2; i < argc; i++)
+    {
+        uint64_t value;
+
+        if (std::strcmp(argv[i], "--csv") == 0)
+            csv = true;
+        else if (std::strcmp(argv[i], "--info") == 0)
+            csv = false;
+        else if (std::strcmp(argv[i], "--from") == 0 && i + 1 < argc && ParseNumber(argv[i + 1], value))
+        {
+            filter.timeFrom = value;
+            i++;
+        }
+        else if (std::strcmp(argv[i], "--to") == 0 && i + 1 < argc && ParseNumber(argv[i + 1], value))
+        {
+            filter.timeTo = value;
+            i++;
+        }
+        else if (std::strcmp(argv[i], "--class") == 0 && i + 1 < argc && ParseNumber(argv[i + 1], value))
+        {
+            filter.filterClass = true;
+            filter.objectClass = static_cast<uint32_t>(value);
+            i++;
+        }
+        else if (std::strcmp(argv[i], "--kind") == 0 && i + 1 < argc)
+        {
+            uint32_t kind = 0;
+            while (kind < TraceEventKindCount && std::strcmp(argv[i + 1], _kindNames[kind]) != 0)
+                kind++;
+
+            if (kind == TraceEventKindCount)
+            {
+                std::cerr << "Unknown event kind: " << argv[i + 1] << std::endl;
+                return 1;
+            }
+
+            kindMask |= (1U << kind);
+            i++;
+        }
+        else
+        {
+            PrintUsage();
+            return 1;
+        }
+    }
+
+    if (kindMask != 0)
+        filter.kindMask = kindMask;
+
+    TraceReader reader;
+    if (!reader.Open(argv[1]))
+    {
+        std::cerr << "Could not open trace file " << argv[1] << std::endl;
+        return 1;
+    }
+
+    if (csv)
+        PrintCSV(reader, filter);
+    else
+        PrintInfo(reader, filter);
+
+    return 0;
+}